@@ -0,0 +1,95 @@
+// =========================================================================================
+//	AllocationHooks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Replaces the global operator new and delete with ones that count every allocation with
+// the AllocationTracker. This file is not part of the core library, it is only built into
+// the programs that count their allocations, and only replaces anything when they define
+// ALLOCATION_TRACKING_ON, so every other program keeps the standard operators.
+
+#include "StdAfx.h"
+#include "AllocationTracker.h"
+#include <new>
+
+#if ALLOCATION_TRACKING_ON
+
+// Allocates memory for operator new, counting it. Throws if there is none.
+static void* TrackedAllocate(size_t size)
+{
+	AllocationTracker::RecordAllocation(size);
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == NULL)
+		throw std::bad_alloc();
+	return memory;
+}
+
+// Frees memory for operator delete, counting it.
+static void TrackedFree(void* memory)
+{
+	if (memory == NULL)
+		return;
+	AllocationTracker::RecordFree();
+	free(memory);
+}
+
+// Replacements of the global operator new and delete, every form of them goes through the
+// two functions above.
+void* operator new(size_t size)
+{
+	return TrackedAllocate(size);
+}
+void* operator new[](size_t size)
+{
+	return TrackedAllocate(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return TrackedAllocate(size);
+	}
+	catch (...)
+	{
+		return NULL;
+	}
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return TrackedAllocate(size);
+	}
+	catch (...)
+	{
+		return NULL;
+	}
+}
+void operator delete(void* memory) noexcept
+{
+	TrackedFree(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+	TrackedFree(memory);
+}
+void operator delete(void* memory, size_t) noexcept
+{
+	TrackedFree(memory);
+}
+void operator delete[](void* memory, size_t) noexcept
+{
+	TrackedFree(memory);
+}
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	TrackedFree(memory);
+}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	TrackedFree(memory);
+}
+
+#endif
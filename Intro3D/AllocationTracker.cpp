@@ -0,0 +1,154 @@
+// =========================================================================================
+//	AllocationTracker.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "AllocationTracker.h"
+#include <atomic>
+
+// Clears every count.
+void AllocationCounts::Reset()
+{
+	allocations = 0;
+	frees = 0;
+	bytes = 0;
+}
+
+// Adds another set of counts to these.
+void AllocationCounts::Add(const AllocationCounts& counts)
+{
+	allocations += counts.allocations;
+	frees += counts.frees;
+	bytes += counts.bytes;
+}
+
+// Takes the counts of an earlier read away from these, leaving the counts in between.
+void AllocationCounts::Subtract(const AllocationCounts& counts)
+{
+	allocations -= counts.allocations;
+	frees -= counts.frees;
+	bytes -= counts.bytes;
+}
+
+// Counts of the calling thread. Plain data, so it needs no constructing before the first
+// allocation the thread makes.
+static thread_local AllocationCounts ThreadAllocationCounts;
+static thread_local bool ThreadAllocationsExempt = false;
+
+// Counts across all threads.
+static std::atomic<unsigned long long> TotalAllocations(0);
+static std::atomic<unsigned long long> TotalFrees(0);
+static std::atomic<unsigned long long> TotalBytes(0);
+
+// Frame state, only used by the thread rendering the frames. Allocations abort while
+// AllocationsForbidden is set, on any thread.
+static unsigned int AllocationFrame = 0;
+static AllocationCounts AllocationFrameStart;
+static AllocationCounts AllocationFrameCounts;
+static unsigned int AllocatingFrameCount = 0;
+static bool SteadyStateCheckOn = false;
+static std::atomic<bool> AllocationsForbidden(false);
+
+// Returns the counts of the calling thread, since it started.
+void AllocationTracker::GetThreadCounts(AllocationCounts& counts)
+{
+	counts = ThreadAllocationCounts;
+}
+
+// Returns the counts across all threads, since the program started.
+void AllocationTracker::GetTotalCounts(AllocationCounts& counts)
+{
+	counts.allocations = TotalAllocations.load(std::memory_order_relaxed);
+	counts.frees = TotalFrees.load(std::memory_order_relaxed);
+	counts.bytes = TotalBytes.load(std::memory_order_relaxed);
+}
+
+// Returns the number of allocations the calling thread has made, read by each profile scope.
+unsigned long long AllocationTracker::GetThreadAllocations()
+{
+	return ThreadAllocationCounts.allocations;
+}
+
+// Starts counting the allocations of a new frame, forbidding them if the steady state
+// check is on and the frame is past the warm up.
+void AllocationTracker::BeginFrame()
+{
+	AllocationFrame++;
+	GetTotalCounts(AllocationFrameStart);
+	if (SteadyStateCheckOn == true && AllocationFrame > ALLOCATION_WARMUP_FRAMES)
+		AllocationsForbidden = true;
+}
+
+// Finishes the frame, working out the allocations made in it.
+void AllocationTracker::EndFrame()
+{
+	AllocationsForbidden = false;
+	GetTotalCounts(AllocationFrameCounts);
+	AllocationFrameCounts.Subtract(AllocationFrameStart);
+	if (AllocationFrame > ALLOCATION_WARMUP_FRAMES && AllocationFrameCounts.allocations > 0)
+		AllocatingFrameCount++;
+}
+
+// Returns the number of the current frame, the first frame is frame 1.
+unsigned int AllocationTracker::GetFrame()
+{
+	return AllocationFrame;
+}
+
+// Returns the counts of the last frame finished, across all threads.
+const AllocationCounts& AllocationTracker::GetFrameCounts()
+{
+	return AllocationFrameCounts;
+}
+
+// Returns the number of frames after the warm up that allocated.
+unsigned int AllocationTracker::GetAllocatingFrameCount()
+{
+	return AllocatingFrameCount;
+}
+
+// Turns the steady state check on or off, from the next frame.
+void AllocationTracker::SetSteadyStateCheckOn(bool val)
+{
+	SteadyStateCheckOn = val;
+}
+bool AllocationTracker::GetSteadyStateCheckOn()
+{
+	return SteadyStateCheckOn;
+}
+
+// Exempts the allocations of the calling thread from the steady state check, or stops
+// exempting them.
+void AllocationTracker::SetThreadExempt(bool val)
+{
+	ThreadAllocationsExempt = val;
+}
+
+// Counts an allocation on the calling thread. Fails if allocations are forbidden, after
+// lifting the check so the message can be written.
+void AllocationTracker::RecordAllocation(size_t size)
+{
+	ThreadAllocationCounts.allocations++;
+	ThreadAllocationCounts.bytes += size;
+	TotalAllocations.fetch_add(1, std::memory_order_relaxed);
+	TotalBytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (AllocationsForbidden.load(std::memory_order_relaxed) == true && ThreadAllocationsExempt == false &&
+		AllocationsForbidden.exchange(false) == true)
+	{
+		fprintf(stderr, "Allocation of %u bytes in steady state frame %u, after %u warm up frames.\n",
+				(unsigned int)size, AllocationFrame, (unsigned int)ALLOCATION_WARMUP_FRAMES);
+		fflush(stderr);
+		abort();
+	}
+}
+
+// Counts a free on the calling thread.
+void AllocationTracker::RecordFree()
+{
+	ThreadAllocationCounts.frees++;
+	TotalFrees.fetch_add(1, std::memory_order_relaxed);
+}
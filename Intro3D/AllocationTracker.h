@@ -0,0 +1,66 @@
+// =========================================================================================
+//	AllocationTracker.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include <stddef.h>
+
+// Defined to true by the builds that count allocations, which compiles the replacements of
+// the global operator new and delete in AllocationHooks.cpp. Otherwise the standard ones
+// are used and every count is 0. See INTRO3D_ALLOCATION_TRACKING in CMakeLists.txt.
+#ifndef ALLOCATION_TRACKING_ON
+#define ALLOCATION_TRACKING_ON		false
+#endif
+
+// Frames rendered before the steady state check starts. The first frames fill the buffer
+// pools and grow the lists to the size the scene needs.
+#define ALLOCATION_WARMUP_FRAMES	4
+
+// Allocations counted on a thread or across all of them.
+struct AllocationCounts
+{
+	unsigned long long allocations;
+	unsigned long long frees;
+	unsigned long long bytes;			// Bytes allocated, frees are not taken off.
+
+	void Reset();
+	void Add(const AllocationCounts& counts);
+	void Subtract(const AllocationCounts& counts);
+};
+
+// This class counts the allocations made with new and delete, on each thread and across
+// all of them, and the allocations made in each frame. Only programs built with
+// AllocationHooks.cpp and ALLOCATION_TRACKING_ON count anything. The profiler counts the
+// allocations made in each stage the same way, see Profiler::GetStageAllocations. Memory
+// the C runtime or the platform allocates for itself, such as GDI+ objects on Windows, is
+// not counted.
+//
+// With the steady state check on, any allocation in a frame after the first
+// ALLOCATION_WARMUP_FRAMES prints its size and the frame and aborts, so a debugger stops
+// at the code that allocated. A frame is from BeginFrame to EndFrame, which are called by
+// Profiler::BeginFrame and Profiler::EndFrame whether or not the profiler is enabled.
+// A thread can be made exempt from the check while it sets itself up, its allocations are
+// still counted.
+class AllocationTracker
+{
+	public:
+		static void GetThreadCounts(AllocationCounts& counts);
+		static void GetTotalCounts(AllocationCounts& counts);
+		static unsigned long long GetThreadAllocations();
+
+		static void BeginFrame();
+		static void EndFrame();
+		static unsigned int GetFrame();
+		static const AllocationCounts& GetFrameCounts();
+		static unsigned int GetAllocatingFrameCount();
+
+		static void SetSteadyStateCheckOn(bool val);
+		static bool GetSteadyStateCheckOn();
+		static void SetThreadExempt(bool val);
+
+		static void RecordAllocation(size_t size);
+		static void RecordFree();
+};
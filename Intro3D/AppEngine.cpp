@@ -7,7 +7,10 @@
 
 #include "StdAfx.h"
 #include "AppEngine.h"
+#include "WindowPresenter.h"
+#include "NullPresenter.h"
 #include <cmath>
+#include <chrono>
 #include <windows.h>
 
 // Initialize display mode array here as it causes multiple definition linker errors in header file.
@@ -34,9 +37,17 @@ const WCHAR* DisplayModeNames[] =
 AppEngine::AppEngine(void)
 {
 	_rasterizer = NULL;
+	_swapChain = NULL;
+	_presenter = NULL;
+	_renderThreadOn = RENDER_THREAD_ON;
+	_renderThreadStop = false;
 	_model1 = NULL;
 	_model2 = NULL;
 	_camera = NULL;
+	_scene = NULL;
+	_renderQueue = NULL;
+	_jobSystem = NULL;
+	_capture = NULL;
 }
 
 // Destructor.
@@ -69,6 +80,21 @@ void AppEngine::Initialise(HWND hWnd)
 		height = 480;
 	}
 	_rasterizer = new Rasterizer((unsigned int)width, (unsigned int)height);
+	_rasterizer->SetFastClearOn(FAST_CLEAR_ON);
+	_rasterizer->SetDebugView(DEBUG_VIEW);
+	Profiler::SetEnabled(PROFILER_ON);
+	AllocationTracker::SetSteadyStateCheckOn(ALLOCATION_CHECK_ON);
+
+	// Frames are rendered into the swap chain and presented to the window, or thrown away
+	// if there is no window and no other presenter has been set.
+	_swapChain = new SwapChain((unsigned int)width, (unsigned int)height);
+	if (_presenter == NULL)
+	{
+		if (_hWnd != NULL)
+			_presenter = new WindowPresenter(_hWnd);
+		else
+			_presenter = new NullPresenter();
+	}
 
 	// Load a model 1 (our character).
 	_model1 = new Model3D();
@@ -81,6 +107,18 @@ void AppEngine::Initialise(HWND hWnd)
 	_model2 = new Model3D();
 	result = MD2Loader::LoadModel("grass.md2", *_model2, "grass.pcx");
 
+	// Build the colormap tables used for textured shading.
+	_model1->BuildColormap(COLORMAP_LIGHT_LEVELS, COLORMAP_COLORED_LIGHT);
+	_model1->SetColormapOn(COLORMAP_ON);
+	_model2->BuildColormap(COLORMAP_LIGHT_LEVELS, COLORMAP_COLORED_LIGHT);
+	_model2->SetColormapOn(COLORMAP_ON);
+
+	// Place the models in the scene, their transforms are animated each frame.
+	_scene = new Scene();
+	_model2Instance = _scene->AddInstance(_model2, Matrix3D::IdentityMatrix());
+	_model1Instance = _scene->AddInstance(_model1, Matrix3D::IdentityMatrix());
+	_scene->GetInstance(_model2Instance)->SetRenderLayer(RenderLayerBackground);
+
 	// Make a new camera.
 	_camera = new Camera(0, 0, 0, Vertex(0, 50, -100, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0), 640, 480);
 
@@ -109,6 +147,28 @@ void AppEngine::Initialise(HWND hWnd)
 //	_spotLight->SetPosition(Vertex(-500, 150, 10, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0));
 //	_spotLightList.push_back(_spotLight);
 
+	// Tell the rasterizer which lights the normal mapped kernels use.
+	_rasterizer->SetLights(_directionalLightList, _ambientLightList, _pointLightList);
+
+	// Make the render queue the instances in view are drawn through.
+	_renderQueue = new RenderQueue();
+	_renderQueue->SetLights(_directionalLightList, _ambientLightList, _pointLightList, _spotLightList);
+
+	// Make the workers the instances geometry is processed on.
+	_jobSystem = new JobSystem(JOB_WORKER_COUNT);
+	_renderQueue->SetJobSystem(_jobSystem);
+	_renderQueue->SetPipelineOn(RENDER_PIPELINE_ON);
+
+	// Record the frames with the files the models were loaded from.
+	if (FRAME_CAPTURE_ON == true)
+	{
+		_capture = new FrameCapture();
+		_capture->AddModel(_model1, "baron.md2", "baron.pcx", "baron_nm.pcx");
+		_capture->AddModel(_model2, "grass.md2", "grass.pcx", NULL);
+		_capture->SetLights(_directionalLightList, _ambientLightList, _pointLightList);
+		_capture->Open(FRAME_CAPTURE_FILE, (unsigned int)width, (unsigned int)height);
+	}
+
 	// Sets up the scene for a given display mode.
 	_displayMode = 0;
 	_displayModeTimer = GetTickCount() + DISPLAY_MODE_DURATION;
@@ -118,18 +178,51 @@ void AppEngine::Initialise(HWND hWnd)
 	_scale = 1.0f;
 	_scaleDir = false;
 	_angle = 0.0f;
+
+	// Start rendering frames.
+	if (_renderThreadOn == true)
+	{
+		_renderThreadStop = false;
+		_renderThread = std::thread(&AppEngine::RenderThreadMain, this);
+	}
+}
+
+// Sets the presenter the frames are shown by, must be called before Initialise. The app
+// engine deletes the presenter when it shuts down.
+void AppEngine::SetPresenter(Presenter* presenter)
+{
+	if (_presenter)
+		delete _presenter;
+	_presenter = presenter;
 }
 
 // This method does and updates and processing for the current frame.
 void AppEngine::Process(void)
 {
-	// At the moment, all we do is render a new image. In the future, we might do more here
-	Render();
+	// Without a render thread, render the frame here first.
+	if (_renderThreadOn == false)
+		Render();
+
+	// Present the latest frame the renderer has completed, if it has completed a new one.
+	// The renderer never waits for this, frames it completes in between are dropped.
+	if (_swapChain->AcquireFrame() == true)
+		_presenter->Present(_swapChain->GetPresentBitmap());
+	else if (_renderThreadOn == true)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// Main loop of the render thread.
+void AppEngine::RenderThreadMain(void)
+{
+	while (_renderThreadStop == false)
+		Render();
 }
 
 // This method renders the current frame to the window.
 void AppEngine::Render(void)
 {
+	Profiler::BeginFrame();
+
 	// Cycle through the display modes after every DISPLAY_MODE_DURATION ticks.
 	if (GetTickCount() >= _displayModeTimer)
 	{
@@ -159,117 +252,109 @@ void AppEngine::Render(void)
 			_scaleDir = !_scaleDir;
 	}
 	
-	// Begin rendering frame.
+	// Begin rendering frame, into the swap chain buffer the presenter is not using.
+	_rasterizer->SetRenderTarget(_swapChain->GetRenderBitmap(), _swapChain->GetRenderGraphics());
 	_rasterizer->BeginLockBits();
-	_rasterizer->ResetPolygonsRendered();
+	_rasterizer->ResetStats();
+	_rasterizer->ResetSetupBytesWritten();
 
 	// Clear the window.
-	_rasterizer->Clear(Color::SteelBlue);
+	{
+		PROFILE_SCOPE(ProfileStageClear);
+		_rasterizer->Clear(Color::SteelBlue);
+	}
 	
-	// Render each of the models using a translation, scale and rotation 
+	// Move each of the models using a translation, scale and rotation 
 	// matrix (depending on how we are animating them).
-	RenderModel(_model2, Matrix3D::ScaleMatrix(_scale, _scale, _scale)	* Matrix3D::TranslateMatrix(0, -50, 150));
-	RenderModel(_model1, Matrix3D::RotateMatrix(0, _angle, 0)			* Matrix3D::TranslateMatrix(0, 0, 30));
+	{
+		PROFILE_SCOPE(ProfileStageScene);
+		_scene->SetInstanceTransform(_model2Instance, Matrix3D::ScaleMatrix(_scale, _scale, _scale)	* Matrix3D::TranslateMatrix(0, -50, 150));
+		_scene->SetInstanceTransform(_model1Instance, Matrix3D::RotateMatrix(0, _angle, 0)			* Matrix3D::TranslateMatrix(0, 0, 30));
+		_scene->Update();
+		_scene->QueryFrustum(_camera, _visibleInstances);
+
+		if (_capture != NULL)
+			_capture->WriteFrame((DisplayMode)_displayMode, _camera, _scene);
+	}
+
+	// Submit each of the instances in view to the render queue, which sorts and draws them.
+	{
+		PROFILE_SCOPE(ProfileStageSubmit);
+		_renderQueue->Begin(_camera, _rasterizer);
+		for (unsigned int i = 0; i < _visibleInstances.size(); i++)
+			_renderQueue->Submit(_visibleInstances[i], (DisplayMode)_displayMode);
+	}
+	_renderQueue->Execute();
+
+	// Draw the debug view over the frame, before the text goes on top of it.
+	_rasterizer->DrawDebugView();
 	
-	// Convert the fps/polygons value to a renderable string.
-	WCHAR convertArray[256];
-	WSTRING fpsString = L"FPS: ";
-	wsprintf(convertArray, L"%i", _fps);
-	fpsString += WSTRING(convertArray);
+	// Convert the fps/polygons value to a renderable string. The strings are written into
+	// buffers on the stack so drawing them allocates nothing.
+	WCHAR fpsString[256];
+	wsprintf(fpsString, L"FPS: %i", _fps);
+
+	// Stats of the geometry processed and the pixels drawn this frame.
+	RenderStats stats = _renderQueue->GetStats();
+	stats.Add(_rasterizer->GetStats());
+
+	WCHAR polysString[256];
+	wsprintf(polysString, L"Triangles: %u of %u drawn", stats.trianglesRasterized, stats.trianglesSubmitted);
+
+	WCHAR culledString[256];
+	wsprintf(culledString, L"Culled: %u backface, %u frustum, %u zero area, %u clipped", stats.trianglesBackfaceCulled,
+			 stats.trianglesFrustumCulled, stats.trianglesZeroArea, stats.trianglesClipped);
 
-	WSTRING polysString = L"Polygons: ";
-	wsprintf(convertArray, L"%i", _rasterizer->GetPolygonsRendered());
-	polysString += WSTRING(convertArray);
+	WCHAR pixelsString[256];
+	wsprintf(pixelsString, L"Pixels: %u shaded, %u written, %u texels, %u lights", (unsigned int)stats.pixelsShaded,
+			 (unsigned int)stats.pixelsWritten, (unsigned int)stats.texelsFetched, (unsigned int)stats.lightsEvaluated);
+
+	// Average number of bytes written to the scanline buffers setting up each polygon.
+	unsigned int polygonsRendered = stats.trianglesRasterized;
+	WCHAR setupString[256];
+	wsprintf(setupString, L"Setup Bytes/Polygon: %i", polygonsRendered > 0 ? _rasterizer->GetSetupBytesWritten() / polygonsRendered : 0);
 
 	// Draw the description of the current mode.
 	_rasterizer->DrawText(10, 10, L"Software Rasterizer");
 	_rasterizer->DrawText(10, 30, L"Timothy Leonard (100119086)");
-	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 67), fpsString.c_str());
-	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 47), polysString.c_str());
+	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 127), fpsString);
+	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 107), setupString);
+	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 87), polysString);
+	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 67), culledString);
+	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 47), pixelsString);
 	_rasterizer->DrawText(10, (float)(_rasterizer->GetHeight() - 27), DisplayModeNames[_displayMode]);
 	
-	// Finish rendering frame.
+	// Finish rendering frame, and hand it to the presenter.
 	_rasterizer->FinishLockBits();
-	
-	// Ensure that Windows is told that the contents of the window now needs painting
-	InvalidateRect(_hWnd, NULL, FALSE);
+	_swapChain->CompleteFrame();
 
 	// Track number of frames per second.
 	TrackFPS();
+	Profiler::EndFrame();
 }
 
-// This method will render the model with a given transformation matrix.
-void AppEngine::RenderModel(Model3D* model, Matrix3D transformMatrix)
-{
-	model->ApplyTransformToLocalVertices(transformMatrix);
-	model->CalculateBackfaces(_camera);
-	model->CalculateVertexNormals();
-	model->ResetLighting();
-
-	// Calculate lighting.
-	model->CalculateLightingAmbient(_ambientLightList);
-	model->CalculateLightingDirectional(_directionalLightList);
-	model->CalculateLightingPoint(_pointLightList);
-	model->CalculateLightingSpot(_spotLightList);
-
-	// Apply the viewport matrix.
-	model->ApplyTransformToTransformedVertices(_camera->GetViewportMatrix());
-	model->DepthSort();
-
-	// Apply the perspective matrix.
-	model->ApplyTransformToTransformedVertices(_camera->GetPerspectiveMatrix());
-	model->DehomogenizeTransformedVertices();
-	
-	// Apply the screen matrix, converting the vertexs to screen space.
-	model->ApplyTransformToTransformedVertices(_camera->GetScreenMatrix());
-
-	// Render differently depending on the current display mode.
-	switch ((DisplayMode)_displayMode)
-	{
-	case WireFrame:
-		_rasterizer->DrawWireFrame(*model);
-		break;
-
-	case FlatShadedUnlit:
-	case FlatShadedAmbient:
-	case FlatShadedDirectionalAmbient:
-	case FlatShadedDirectionalPointAmient:
-		_rasterizer->DrawSolidFlat(*model);
-		break;
-
-	case GouraudShadedUnlit:
-	case GouraudShadedAmbient:
-	case GouraudShadedDirectionalAmbient:
-	case GouraudShadedDirectionalPointAmient:
-		_rasterizer->DrawSolidShaded(*model);
-		break;
-
-	case TexturedUnlit:
-	case TexturedAmbient:
-	case TexturedDirectionalAmbient:
-	case TexturedNormalMappedDirectionalAmbient:
-	case TexturedDirectionalPointAmbient:
-	case TexturedNormalMappedDirectionalPointAmbient:
-		//_rasterizer->DrawSolidTextured(*model);
-		_rasterizer->DrawSolidTexturedNormalMapped(*model, _directionalLightList, _ambientLightList, _pointLightList);
-		break;
-	}
-}
-
-// This method paints the rasterizers bitmap to the windows device context.
+// This method paints the last presented frame to the windows device context.
 void AppEngine::Paint(HDC hdc)
 {
-	// Copy the contents of the rasterizer's bitmap to our window
-	if (_rasterizer)
+	// Copy the contents of the present buffer to our window, the renderer never
+	// writes to it so this is safe while the next frame is being rendered.
+	if (_swapChain)
 	{
 		Graphics graphics(hdc);
-		graphics.DrawImage(_rasterizer->GetBitmap(), 0, 0, _rasterizer->GetWidth(), _rasterizer->GetHeight());
+		graphics.DrawImage(_swapChain->GetPresentBitmap(), 0, 0, _rasterizer->GetWidth(), _rasterizer->GetHeight());
 	}
 }
 
 // This method shuts down the application and disposes of all allocated resources.
 void AppEngine::Shutdown(void)
 {
+	// Stop the render thread first, it uses everything below.
+	if (_renderThread.joinable() == true)
+	{
+		_renderThreadStop = true;
+		_renderThread.join();
+	}
+
 	// Clean up lights.
 	//for (int i = 0; i < _directionalLightList.size(); i++)
 	//	delete _directionalLightList[i];
@@ -278,6 +363,34 @@ void AppEngine::Shutdown(void)
 	//for (int i = 0; i < _pointLightList.size(); i++)
 	//	delete _pointLightList[i];
 
+	// Close the capture.
+	if (_capture)
+	{
+		delete _capture;
+		_capture = NULL;
+	}
+
+	// Clean up the scene, before the models its instances use.
+	if (_scene)
+	{
+		delete _scene;
+		_scene = NULL;
+	}
+
+	// Clean up the render queue.
+	if (_renderQueue)
+	{
+		delete _renderQueue;
+		_renderQueue = NULL;
+	}
+
+	// Stop the workers.
+	if (_jobSystem)
+	{
+		delete _jobSystem;
+		_jobSystem = NULL;
+	}
+
 	// Clean up models.
 	if (_model1)
 	{
@@ -303,6 +416,16 @@ void AppEngine::Shutdown(void)
 		delete _rasterizer;
 		_rasterizer = NULL;
 	}
+	if (_swapChain)
+	{
+		delete _swapChain;
+		_swapChain = NULL;
+	}
+	if (_presenter)
+	{
+		delete _presenter;
+		_presenter = NULL;
+	}
 }
 
 // This method is used to enable & disable lights depending on the current display mode of the demo.
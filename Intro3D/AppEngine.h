@@ -10,35 +10,60 @@
 #include "Model3D.h"
 #include "Camera.h"
 #include "Light.h"
+#include "Scene.h"
+#include "RenderQueue.h"
+#include "SwapChain.h"
+#include "Presenter.h"
+#include "DisplayMode.h"
+#include "FrameCapture.h"
 #include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
 
-// Enumeration of every display mode show in the demonstration.
-enum DisplayMode
-{
-	WireFrame,
-	FlatShadedUnlit,
-	FlatShadedAmbient,
-	FlatShadedDirectionalAmbient,
-	FlatShadedDirectionalPointAmient,
-	GouraudShadedUnlit,
-	GouraudShadedAmbient,
-	GouraudShadedDirectionalAmbient,
-	GouraudShadedDirectionalPointAmient,
-	TexturedUnlit,
-	TexturedAmbient,
-	TexturedDirectionalAmbient,
-	TexturedNormalMappedDirectionalAmbient,
-	TexturedDirectionalPointAmbient,
-	TexturedNormalMappedDirectionalPointAmbient
-};
-
-// Constants the define how fast and what display modes the demo should play.
-#define DISPLAY_MODE_COUNT		15
+// Constants the define how fast the demo should play the display modes.
 #define DISPLAY_MODE_DURATION	3000
 
-// Custom data type used when converting integers to wide strings.
-typedef std::basic_string<WCHAR> WSTRING;
+// Only fills the parts of the cleared frame that nothing is drawn over.
+#define FAST_CLEAR_ON			true
+
+// Colormap shading settings for textured modes. Set COLORMAP_ON to true to shade each
+// pixel with a lookup of its light quantised to COLORMAP_LIGHT_LEVELS levels, rather than
+// the full multiply and clamp. The quantising changes the shading slightly, so it is off
+// by default.
+#define COLORMAP_ON				false
+#define COLORMAP_LIGHT_LEVELS	64
+#define COLORMAP_COLORED_LIGHT	true
+
+// Number of workers the geometry of each frame is processed on, 0 uses one for each 
+// hardware thread and 1 processes it all on the main thread.
+#define JOB_WORKER_COUNT		0
+
+// Processes the geometry of each frame while the frame before is drawn. Raises the frame
+// rate when there are workers to spare, but the image shown is always a frame behind.
+#define RENDER_PIPELINE_ON		false
+
+// Renders frames on a thread of their own into a triple buffered swap chain, the main 
+// thread only presents the latest completed frame. Set to false to render each frame
+// on the main thread before presenting it.
+#define RENDER_THREAD_ON		true
+
+// Records how long each stage of each frame takes, see Profiler.
+#define PROFILER_ON				false
+
+// Aborts if a frame allocates once the first few have been rendered, see AllocationTracker.
+// Only works when ALLOCATION_TRACKING_ON is defined to true in the project settings, which
+// builds in the operator new and delete replacements of AllocationHooks.cpp.
+#define ALLOCATION_CHECK_ON		false
+
+// Debug view drawn over every frame, DebugViewOverdraw or DebugViewTileCost show where
+// the pixel work of the frame goes.
+#define DEBUG_VIEW				DebugViewNone
+
+// Records what every frame is rendered from to FRAME_CAPTURE_FILE, so a slow frame can be
+// rendered again with Intro3DRender --replay without the window or the animation.
+#define FRAME_CAPTURE_ON		false
+#define FRAME_CAPTURE_FILE		"capture.i3dc"
 
 // This is the AppEngine class it's responsible for updating
 // and rendering the the main demonstration mode.
@@ -53,10 +78,19 @@ class AppEngine
 		void Paint(HDC hdc);
 		void Shutdown(void);
 
+		void SetPresenter(Presenter* presenter);
+
 	private:
 		HWND _hWnd;
 		Rasterizer * _rasterizer;
 
+		// Frames are rendered into the swap chain and shown by the presenter.
+		SwapChain* _swapChain;
+		Presenter* _presenter;
+		bool _renderThreadOn;
+		std::thread _renderThread;
+		std::atomic<bool> _renderThreadStop;
+
 		// Lighting lists.
 		std::vector<DirectionalLight*> _directionalLightList;		
 		std::vector<AmbientLight*> _ambientLightList;
@@ -75,12 +109,21 @@ class AppEngine
 		Model3D* _model1;
 		Model3D* _model2;
 		Camera* _camera;
+		Scene* _scene;
+		int _model1Instance;
+		int _model2Instance;
+		std::vector<ModelInstance*> _visibleInstances;
+		RenderQueue* _renderQueue;
+		JobSystem* _jobSystem;
 		DirectionalLight* _directionalLight;
 		AmbientLight* _ambientLight;
 		AmbientLight* _unlitAmbientLight;
 		PointLight* _pointLight;
 		SpotLight* _spotLight;
 
+		// Capture the frames are recorded to, if FRAME_CAPTURE_ON.
+		FrameCapture* _capture;
+
 		// Scale and angle variables.
 		float _scale;
 		bool _scaleDir;
@@ -88,7 +131,7 @@ class AppEngine
 
 		// Private methods.
 		void Render(void);
-		void RenderModel(Model3D* model, Matrix3D transformMatrix);
+		void RenderThreadMain(void);
 		void SetDisplayMode(DisplayMode mode);
 		void TrackFPS();
 };
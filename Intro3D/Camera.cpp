@@ -20,6 +20,7 @@ Camera::Camera(float xRotation, float yRotation, float zRotation,
 	_position = position;
 	_viewWidth = viewWidth;
 	_viewHeight = viewHeight;
+	_nearPlane = CAMERA_NEAR_PLANE;
 	RebuildMatrices();
 }
 
@@ -74,6 +75,60 @@ void Camera::GetViewSize(unsigned int& viewWidth, unsigned int& viewHeight)
 	viewWidth = _viewWidth;
 	viewHeight = _viewHeight;
 }
+void Camera::SetNearPlane(float nearPlane)
+{
+	_nearPlane = nearPlane;
+	RebuildMatrices();
+}
+float Camera::GetNearPlane()
+{
+	return _nearPlane;
+}
+const FrustumPlane& Camera::GetFrustumPlane(int index)
+{
+	return _frustumPlanes[index];
+}
+
+// Tests a bounding sphere in world space against the view frustum.
+FrustumTest Camera::TestSphere(const Vector3D& center, float radius)
+{
+	FrustumTest result = FrustumInside;
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		const FrustumPlane& plane = _frustumPlanes[i];
+		float distance = Vector3D::DotProduct(plane.normal, center) + plane.distance;
+
+		if (distance < -radius)
+			return FrustumOutside;
+		if (distance < radius)
+			result = FrustumIntersecting;
+	}
+	return result;
+}
+
+// Tests an axis aligned bounding box in world space against the view frustum.
+FrustumTest Camera::TestAABB(const Vector3D& min, const Vector3D& max)
+{
+	FrustumTest result = FrustumInside;
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		const FrustumPlane& plane = _frustumPlanes[i];
+
+		// Work out the corners of the box furthest inside and furthest outside the plane.
+		Vector3D inside = Vector3D(plane.normal.GetX() >= 0 ? max.GetX() : min.GetX(),
+								   plane.normal.GetY() >= 0 ? max.GetY() : min.GetY(),
+								   plane.normal.GetZ() >= 0 ? max.GetZ() : min.GetZ());
+		Vector3D outside = Vector3D(plane.normal.GetX() >= 0 ? min.GetX() : max.GetX(),
+									plane.normal.GetY() >= 0 ? min.GetY() : max.GetY(),
+									plane.normal.GetZ() >= 0 ? min.GetZ() : max.GetZ());
+
+		if (Vector3D::DotProduct(plane.normal, inside) + plane.distance < 0)
+			return FrustumOutside;
+		if (Vector3D::DotProduct(plane.normal, outside) + plane.distance < 0)
+			result = FrustumIntersecting;
+	}
+	return result;
+}
 
 // This method rebuilds the viewport, perspective and screen matrices, ready 
 // to be used during rendering.
@@ -123,4 +178,43 @@ void Camera::RebuildMatrices()
 							 0, (float)(-(_viewHeight / 2)), 0, (float)(_viewHeight / 2), 
 							 0, 0, 1, 0,
 							 0, 0, 0, 1);
+
+	RebuildFrustumPlanes();
+}
+
+// Works out the world space planes of the view frustum from the rows of the combined
+// viewport and perspective matrix. A point is inside the frustum when -w <= x <= w, 
+// -w <= y <= w and near <= w, and its depth is no further than the far plane.
+void Camera::RebuildFrustumPlanes()
+{
+	Matrix3D clip = _viewportMatrix * _perspectiveMatrix;
+
+	float planes[FRUSTUM_PLANE_COUNT][4];
+	for (int i = 0; i < 4; i++)
+	{
+		float x = clip.GetElement(0, i);
+		float y = clip.GetElement(1, i);
+		float z = clip.GetElement(2, i);
+		float w = clip.GetElement(3, i);
+
+		planes[FrustumPlaneLeft][i]		= w + x;
+		planes[FrustumPlaneRight][i]	= w - x;
+		planes[FrustumPlaneBottom][i]	= w + y;
+		planes[FrustumPlaneTop][i]		= w - y;
+		planes[FrustumPlaneNear][i]		= w;
+		planes[FrustumPlaneFar][i]		= -z;
+	}
+	planes[FrustumPlaneNear][3] -= _nearPlane;
+	planes[FrustumPlaneFar][3] += CAMERA_FAR_PLANE;
+
+	// Normalize the planes so tests against them give true distances.
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		Vector3D normal = Vector3D(planes[i][0], planes[i][1], planes[i][2]);
+		float length = normal.GetLength();
+
+		normal.Normalize();
+		_frustumPlanes[i].normal = normal;
+		_frustumPlanes[i].distance = planes[i][3] / length;
+	}
 }
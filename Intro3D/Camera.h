@@ -9,6 +9,46 @@
 #include "Vertex.h"
 #include "Matrix3D.h"
 
+// Distance of the near clipping plane from the camera. Polygons are clipped
+// against it in homogeneous space, before they are dehomogenized.
+#define CAMERA_NEAR_PLANE		1.0f
+
+// Size of the guard band, as a multiple of the view frustum. Polygons only need clipping
+// against the sides of the frustum if they cross the guard band, otherwise the rasterizer
+// clips their spans to the screen.
+#define CAMERA_GUARD_BAND		16.0f
+
+// Distance of the far plane of the view frustum. Only used for culling.
+#define CAMERA_FAR_PLANE		10000.0f
+
+// Planes of the view frustum.
+enum FrustumPlaneIndex
+{
+	FrustumPlaneLeft,
+	FrustumPlaneRight,
+	FrustumPlaneBottom,
+	FrustumPlaneTop,
+	FrustumPlaneNear,
+	FrustumPlaneFar
+};
+#define FRUSTUM_PLANE_COUNT		6
+
+// Result of testing a bounding volume against the view frustum.
+enum FrustumTest
+{
+	FrustumOutside,
+	FrustumIntersecting,
+	FrustumInside
+};
+
+// A plane in world space. Points are inside the plane when
+// DotProduct(normal, point) + distance is positive.
+struct FrustumPlane
+{
+	Vector3D normal;
+	float distance;
+};
+
 // The camera class is responsible for defining a viewing position 
 // that the scene can be rendered from.
 class Camera
@@ -32,6 +72,13 @@ class Camera
 		void SetViewSize(unsigned int viewWidth, unsigned int viewHeight);
 		void GetViewSize(unsigned int& viewWidth, unsigned int& viewHeight);
 
+		void SetNearPlane(float nearPlane);
+		float GetNearPlane();
+
+		const FrustumPlane& GetFrustumPlane(int index);
+		FrustumTest TestSphere(const Vector3D& center, float radius);
+		FrustumTest TestAABB(const Vector3D& min, const Vector3D& max);
+
 		void RebuildMatrices();
 
 	private:
@@ -42,4 +89,8 @@ class Camera
 		float _xRotation, _yRotation, _zRotation;
 		Vertex _position;
 		int _viewWidth, _viewHeight;
+		float _nearPlane;
+		FrustumPlane _frustumPlanes[FRUSTUM_PLANE_COUNT];
+
+		void RebuildFrustumPlanes();
 };
@@ -0,0 +1,362 @@
+// =========================================================================================
+//	GdiPlus.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "GdiPlus.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+namespace Gdiplus
+{
+	// -------------------------------------------------------------------------------------
+	//	Color
+	// -------------------------------------------------------------------------------------
+	Color::Color()
+	{
+		Argb = Color::Black;
+	}
+	Color::Color(BYTE r, BYTE g, BYTE b)
+	{
+		Argb = MakeARGB(255, r, g, b);
+	}
+	Color::Color(BYTE a, BYTE r, BYTE g, BYTE b)
+	{
+		Argb = MakeARGB(a, r, g, b);
+	}
+	Color::Color(ARGB argb)
+	{
+		Argb = argb;
+	}
+
+	BYTE Color::GetA() const
+	{
+		return (BYTE)(Argb >> 24);
+	}
+	BYTE Color::GetR() const
+	{
+		return (BYTE)(Argb >> 16);
+	}
+	BYTE Color::GetG() const
+	{
+		return (BYTE)(Argb >> 8);
+	}
+	BYTE Color::GetB() const
+	{
+		return (BYTE)Argb;
+	}
+	ARGB Color::GetValue() const
+	{
+		return Argb;
+	}
+	void Color::SetValue(ARGB argb)
+	{
+		Argb = argb;
+	}
+
+	// COLORREF is stored red first, ARGB blue first.
+	void Color::SetFromCOLORREF(COLORREF rgb)
+	{
+		Argb = MakeARGB(255, (BYTE)rgb, (BYTE)(rgb >> 8), (BYTE)(rgb >> 16));
+	}
+
+	ARGB Color::MakeARGB(BYTE a, BYTE r, BYTE g, BYTE b)
+	{
+		return ((ARGB)a << 24) | ((ARGB)r << 16) | ((ARGB)g << 8) | (ARGB)b;
+	}
+
+	// -------------------------------------------------------------------------------------
+	//	Rect, PointF
+	// -------------------------------------------------------------------------------------
+	Rect::Rect(INT x, INT y, INT width, INT height)
+	{
+		X = x;
+		Y = y;
+		Width = width;
+		Height = height;
+	}
+
+	PointF::PointF()
+	{
+		X = 0;
+		Y = 0;
+	}
+	PointF::PointF(REAL x, REAL y)
+	{
+		X = x;
+		Y = y;
+	}
+
+	// -------------------------------------------------------------------------------------
+	//	Image, Bitmap
+	// -------------------------------------------------------------------------------------
+	Image::Image()
+	{
+		_width = 0;
+		_height = 0;
+		_stride = 0;
+		_pixels = NULL;
+		_ownPixels = false;
+	}
+
+	Image::~Image()
+	{
+		if (_ownPixels == true)
+			delete [] _pixels;
+		_pixels = NULL;
+	}
+
+	UINT Image::GetWidth()
+	{
+		return (UINT)_width;
+	}
+	UINT Image::GetHeight()
+	{
+		return (UINT)_height;
+	}
+
+	// New bitmaps are cleared to transparent black.
+	Bitmap::Bitmap(INT width, INT height, PixelFormat format)
+	{
+		_width = width;
+		_height = height;
+		_stride = width * 4;
+		_pixels = new BYTE[_stride * height];
+		_ownPixels = true;
+		memset(_pixels, 0, _stride * height);
+	}
+
+	// Wraps memory owned by the caller.
+	Bitmap::Bitmap(INT width, INT height, INT stride, PixelFormat format, BYTE* scan0)
+	{
+		_width = width;
+		_height = height;
+		_stride = stride;
+		_pixels = scan0;
+		_ownPixels = false;
+	}
+
+	// The pixels are always 32 bit and held in memory, so locking just points at them.
+	Status Bitmap::LockBits(const Rect* rect, UINT flags, PixelFormat format, BitmapData* lockedBitmapData)
+	{
+		if (format != PixelFormat32bppARGB)
+			return InvalidParameter;
+
+		INT x = 0;
+		INT y = 0;
+		INT width = _width;
+		INT height = _height;
+		if (rect != NULL)
+		{
+			if (rect->X < 0 || rect->Y < 0 || rect->X + rect->Width > _width || rect->Y + rect->Height > _height)
+				return InvalidParameter;
+			x = rect->X;
+			y = rect->Y;
+			width = rect->Width;
+			height = rect->Height;
+		}
+
+		lockedBitmapData->Width = (UINT)width;
+		lockedBitmapData->Height = (UINT)height;
+		lockedBitmapData->Stride = _stride;
+		lockedBitmapData->PixelFormat = format;
+		lockedBitmapData->Scan0 = _pixels + (y * _stride) + (x * 4);
+		lockedBitmapData->Reserved = 0;
+		return Ok;
+	}
+
+	Status Bitmap::UnlockBits(BitmapData* lockedBitmapData)
+	{
+		return Ok;
+	}
+
+	// -------------------------------------------------------------------------------------
+	//	Brush, Pen, Font
+	// -------------------------------------------------------------------------------------
+	Brush::~Brush()
+	{
+	}
+
+	Color Brush::GetColor() const
+	{
+		return _color;
+	}
+
+	SolidBrush::SolidBrush(const Color& color)
+	{
+		_color = color;
+	}
+
+	Pen::Pen(const Color& color, REAL width)
+	{
+		_color = color;
+	}
+
+	Color Pen::GetColor() const
+	{
+		return _color;
+	}
+
+	FontFamily::FontFamily(const WCHAR* name)
+	{
+	}
+
+	Font::Font(const FontFamily* family, REAL size, INT style, Unit unit)
+	{
+	}
+
+	// -------------------------------------------------------------------------------------
+	//	Graphics
+	// -------------------------------------------------------------------------------------
+	Graphics::Graphics(Image* image)
+	{
+		_image = image;
+	}
+
+	Graphics::Graphics(HDC hdc)
+	{
+		_image = NULL;
+	}
+
+	// Writes a pixel if it is inside the image.
+	void Graphics::SetPixel(INT x, INT y, ARGB color)
+	{
+		if (x < 0 || y < 0 || x >= _image->_width || y >= _image->_height)
+			return;
+		((ARGB*)(_image->_pixels + (y * _image->_stride)))[x] = color;
+	}
+
+	Status Graphics::Clear(const Color& color)
+	{
+		if (_image == NULL)
+			return Ok;
+
+		ARGB value = color.GetValue();
+		for (INT y = 0; y < _image->_height; y++)
+		{
+			ARGB* row = (ARGB*)(_image->_pixels + (y * _image->_stride));
+			for (INT x = 0; x < _image->_width; x++)
+				row[x] = value;
+		}
+		return Ok;
+	}
+
+	// Draws a one pixel wide line without anti-aliasing, including both end points.
+	Status Graphics::DrawLine(const Pen* pen, REAL x1, REAL y1, REAL x2, REAL y2)
+	{
+		if (_image == NULL)
+			return Ok;
+
+		ARGB color = pen->GetColor().GetValue();
+		INT x = (INT)floorf(x1 + 0.5f);
+		INT y = (INT)floorf(y1 + 0.5f);
+		INT endX = (INT)floorf(x2 + 0.5f);
+		INT endY = (INT)floorf(y2 + 0.5f);
+
+		INT deltaX = abs(endX - x);
+		INT deltaY = -abs(endY - y);
+		INT stepX = (x < endX) ? 1 : -1;
+		INT stepY = (y < endY) ? 1 : -1;
+		INT error = deltaX + deltaY;
+
+		while (true)
+		{
+			SetPixel(x, y, color);
+			if (x == endX && y == endY)
+				break;
+
+			INT error2 = error * 2;
+			if (error2 >= deltaY)
+			{
+				error += deltaY;
+				x += stepX;
+			}
+			if (error2 <= deltaX)
+			{
+				error += deltaX;
+				y += stepY;
+			}
+		}
+		return Ok;
+	}
+
+	// Fills the pixels whose centres are inside the polygon, by the even-odd rule.
+	Status Graphics::FillPolygon(const Brush* brush, const PointF* points, INT count)
+	{
+		if (_image == NULL || count < 3)
+			return Ok;
+
+		ARGB color = brush->GetColor().GetValue();
+		REAL top = points[0].Y;
+		REAL bottom = points[0].Y;
+		for (INT i = 1; i < count; i++)
+		{
+			top = min(top, points[i].Y);
+			bottom = max(bottom, points[i].Y);
+		}
+
+		INT startY = max((INT)ceilf(top - 0.5f), 0);
+		INT endY = min((INT)ceilf(bottom - 0.5f), _image->_height);
+		std::vector<REAL> crossings;
+		for (INT y = startY; y < endY; y++)
+		{
+			REAL centerY = (REAL)y + 0.5f;
+			crossings.clear();
+			for (INT i = 0; i < count; i++)
+			{
+				const PointF& a = points[i];
+				const PointF& b = points[(i + 1) % count];
+				if ((a.Y <= centerY) != (b.Y <= centerY))
+					crossings.push_back(a.X + (centerY - a.Y) * (b.X - a.X) / (b.Y - a.Y));
+			}
+			std::sort(crossings.begin(), crossings.end());
+
+			for (unsigned int i = 0; i + 1 < crossings.size(); i += 2)
+			{
+				INT startX = max((INT)ceilf(crossings[i] - 0.5f), 0);
+				INT endX = min((INT)ceilf(crossings[i + 1] - 0.5f), _image->_width);
+				for (INT x = startX; x < endX; x++)
+					SetPixel(x, y, color);
+			}
+		}
+		return Ok;
+	}
+
+	// There are no fonts to draw with.
+	Status Graphics::DrawString(const WCHAR* string, INT length, const Font* font, const PointF& origin, const Brush* brush)
+	{
+		return Ok;
+	}
+
+	// Copies the image without scaling, it is only ever drawn at its own size.
+	Status Graphics::DrawImage(Image* image, INT x, INT y, INT width, INT height)
+	{
+		if (_image == NULL)
+			return Ok;
+
+		width = min(width, image->_width);
+		height = min(height, image->_height);
+		for (INT row = 0; row < height; row++)
+		{
+			ARGB* source = (ARGB*)(image->_pixels + (row * image->_stride));
+			for (INT column = 0; column < width; column++)
+				SetPixel(x + column, y + row, source[column]);
+		}
+		return Ok;
+	}
+
+	Status GdiplusStartup(ULONG_PTR* token, const GdiplusStartupInput* input, void* output)
+	{
+		*token = 0;
+		return Ok;
+	}
+
+	void GdiplusShutdown(ULONG_PTR token)
+	{
+	}
+}
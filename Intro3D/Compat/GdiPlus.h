@@ -0,0 +1,206 @@
+// =========================================================================================
+//	GdiPlus.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Stands in for GDI+ when the renderer is built on other platforms. Bitmaps are plain
+// 32 bit memory, and the few drawing calls the rasterizer makes are done in software.
+// Text is not drawn, and there are no device contexts to draw to.
+
+#pragma once
+#include "windows.h"
+#include <math.h>
+
+namespace Gdiplus
+{
+	typedef DWORD ARGB;
+	typedef float REAL;
+	typedef INT PixelFormat;
+
+	enum Status
+	{
+		Ok,
+		GenericError,
+		InvalidParameter
+	};
+
+	enum ImageLockMode
+	{
+		ImageLockModeRead = 1,
+		ImageLockModeWrite = 2
+	};
+
+	enum FontStyle
+	{
+		FontStyleRegular = 0
+	};
+
+	enum Unit
+	{
+		UnitPixel = 2
+	};
+
+	#define PixelFormat32bppARGB	2498570
+
+	class Color
+	{
+		public:
+			Color();
+			Color(BYTE r, BYTE g, BYTE b);
+			Color(BYTE a, BYTE r, BYTE g, BYTE b);
+			Color(ARGB argb);
+
+			BYTE GetA() const;
+			BYTE GetR() const;
+			BYTE GetG() const;
+			BYTE GetB() const;
+			ARGB GetValue() const;
+			void SetValue(ARGB argb);
+			void SetFromCOLORREF(COLORREF rgb);
+
+			static ARGB MakeARGB(BYTE a, BYTE r, BYTE g, BYTE b);
+
+			enum
+			{
+				Black = 0xff000000,
+				White = 0xffffffff,
+				Red = 0xffff0000,
+				SteelBlue = 0xff4682b4
+			};
+
+		protected:
+			ARGB Argb;
+	};
+
+	class Rect
+	{
+		public:
+			Rect(INT x, INT y, INT width, INT height);
+
+			INT X;
+			INT Y;
+			INT Width;
+			INT Height;
+	};
+
+	class PointF
+	{
+		public:
+			PointF();
+			PointF(REAL x, REAL y);
+
+			REAL X;
+			REAL Y;
+	};
+
+	class BitmapData
+	{
+		public:
+			UINT Width;
+			UINT Height;
+			INT Stride;
+			INT PixelFormat;
+			void* Scan0;
+			ULONG_PTR Reserved;
+	};
+
+	// Every image is a 32 bit bitmap held in memory.
+	class Image
+	{
+		public:
+			virtual ~Image();
+
+			UINT GetWidth();
+			UINT GetHeight();
+
+		protected:
+			INT _width;
+			INT _height;
+			INT _stride;
+			BYTE* _pixels;
+			bool _ownPixels;
+
+			Image();
+
+			friend class Graphics;
+	};
+
+	class Bitmap : public Image
+	{
+		public:
+			Bitmap(INT width, INT height, PixelFormat format);
+			Bitmap(INT width, INT height, INT stride, PixelFormat format, BYTE* scan0);
+
+			Status LockBits(const Rect* rect, UINT flags, PixelFormat format, BitmapData* lockedBitmapData);
+			Status UnlockBits(BitmapData* lockedBitmapData);
+	};
+
+	class Brush
+	{
+		public:
+			virtual ~Brush();
+
+			Color GetColor() const;
+
+		protected:
+			Color _color;
+	};
+
+	class SolidBrush : public Brush
+	{
+		public:
+			SolidBrush(const Color& color);
+	};
+
+	class Pen
+	{
+		public:
+			Pen(const Color& color, REAL width = 1.0f);
+
+			Color GetColor() const;
+
+		private:
+			Color _color;
+	};
+
+	class FontFamily
+	{
+		public:
+			FontFamily(const WCHAR* name);
+	};
+
+	class Font
+	{
+		public:
+			Font(const FontFamily* family, REAL size, INT style, Unit unit);
+	};
+
+	// Draws onto an image. Graphics made for a device context have nothing to draw
+	// onto, so their calls do nothing.
+	class Graphics
+	{
+		public:
+			Graphics(Image* image);
+			Graphics(HDC hdc);
+
+			Status Clear(const Color& color);
+			Status DrawLine(const Pen* pen, REAL x1, REAL y1, REAL x2, REAL y2);
+			Status FillPolygon(const Brush* brush, const PointF* points, INT count);
+			Status DrawString(const WCHAR* string, INT length, const Font* font, const PointF& origin, const Brush* brush);
+			Status DrawImage(Image* image, INT x, INT y, INT width, INT height);
+
+		private:
+			Image* _image;
+
+			void SetPixel(INT x, INT y, ARGB color);
+	};
+
+	class GdiplusStartupInput
+	{
+	};
+
+	Status GdiplusStartup(ULONG_PTR* token, const GdiplusStartupInput* input, void* output);
+	void GdiplusShutdown(ULONG_PTR token);
+}
@@ -0,0 +1,11 @@
+// =========================================================================================
+//	SDKDDKVer.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Stands in for the Windows header when the renderer is built on other platforms, there
+// is no platform version to target.
+
+#pragma once
@@ -0,0 +1,12 @@
+// =========================================================================================
+//	StdAfx.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Sources include the precompiled header by either spelling, which only matters where
+// file names are case sensitive.
+
+#pragma once
+#include "../stdafx.h"
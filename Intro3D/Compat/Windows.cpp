@@ -0,0 +1,41 @@
+// =========================================================================================
+//	Windows.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "windows.h"
+#include <stdarg.h>
+#include <wchar.h>
+#include <chrono>
+
+// Size of the buffers given to wsprintf, the most it writes on Windows.
+#define WSPRINTF_BUFFER_SIZE	1024
+
+// Milliseconds since an arbitrary point, like the time since the system started.
+DWORD GetTickCount()
+{
+	std::chrono::steady_clock::duration time = std::chrono::steady_clock::now().time_since_epoch();
+	return (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+}
+
+// Formats into the buffer. Only integer formats are used, which mean the same here.
+int wsprintf(WCHAR* buffer, const WCHAR* format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+	int result = vswprintf(buffer, WSPRINTF_BUFFER_SIZE, format, arguments);
+	va_end(arguments);
+	return result;
+}
+
+BOOL GetClientRect(HWND hWnd, RECT* rect)
+{
+	return FALSE;
+}
+
+BOOL InvalidateRect(HWND hWnd, const RECT* rect, BOOL erase)
+{
+	return FALSE;
+}
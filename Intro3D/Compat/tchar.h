@@ -0,0 +1,11 @@
+// =========================================================================================
+//	tchar.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Stands in for the Windows header when the renderer is built on other platforms.
+
+#pragma once
+#include <wchar.h>
@@ -0,0 +1,81 @@
+// =========================================================================================
+//	windows.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Stands in for the Windows header when the renderer is built on other platforms, only
+// the offline targets are built there so only what the renderer uses is declared. The
+// window procedure and message loop in Intro3D.cpp are not built.
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef int INT;
+typedef unsigned int UINT;
+typedef int LONG;
+typedef unsigned int DWORD;
+typedef unsigned int ULONG;
+typedef uintptr_t ULONG_PTR;
+typedef intptr_t INT_PTR;
+typedef intptr_t LRESULT;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef int BOOL;
+typedef unsigned short ATOM;
+typedef DWORD COLORREF;
+typedef wchar_t WCHAR;
+typedef wchar_t TCHAR;
+typedef wchar_t* LPTSTR;
+typedef void* HANDLE;
+
+// Handles are never used on these platforms, they are only passed around as NULL.
+struct HWND__;
+typedef HWND__* HWND;
+struct HDC__;
+typedef HDC__* HDC;
+struct HINSTANCE__;
+typedef HINSTANCE__* HINSTANCE;
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+#define TRUE		1
+#define FALSE		0
+
+#define WINAPI
+#define CALLBACK
+#define APIENTRY
+
+#define RGB(r, g, b)	((COLORREF)(((BYTE)(r) | ((WORD)((BYTE)(g)) << 8)) | (((DWORD)(BYTE)(b)) << 16)))
+
+// The Windows header defines min and max as macros. They are functions here so the
+// standard headers included after this one still compile, the result is the common
+// type of both arguments just as it is with the macros.
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type min(A a, B b)
+{
+	return (a < b) ? a : b;
+}
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type max(A a, B b)
+{
+	return (a > b) ? a : b;
+}
+
+DWORD GetTickCount();
+int wsprintf(WCHAR* buffer, const WCHAR* format, ...);
+
+// There are no windows, so there is no client area and nothing to invalidate.
+BOOL GetClientRect(HWND hWnd, RECT* rect);
+BOOL InvalidateRect(HWND hWnd, const RECT* rect, BOOL erase);
@@ -0,0 +1,43 @@
+// =========================================================================================
+//	DisplayMode.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+
+// Enumeration of every display mode show in the demonstration.
+enum DisplayMode
+{
+	WireFrame,
+	FlatShadedUnlit,
+	FlatShadedAmbient,
+	FlatShadedDirectionalAmbient,
+	FlatShadedDirectionalPointAmient,
+	GouraudShadedUnlit,
+	GouraudShadedAmbient,
+	GouraudShadedDirectionalAmbient,
+	GouraudShadedDirectionalPointAmient,
+	TexturedUnlit,
+	TexturedAmbient,
+	TexturedDirectionalAmbient,
+	TexturedNormalMappedDirectionalAmbient,
+	TexturedDirectionalPointAmbient,
+	TexturedNormalMappedDirectionalPointAmbient
+};
+
+// Number of display modes in the enumeration above.
+#define DISPLAY_MODE_COUNT		15
+
+// Enumeration of the debug views that can be drawn over a finished frame, in place of
+// its colours, to show where the pixel work of the frame went.
+enum DebugView
+{
+	DebugViewNone,
+	DebugViewOverdraw,		// Number of times each pixel was written by a span.
+	DebugViewTileCost		// Time spent shading the spans of each tile.
+};
+
+// Number of debug views in the enumeration above.
+#define DEBUG_VIEW_COUNT		3
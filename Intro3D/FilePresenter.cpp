@@ -0,0 +1,206 @@
+// =========================================================================================
+//	FilePresenter.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "FilePresenter.h"
+#include <vector>
+
+// No-Argument Constructor. Declared private, should not get called.
+FilePresenter::FilePresenter(void)
+{
+	_framesWritten = 0;
+	_pngOn = false;
+}
+
+// Constructor. Frames are written to paths made from the given format, as PNGs if the
+// format ends in .png and PPMs otherwise.
+FilePresenter::FilePresenter(const char* pathFormat)
+{
+	_pathFormat = pathFormat;
+	_framesWritten = 0;
+
+	size_t length = _pathFormat.size();
+	_pngOn = length >= 4 && _pathFormat.compare(length - 4, 4, ".png") == 0;
+}
+
+// Destructor.
+FilePresenter::~FilePresenter(void)
+{
+}
+
+// Accessor methods.
+unsigned int FilePresenter::GetFramesWritten()
+{
+	return _framesWritten;
+}
+
+// Writes the frame to the next file.
+void FilePresenter::Present(Gdiplus::Bitmap* frame)
+{
+	char path[512];
+	sprintf(path, _pathFormat.c_str(), _framesWritten);
+
+	int width = (int)frame->GetWidth();
+	int height = (int)frame->GetHeight();
+	Gdiplus::Rect rect(0, 0, width, height);
+	Gdiplus::BitmapData bitmapData;
+	if (frame->LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &bitmapData) != Gdiplus::Ok)
+		return;
+
+	FILE* file = fopen(path, "wb");
+	if (file != NULL)
+	{
+		if (_pngOn == true)
+			WritePNG(file, bitmapData);
+		else
+			WritePPM(file, bitmapData);
+
+		fclose(file);
+		_framesWritten++;
+	}
+
+	frame->UnlockBits(&bitmapData);
+}
+
+// Copies a row of the frame to red, green, blue bytes. Each pixel is stored as blue,
+// green, red, alpha.
+void FilePresenter::ConvertRow(const Gdiplus::BitmapData& bitmapData, int y, BYTE* row)
+{
+	BYTE* pixels = (BYTE*)bitmapData.Scan0 + (y * bitmapData.Stride);
+	for (unsigned int x = 0; x < bitmapData.Width; x++)
+	{
+		row[(x * 3) + 0] = pixels[(x * 4) + 2];
+		row[(x * 3) + 1] = pixels[(x * 4) + 1];
+		row[(x * 3) + 2] = pixels[(x * 4) + 0];
+	}
+}
+
+// Writes the frame as a binary PPM.
+void FilePresenter::WritePPM(FILE* file, const Gdiplus::BitmapData& bitmapData)
+{
+	int width = (int)bitmapData.Width;
+	int height = (int)bitmapData.Height;
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+	BYTE* row = new BYTE[width * 3];
+	for (int y = 0; y < height; y++)
+	{
+		ConvertRow(bitmapData, y, row);
+		fwrite(row, 1, width * 3, file);
+	}
+	delete[] row;
+}
+
+// Writes the frame as a PNG. The image data is stored in uncompressed deflate blocks, 
+// which every PNG reader accepts and which costs nothing to write.
+void FilePresenter::WritePNG(FILE* file, const Gdiplus::BitmapData& bitmapData)
+{
+	static const BYTE signature[] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	fwrite(signature, 1, sizeof(signature), file);
+
+	// Header, 8 bits per channel RGB with no interlacing.
+	unsigned int width = bitmapData.Width;
+	unsigned int height = bitmapData.Height;
+	BYTE header[13];
+	WriteBigEndian(header, width);
+	WriteBigEndian(header + 4, height);
+	header[8] = 8;
+	header[9] = 2;
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;
+	WritePNGChunk(file, "IHDR", header, sizeof(header));
+
+	// Each row starts with the filter it uses, which is none.
+	unsigned int rowSize = 1 + (width * 3);
+	std::vector<BYTE> image(rowSize * height);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		image[y * rowSize] = 0;
+		ConvertRow(bitmapData, y, &image[(y * rowSize) + 1]);
+	}
+
+	// Wrap the rows in a zlib stream of stored blocks.
+	unsigned int imageSize = (unsigned int)image.size();
+	unsigned int blockCount = max((imageSize + PNG_STORED_BLOCK_SIZE - 1) / PNG_STORED_BLOCK_SIZE, 1u);
+	std::vector<BYTE> data;
+	data.reserve(2 + (blockCount * 5) + imageSize + 4);
+	data.push_back(0x78);
+	data.push_back(0x01);
+
+	unsigned int a = 1;
+	unsigned int b = 0;
+	for (unsigned int offset = 0, block = 0; block < blockCount; block++, offset += PNG_STORED_BLOCK_SIZE)
+	{
+		unsigned int size = min(imageSize - offset, (unsigned int)PNG_STORED_BLOCK_SIZE);
+		data.push_back(block == blockCount - 1 ? 1 : 0);
+		data.push_back((BYTE)size);
+		data.push_back((BYTE)(size >> 8));
+		data.push_back((BYTE)~size);
+		data.push_back((BYTE)(~size >> 8));
+		data.insert(data.end(), image.begin() + offset, image.begin() + offset + size);
+
+		for (unsigned int i = offset; i < offset + size; i++)
+		{
+			a = (a + image[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+	}
+
+	BYTE adler[4];
+	WriteBigEndian(adler, (b << 16) | a);
+	data.insert(data.end(), adler, adler + 4);
+	WritePNGChunk(file, "IDAT", &data[0], (unsigned int)data.size());
+	WritePNGChunk(file, "IEND", NULL, 0);
+}
+
+// Writes a PNG chunk, its length, type, data and the CRC of its type and data.
+void FilePresenter::WritePNGChunk(FILE* file, const char* type, const BYTE* data, unsigned int length)
+{
+	BYTE value[4];
+	WriteBigEndian(value, length);
+	fwrite(value, 1, 4, file);
+	fwrite(type, 1, 4, file);
+	if (length > 0)
+		fwrite(data, 1, length, file);
+
+	unsigned int crc = UpdateCRC(0xffffffff, (const BYTE*)type, 4);
+	crc = UpdateCRC(crc, data, length) ^ 0xffffffff;
+	WriteBigEndian(value, crc);
+	fwrite(value, 1, 4, file);
+}
+
+// Adds bytes to the CRC used by PNG chunks.
+unsigned int FilePresenter::UpdateCRC(unsigned int crc, const BYTE* data, unsigned int length)
+{
+	static unsigned int table[256];
+	static bool tableBuilt = false;
+	if (tableBuilt == false)
+	{
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int value = i;
+			for (int bit = 0; bit < 8; bit++)
+				value = (value & 1) ? (0xedb88320 ^ (value >> 1)) : (value >> 1);
+			table[i] = value;
+		}
+		tableBuilt = true;
+	}
+
+	for (unsigned int i = 0; i < length; i++)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+// Stores a value with its most significant byte first.
+void FilePresenter::WriteBigEndian(BYTE* output, unsigned int value)
+{
+	output[0] = (BYTE)(value >> 24);
+	output[1] = (BYTE)(value >> 16);
+	output[2] = (BYTE)(value >> 8);
+	output[3] = (BYTE)value;
+}
@@ -0,0 +1,43 @@
+// =========================================================================================
+//	FilePresenter.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Presenter.h"
+#include <string>
+#include <stdio.h>
+
+// Most bytes in each uncompressed deflate block of a PNG.
+#define PNG_STORED_BLOCK_SIZE	65535
+
+// This presenter writes each frame it is given to its own binary PPM or PNG file. The path
+// is a printf format given the number of the frame, for example "frame%04d.ppm".
+class FilePresenter : public Presenter
+{
+	public:
+		FilePresenter(const char* pathFormat);
+		~FilePresenter(void);
+
+		void Present(Gdiplus::Bitmap* frame);
+
+		unsigned int GetFramesWritten();
+
+	private:
+		std::string _pathFormat;
+		unsigned int _framesWritten;
+		bool _pngOn;
+
+		void WritePPM(FILE* file, const Gdiplus::BitmapData& bitmapData);
+		void WritePNG(FILE* file, const Gdiplus::BitmapData& bitmapData);
+
+		static void ConvertRow(const Gdiplus::BitmapData& bitmapData, int y, BYTE* row);
+		static void WritePNGChunk(FILE* file, const char* type, const BYTE* data, unsigned int length);
+		static unsigned int UpdateCRC(unsigned int crc, const BYTE* data, unsigned int length);
+		static void WriteBigEndian(BYTE* output, unsigned int value);
+
+		// Private constructor. Should not be used directly.
+		FilePresenter(void);
+};
@@ -0,0 +1,369 @@
+// =========================================================================================
+//	FrameCapture.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "FrameCapture.h"
+
+// Constructor. Makes an empty capture.
+FrameCapture::FrameCapture(void)
+{
+	_file = NULL;
+	_width = 0;
+	_height = 0;
+}
+
+// Destructor.
+FrameCapture::~FrameCapture(void)
+{
+	Close();
+}
+
+// Adds a model whose instances are recorded, with the files it was loaded from. NULL
+// filenames are stored as empty. Models past FRAME_CAPTURE_MAX_MODELS are not recorded.
+void FrameCapture::AddModel(Model3D* model, const char* modelFilename, const char* textureFilename, const char* normalMapFilename)
+{
+	if (_models.size() >= FRAME_CAPTURE_MAX_MODELS)
+		return;
+
+	CapturedModel capturedModel;
+	capturedModel.modelFilename = modelFilename ? modelFilename : "";
+	capturedModel.textureFilename = textureFilename ? textureFilename : "";
+	capturedModel.normalMapFilename = normalMapFilename ? normalMapFilename : "";
+	_models.push_back(capturedModel);
+	_recordedModels.push_back(model);
+}
+
+// Sets the lights that are recorded. Spot lights are not drawn by any display mode, so
+// they are not recorded. Lights past FRAME_CAPTURE_MAX_LIGHTS are not recorded.
+void FrameCapture::SetLights(const std::vector<DirectionalLight*>& directionalLights, const std::vector<AmbientLight*>& ambientLights, const std::vector<PointLight*>& pointLights)
+{
+	_lights.clear();
+	_recordedLights.clear();
+
+	for (unsigned int i = 0; i < directionalLights.size(); i++)
+		AddLight(directionalLights[i], CapturedLightDirectional);
+	for (unsigned int i = 0; i < ambientLights.size(); i++)
+		AddLight(ambientLights[i], CapturedLightAmbient);
+	for (unsigned int i = 0; i < pointLights.size(); i++)
+		AddLight(pointLights[i], CapturedLightPoint);
+}
+
+// Records a light as it is now.
+void FrameCapture::AddLight(Light* light, CapturedLightType type)
+{
+	if (_lights.size() >= FRAME_CAPTURE_MAX_LIGHTS)
+		return;
+
+	CapturedLight capturedLight;
+	Vertex position = light->GetPosition();
+	Gdiplus::Color intensity = light->GetIntensity();
+	capturedLight.type = type;
+	capturedLight.position[0] = position.GetX();
+	capturedLight.position[1] = position.GetY();
+	capturedLight.position[2] = position.GetZ();
+	capturedLight.intensity[0] = intensity.GetR();
+	capturedLight.intensity[1] = intensity.GetG();
+	capturedLight.intensity[2] = intensity.GetB();
+	capturedLight.attenuation[0] = 0;
+	capturedLight.attenuation[1] = 0;
+	capturedLight.attenuation[2] = 0;
+	if (type == CapturedLightPoint)
+		((PointLight*)light)->GetAttenuation(capturedLight.attenuation[0], capturedLight.attenuation[1], capturedLight.attenuation[2]);
+
+	_lights.push_back(capturedLight);
+	_recordedLights.push_back(light);
+}
+
+// Opens a file and writes the framebuffer size, models and lights to it. Returns false if
+// it could not be written.
+bool FrameCapture::Open(const char* filename, unsigned int width, unsigned int height)
+{
+	Close();
+	_file = fopen(filename, "wb");
+	if (_file == NULL)
+		return false;
+	_width = width;
+	_height = height;
+
+	unsigned int version = FRAME_CAPTURE_VERSION;
+	unsigned int modelCount = _models.size();
+	unsigned int lightCount = _lights.size();
+	fwrite(FRAME_CAPTURE_MAGIC, 1, 4, _file);
+	fwrite(&version, sizeof(version), 1, _file);
+	fwrite(&_width, sizeof(_width), 1, _file);
+	fwrite(&_height, sizeof(_height), 1, _file);
+
+	fwrite(&modelCount, sizeof(modelCount), 1, _file);
+	for (unsigned int i = 0; i < modelCount; i++)
+	{
+		WriteString(_file, _models[i].modelFilename);
+		WriteString(_file, _models[i].textureFilename);
+		WriteString(_file, _models[i].normalMapFilename);
+	}
+
+	fwrite(&lightCount, sizeof(lightCount), 1, _file);
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		const CapturedLight& light = _lights[i];
+		BYTE type = (BYTE)light.type;
+		fwrite(&type, 1, 1, _file);
+		fwrite(light.position, sizeof(float), 3, _file);
+		fwrite(light.intensity, 1, 3, _file);
+		fwrite(light.attenuation, sizeof(float), 3, _file);
+	}
+
+	if (ferror(_file) != 0)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// Writes what the next frame is rendered from: the display mode, the camera, which
+// lights are enabled and every instance in the scene. Returns false if the capture is not
+// open or it could not be written.
+bool FrameCapture::WriteFrame(DisplayMode mode, Camera* camera, Scene* scene)
+{
+	if (_file == NULL)
+		return false;
+
+	// The frame is reused so recording does not allocate once the instances fit.
+	CapturedFrame& frame = _frame;
+	Vertex position = camera->GetPosition();
+	frame.displayMode = mode;
+	frame.cameraPosition[0] = position.GetX();
+	frame.cameraPosition[1] = position.GetY();
+	frame.cameraPosition[2] = position.GetZ();
+	camera->GetRotation(frame.cameraRotation[0], frame.cameraRotation[1], frame.cameraRotation[2]);
+	camera->GetViewSize(frame.viewWidth, frame.viewHeight);
+
+	frame.lightsEnabled = 0;
+	for (unsigned int i = 0; i < _recordedLights.size(); i++)
+	{
+		if (_recordedLights[i]->GetEnabled() == true)
+			frame.lightsEnabled |= 1 << i;
+	}
+	frame.normalMapsOn = 0;
+	for (unsigned int i = 0; i < _recordedModels.size(); i++)
+	{
+		if (_recordedModels[i]->GetNormalMapOn() == true)
+			frame.normalMapsOn |= 1 << i;
+	}
+
+	frame.instances.clear();
+	for (unsigned int i = 0; i < scene->GetInstanceCount(); i++)
+	{
+		ModelInstance* instance = scene->GetInstance(i);
+		unsigned int model = 0;
+		while (model < _recordedModels.size() && _recordedModels[model] != instance->GetModel())
+			model++;
+		if (model == _recordedModels.size())
+			continue;
+
+		CapturedInstance capturedInstance;
+		capturedInstance.model = (unsigned short)model;
+		capturedInstance.layer = instance->GetRenderLayer();
+		const Matrix3D& transform = instance->GetTransform();
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				capturedInstance.transform[row][column] = transform.GetElement(row, column);
+		}
+		frame.instances.push_back(capturedInstance);
+	}
+
+	int displayMode = frame.displayMode;
+	unsigned int instanceCount = frame.instances.size();
+	fwrite(&displayMode, sizeof(displayMode), 1, _file);
+	fwrite(frame.cameraPosition, sizeof(float), 3, _file);
+	fwrite(frame.cameraRotation, sizeof(float), 3, _file);
+	fwrite(&frame.viewWidth, sizeof(frame.viewWidth), 1, _file);
+	fwrite(&frame.viewHeight, sizeof(frame.viewHeight), 1, _file);
+	fwrite(&frame.lightsEnabled, sizeof(frame.lightsEnabled), 1, _file);
+	fwrite(&frame.normalMapsOn, sizeof(frame.normalMapsOn), 1, _file);
+	fwrite(&instanceCount, sizeof(instanceCount), 1, _file);
+	for (unsigned int i = 0; i < instanceCount; i++)
+	{
+		const CapturedInstance& instance = frame.instances[i];
+		BYTE layer[2] = { (BYTE)instance.layer, 0 };
+		fwrite(&instance.model, sizeof(instance.model), 1, _file);
+		fwrite(layer, 1, 2, _file);
+		fwrite(instance.transform, sizeof(float), 16, _file);
+	}
+
+	// Each frame is flushed, so the frames before a crash are kept.
+	fflush(_file);
+	return ferror(_file) == 0;
+}
+
+// Closes the file being recorded to.
+void FrameCapture::Close()
+{
+	if (_file != NULL)
+	{
+		fclose(_file);
+		_file = NULL;
+	}
+}
+
+// Reads a capture file. A frame cut short at the end of the file, as left by a renderer
+// that did not shut down cleanly, is dropped. Returns false if the file could not be read
+// or is not a capture of this version.
+bool FrameCapture::Load(const char* filename)
+{
+	Close();
+	_models.clear();
+	_lights.clear();
+	_frames.clear();
+	_recordedModels.clear();
+	_recordedLights.clear();
+
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL)
+		return false;
+
+	// The size of the file bounds how many instances a frame can hold.
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	char magic[4];
+	unsigned int version = 0;
+	unsigned int modelCount = 0;
+	unsigned int lightCount = 0;
+	bool loaded = fread(magic, 1, 4, file) == 4 && memcmp(magic, FRAME_CAPTURE_MAGIC, 4) == 0 &&
+				  fread(&version, sizeof(version), 1, file) == 1 && version == FRAME_CAPTURE_VERSION &&
+				  fread(&_width, sizeof(_width), 1, file) == 1 &&
+				  fread(&_height, sizeof(_height), 1, file) == 1 &&
+				  fread(&modelCount, sizeof(modelCount), 1, file) == 1 && modelCount <= FRAME_CAPTURE_MAX_MODELS;
+
+	for (unsigned int i = 0; i < modelCount && loaded == true; i++)
+	{
+		CapturedModel model;
+		loaded = ReadString(file, model.modelFilename) && ReadString(file, model.textureFilename) && ReadString(file, model.normalMapFilename);
+		_models.push_back(model);
+	}
+
+	loaded = loaded && fread(&lightCount, sizeof(lightCount), 1, file) == 1 && lightCount <= FRAME_CAPTURE_MAX_LIGHTS;
+	for (unsigned int i = 0; i < lightCount && loaded == true; i++)
+	{
+		CapturedLight light;
+		BYTE type = 0;
+		loaded = fread(&type, 1, 1, file) == 1 && type <= CapturedLightPoint &&
+				 fread(light.position, sizeof(float), 3, file) == 3 &&
+				 fread(light.intensity, 1, 3, file) == 3 &&
+				 fread(light.attenuation, sizeof(float), 3, file) == 3;
+		light.type = (CapturedLightType)type;
+		_lights.push_back(light);
+	}
+
+	// Frames follow until the end of the file.
+	CapturedFrame frame;
+	while (loaded == true && ReadFrame(file, fileSize, frame) == true)
+		_frames.push_back(frame);
+
+	fclose(file);
+	if (loaded == false)
+	{
+		_models.clear();
+		_lights.clear();
+		_frames.clear();
+	}
+	return loaded;
+}
+
+// Reads the next frame of a capture file of the given size. Returns false at the end of the
+// file, or if the frame is cut short or is not valid.
+bool FrameCapture::ReadFrame(FILE* file, long fileSize, CapturedFrame& frame)
+{
+	int displayMode = 0;
+	unsigned int instanceCount = 0;
+	if (fread(&displayMode, sizeof(displayMode), 1, file) != 1 || displayMode < 0 || displayMode >= DISPLAY_MODE_COUNT ||
+		fread(frame.cameraPosition, sizeof(float), 3, file) != 3 ||
+		fread(frame.cameraRotation, sizeof(float), 3, file) != 3 ||
+		fread(&frame.viewWidth, sizeof(frame.viewWidth), 1, file) != 1 ||
+		fread(&frame.viewHeight, sizeof(frame.viewHeight), 1, file) != 1 ||
+		fread(&frame.lightsEnabled, sizeof(frame.lightsEnabled), 1, file) != 1 ||
+		fread(&frame.normalMapsOn, sizeof(frame.normalMapsOn), 1, file) != 1 ||
+		fread(&instanceCount, sizeof(instanceCount), 1, file) != 1)
+		return false;
+	frame.displayMode = (DisplayMode)displayMode;
+
+	// Every instance is written with the same number of bytes, so a count the rest of the
+	// file can not hold is from a corrupt or cut short file. It is rejected before any room
+	// is made for the instances.
+	const long instanceBytes = sizeof(unsigned short) + 2 + (16 * sizeof(float));
+	long remainingBytes = fileSize - ftell(file);
+	if (remainingBytes < 0 || instanceCount > (unsigned long)(remainingBytes / instanceBytes))
+		return false;
+
+	frame.instances.resize(instanceCount);
+	for (unsigned int i = 0; i < instanceCount; i++)
+	{
+		CapturedInstance& instance = frame.instances[i];
+		BYTE layer[2];
+		if (fread(&instance.model, sizeof(instance.model), 1, file) != 1 || instance.model >= _models.size() ||
+			fread(layer, 1, 2, file) != 2 || layer[0] > RenderLayerScene ||
+			fread(instance.transform, sizeof(float), 16, file) != 16)
+			return false;
+		instance.layer = (RenderLayer)layer[0];
+	}
+	return true;
+}
+
+// Writes a string as its length followed by its characters.
+bool FrameCapture::WriteString(FILE* file, const std::string& text)
+{
+	unsigned short length = (unsigned short)text.size();
+	return fwrite(&length, sizeof(length), 1, file) == 1 && fwrite(text.c_str(), 1, length, file) == length;
+}
+
+// Reads a string written by WriteString.
+bool FrameCapture::ReadString(FILE* file, std::string& text)
+{
+	unsigned short length = 0;
+	if (fread(&length, sizeof(length), 1, file) != 1)
+		return false;
+
+	text.resize(length);
+	return length == 0 || fread(&text[0], 1, length, file) == length;
+}
+
+// Accessor methods.
+unsigned int FrameCapture::GetWidth() const
+{
+	return _width;
+}
+unsigned int FrameCapture::GetHeight() const
+{
+	return _height;
+}
+unsigned int FrameCapture::GetModelCount() const
+{
+	return _models.size();
+}
+const CapturedModel& FrameCapture::GetModel(unsigned int index) const
+{
+	return _models[index];
+}
+unsigned int FrameCapture::GetLightCount() const
+{
+	return _lights.size();
+}
+const CapturedLight& FrameCapture::GetLight(unsigned int index) const
+{
+	return _lights[index];
+}
+unsigned int FrameCapture::GetFrameCount() const
+{
+	return _frames.size();
+}
+const CapturedFrame& FrameCapture::GetFrame(unsigned int index) const
+{
+	return _frames[index];
+}
@@ -0,0 +1,132 @@
+// =========================================================================================
+//	FrameCapture.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Scene.h"
+#include "Camera.h"
+#include "DirectionalLight.h"
+#include "AmbientLight.h"
+#include "PointLight.h"
+#include "DisplayMode.h"
+#include <vector>
+#include <string>
+#include <stdio.h>
+
+// Identifies capture files, and the version of their layout. The version is raised
+// whenever the layout changes, older captures are not read.
+#define FRAME_CAPTURE_MAGIC			"I3DC"
+#define FRAME_CAPTURE_VERSION		1
+
+// Most models and lights a capture holds. Which lights are enabled and which models are
+// normal mapped is stored as a bit for each, so there can be no more than fit in a mask.
+#define FRAME_CAPTURE_MAX_MODELS	32
+#define FRAME_CAPTURE_MAX_LIGHTS	32
+
+// Kinds of light a capture holds.
+enum CapturedLightType
+{
+	CapturedLightDirectional,
+	CapturedLightAmbient,
+	CapturedLightPoint
+};
+
+// A model of the capture, as the files it is loaded from. Files it was not loaded with
+// are empty.
+struct CapturedModel
+{
+	std::string modelFilename;
+	std::string textureFilename;
+	std::string normalMapFilename;
+};
+
+// A light of the capture. The attenuation is only used by point lights.
+struct CapturedLight
+{
+	CapturedLightType type;
+	float position[3];
+	BYTE intensity[3];
+	float attenuation[3];
+};
+
+// An instance in a captured frame, the index of its model in the capture and its world
+// transform.
+struct CapturedInstance
+{
+	unsigned short model;
+	RenderLayer layer;
+	float transform[4][4];
+};
+
+// Everything a frame is rendered from. The lights enabled and the models drawn with their
+// normal maps are a bit for each, indexed as in the capture.
+struct CapturedFrame
+{
+	DisplayMode displayMode;
+	float cameraPosition[3];
+	float cameraRotation[3];
+	unsigned int viewWidth;
+	unsigned int viewHeight;
+	unsigned int lightsEnabled;
+	unsigned int normalMapsOn;
+	std::vector<CapturedInstance> instances;
+};
+
+// This class records what each frame of a renderer is rendered from into a binary file,
+// or reads one back so the frames can be rendered again. The file starts with the size of
+// the framebuffer, the files of each model and each light, followed by the frames: the
+// display mode, the camera, which lights are enabled, and the model and world transform
+// of every instance in the scene. The animation that moved them is not needed to render
+// the frames again.
+//
+// To record, the models and lights are added before the file is opened, then a frame is
+// written after each update of the scene. The file is written as the frames are, so a
+// capture is kept even if the renderer does not shut down cleanly. Instances of models
+// that were not added are left out.
+class FrameCapture
+{
+	public:
+		FrameCapture(void);
+		~FrameCapture(void);
+
+		void AddModel(Model3D* model, const char* modelFilename, const char* textureFilename, const char* normalMapFilename);
+		void SetLights(const std::vector<DirectionalLight*>& directionalLights, const std::vector<AmbientLight*>& ambientLights, const std::vector<PointLight*>& pointLights);
+
+		bool Open(const char* filename, unsigned int width, unsigned int height);
+		bool WriteFrame(DisplayMode mode, Camera* camera, Scene* scene);
+		void Close();
+
+		bool Load(const char* filename);
+
+		unsigned int GetWidth() const;
+		unsigned int GetHeight() const;
+		unsigned int GetModelCount() const;
+		const CapturedModel& GetModel(unsigned int index) const;
+		unsigned int GetLightCount() const;
+		const CapturedLight& GetLight(unsigned int index) const;
+		unsigned int GetFrameCount() const;
+		const CapturedFrame& GetFrame(unsigned int index) const;
+
+	private:
+		FILE* _file;
+		unsigned int _width;
+		unsigned int _height;
+
+		std::vector<CapturedModel> _models;
+		std::vector<CapturedLight> _lights;
+		std::vector<CapturedFrame> _frames;
+
+		// What the models and lights are while recording.
+		std::vector<Model3D*> _recordedModels;
+		std::vector<Light*> _recordedLights;
+		CapturedFrame _frame;
+
+		void AddLight(Light* light, CapturedLightType type);
+		bool ReadFrame(FILE* file, long fileSize, CapturedFrame& frame);
+
+		static bool WriteString(FILE* file, const std::string& text);
+		static bool ReadString(FILE* file, std::string& text);
+};
@@ -0,0 +1,68 @@
+// =========================================================================================
+//	InstanceBufferPool.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "InstanceBufferPool.h"
+
+// Constructor.
+InstanceBufferPool::InstanceBufferPool(void)
+{
+}
+
+// Destructor. Buffers still acquired are deleted too, so the pool must outlive its users.
+InstanceBufferPool::~InstanceBufferPool(void)
+{
+	for (unsigned int i = 0; i < _buffers.size(); i++)
+		delete _buffers[i];
+	_buffers.clear();
+	_freeBuffers.clear();
+}
+
+// Returns a free set of buffers, creating a new one if they are all in use.
+InstanceBuffers* InstanceBufferPool::Acquire()
+{
+	if (_freeBuffers.size() > 0)
+	{
+		InstanceBuffers* buffers = _freeBuffers.back();
+		_freeBuffers.pop_back();
+		return buffers;
+	}
+
+	// The free list is grown along with the pool, so releasing never has to grow it.
+	InstanceBuffers* buffers = new InstanceBuffers();
+	_buffers.push_back(buffers);
+	_freeBuffers.reserve(_buffers.size());
+	return buffers;
+}
+
+// Returns a set of buffers to the pool.
+void InstanceBufferPool::Release(InstanceBuffers* buffers)
+{
+	if (buffers != NULL)
+		_freeBuffers.push_back(buffers);
+}
+
+// Accessor methods.
+unsigned int InstanceBufferPool::GetBufferCount()
+{
+	return _buffers.size();
+}
+
+// Works out the memory held by the lists of every buffer in the pool.
+unsigned int InstanceBufferPool::GetBytesAllocated()
+{
+	unsigned int bytes = 0;
+	for (unsigned int i = 0; i < _buffers.size(); i++)
+	{
+		InstanceBuffers* buffers = _buffers[i];
+		bytes += sizeof(InstanceBuffers);
+		bytes += buffers->transformedVertices.capacity() * sizeof(Vertex);
+		bytes += buffers->polygons.capacity() * sizeof(Polygon3D);
+		bytes += buffers->clippedUVCoordinates.capacity() * sizeof(UVCoordinate);
+	}
+	return bytes;
+}
@@ -0,0 +1,42 @@
+// =========================================================================================
+//	InstanceBufferPool.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Vertex.h"
+#include "Polygon3D.h"
+#include "UVCoordinate.h"
+#include <vector>
+
+// The per-frame results of transforming, lighting and clipping a model instance.
+// Polygons hold the flags, colour and depth order of this frame, clipping appends the
+// polygons, vertexs and uv coordinates it generates to the end of the lists.
+struct InstanceBuffers
+{
+	std::vector<Vertex> transformedVertices;
+	std::vector<Polygon3D> polygons;
+	std::vector<UVCoordinate> clippedUVCoordinates;
+};
+
+// This class hands out instance buffers and takes them back once the instance has
+// been drawn, so only as many buffers exist as instances are in flight at once. The
+// lists keep their memory between uses, so a frame allocates nothing once warm.
+class InstanceBufferPool
+{
+	public:
+		InstanceBufferPool(void);
+		~InstanceBufferPool(void);
+
+		InstanceBuffers* Acquire();
+		void Release(InstanceBuffers* buffers);
+
+		unsigned int GetBufferCount();
+		unsigned int GetBytesAllocated();
+
+	private:
+		std::vector<InstanceBuffers*> _buffers;
+		std::vector<InstanceBuffers*> _freeBuffers;
+};
@@ -0,0 +1,281 @@
+// =========================================================================================
+//	JobSystem.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "JobSystem.h"
+
+// The job system and worker index of the current thread, set by each worker thread.
+static thread_local JobSystem* CurrentJobSystem = NULL;
+static thread_local int CurrentWorker = 0;
+
+// No-Argument Constructor. Declared private, should not get called.
+JobSystem::JobSystem(void)
+{
+}
+
+// Constructor. Starts the given number of workers, including the calling thread. A
+// worker count of 0 or less starts one worker for each hardware thread.
+JobSystem::JobSystem(int workerCount)
+{
+	if (workerCount <= 0)
+		workerCount = GetHardwareWorkerCount();
+
+	_workerCount = workerCount;
+	_queues = new WorkerQueue[_workerCount];
+	for (int i = 0; i < _workerCount; i++)
+		_queues[i].jobs.resize(JOB_QUEUE_START_SIZE);
+	_queuedJobs = 0;
+	_shutdown = false;
+	_jobsExecuted = 0;
+	_jobsStolen = 0;
+
+	for (int i = 1; i < _workerCount; i++)
+		_threads.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+}
+
+// Destructor. Waits for the workers to finish the job they are running and stops them,
+// any jobs still queued are not run.
+JobSystem::~JobSystem(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_shutdown = true;
+	}
+	_wake.notify_all();
+
+	for (unsigned int i = 0; i < _threads.size(); i++)
+		_threads[i].join();
+	_threads.clear();
+
+	delete [] _queues;
+	_queues = NULL;
+}
+
+// Accessor methods.
+int JobSystem::GetWorkerCount()
+{
+	return _workerCount;
+}
+unsigned int JobSystem::GetJobsExecuted()
+{
+	return _jobsExecuted;
+}
+unsigned int JobSystem::GetJobsStolen()
+{
+	return _jobsStolen;
+}
+
+// Returns the number of hardware threads, at least 1.
+int JobSystem::GetHardwareWorkerCount()
+{
+	int count = (int)std::thread::hardware_concurrency();
+	return max(count, 1);
+}
+
+// Queues a job to run the function over the range [begin, end). The counter is incremented
+// now and decremented once the job is done. If a dependency is given the job is not queued
+// until that counter reaches zero.
+void JobSystem::Run(JobFunction function, void* data, int begin, int end, JobCounter* counter, JobCounter* dependency)
+{
+	Job job;
+	job.function = function;
+	job.data = data;
+	job.begin = begin;
+	job.end = end;
+	job.counter = counter;
+
+	if (counter != NULL)
+		counter->value++;
+
+	if (dependency != NULL)
+	{
+		// The counter reaching zero takes the waiting jobs under the same lock, so
+		// the job is either held back here or queued now, never lost.
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (dependency->value > 0)
+		{
+			dependency->waitingJobs.push_back(job);
+			return;
+		}
+	}
+
+	Push(job);
+}
+
+// Runs queued jobs until the counter reaches zero.
+void JobSystem::Wait(JobCounter* counter)
+{
+	int worker = GetCurrentWorker();
+	while (counter->value > 0)
+	{
+		Job job;
+		if (GetJob(worker, job) == true)
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	// The last job releases the counters lock just after it reaches zero, wait for
+	// it so the counter can be destroyed as soon as this returns.
+	std::lock_guard<std::mutex> lock(counter->mutex);
+}
+
+// Calls the function over the range [0, count), split into jobs of grainSize indexs, and
+// returns once they have all finished. A grain size of 0 or less splits the range into a
+// few jobs for each worker.
+void JobSystem::ParallelFor(int count, int grainSize, JobFunction function, void* data)
+{
+	if (count <= 0)
+		return;
+	if (grainSize <= 0)
+		grainSize = max(1, count / (_workerCount * 4));
+
+	// Nothing to share out, run it here.
+	if (_workerCount == 1 || count <= grainSize)
+	{
+		function(data, 0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (int begin = 0; begin < count; begin += grainSize)
+		Run(function, data, begin, min(begin + grainSize, count), &counter);
+	Wait(&counter);
+}
+
+// Returns the worker the calling thread is, threads that are not workers share worker 0.
+int JobSystem::GetCurrentWorker()
+{
+	if (CurrentJobSystem == this)
+		return CurrentWorker;
+	return 0;
+}
+
+// Adds a job to the queue of the calling worker and wakes a sleeping worker to take it.
+void JobSystem::Push(const Job& job)
+{
+	// Count the job first so no worker goes to sleep while it is being added.
+	_queuedJobs++;
+
+	WorkerQueue& queue = _queues[GetCurrentWorker()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == queue.jobs.size())
+			GrowQueue(queue);
+		queue.jobs[(queue.head + queue.count) % queue.jobs.size()] = job;
+		queue.count++;
+	}
+
+	if (_workerCount > 1)
+	{
+		// Taking the lock makes sure a worker about to sleep sees the new job first.
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+		}
+		_wake.notify_one();
+	}
+}
+
+// Doubles the space in a full queue, moving its jobs to the start of the new space. Called
+// with the queues lock held.
+void JobSystem::GrowQueue(WorkerQueue& queue)
+{
+	std::vector<Job> jobs(queue.jobs.size() * 2);
+	for (unsigned int i = 0; i < queue.count; i++)
+		jobs[i] = queue.jobs[(queue.head + i) % queue.jobs.size()];
+	queue.jobs.swap(jobs);
+	queue.head = 0;
+}
+
+// Takes the newest job from the workers own queue, or steals the oldest job from another
+// worker. Returns false if every queue is empty.
+bool JobSystem::GetJob(int worker, Job& job)
+{
+	if (_queuedJobs == 0)
+		return false;
+
+	for (int i = 0; i < _workerCount; i++)
+	{
+		int victim = (worker + i) % _workerCount;
+		WorkerQueue& queue = _queues[victim];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == 0)
+			continue;
+
+		if (victim == worker)
+		{
+			job = queue.jobs[(queue.head + queue.count - 1) % queue.jobs.size()];
+		}
+		else
+		{
+			job = queue.jobs[queue.head];
+			queue.head = (queue.head + 1) % queue.jobs.size();
+			_jobsStolen++;
+		}
+		queue.count--;
+		_queuedJobs--;
+		return true;
+	}
+	return false;
+}
+
+// Runs a job, then decrements its counter and queues the jobs that were waiting on it.
+void JobSystem::Execute(Job& job)
+{
+	job.function(job.data, job.begin, job.end);
+	_jobsExecuted++;
+
+	JobCounter* counter = job.counter;
+	if (counter == NULL)
+		return;
+
+	// Take the waiting jobs under the same lock the counter reaches zero in, so
+	// jobs made to depend on it at the same time are either taken or not held back.
+	std::vector<Job> released;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->value == 1)
+			released.swap(counter->waitingJobs);
+		counter->value--;
+	}
+
+	for (unsigned int i = 0; i < released.size(); i++)
+		Push(released[i]);
+}
+
+// Main loop of each worker thread other than worker 0.
+void JobSystem::WorkerMain(int worker)
+{
+	CurrentJobSystem = this;
+	CurrentWorker = worker;
+
+	int spins = 0;
+	while (_shutdown == false)
+	{
+		Job job;
+		if (GetJob(worker, job) == true)
+		{
+			Execute(job);
+			spins = 0;
+			continue;
+		}
+
+		// Keep looking for a while before sleeping, jobs tend to arrive in bursts.
+		if (spins < JOB_SPIN_COUNT)
+		{
+			spins++;
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		while (_queuedJobs == 0 && _shutdown == false)
+			_wake.wait(lock);
+		spins = 0;
+	}
+}
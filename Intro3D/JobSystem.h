@@ -0,0 +1,103 @@
+// =========================================================================================
+//	JobSystem.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Number of times an idle worker looks for work to steal before it goes to sleep.
+#define JOB_SPIN_COUNT			64
+
+// Jobs each workers queue has space for before it has to grow.
+#define JOB_QUEUE_START_SIZE	256
+
+// Function run by a job, over the index range [begin, end).
+typedef void (*JobFunction)(void* data, int begin, int end);
+
+struct JobCounter;
+
+// A piece of work, and the counter to decrement once it is done.
+struct Job
+{
+	JobFunction function;
+	void* data;
+	int begin;
+	int end;
+	JobCounter* counter;
+};
+
+// Counts the jobs run with it that have not finished yet. Jobs can be made to depend on
+// a counter, they are held back until it reaches zero.
+struct JobCounter
+{
+	std::atomic<int> value;
+	std::mutex mutex;
+	std::vector<Job> waitingJobs;
+
+	JobCounter() : value(0) {}
+};
+
+// This class runs jobs on a fixed set of worker threads. Each worker has its own queue,
+// it takes the newest job from its own queue and steals the oldest from the others when
+// that is empty. The thread that made the job system is worker 0, it runs jobs while it
+// waits on a counter, so a job system with one worker runs everything on that thread.
+class JobSystem
+{
+	public:
+		JobSystem(int workerCount);
+		~JobSystem(void);
+
+		int GetWorkerCount();
+		int GetCurrentWorker();
+		unsigned int GetJobsExecuted();
+		unsigned int GetJobsStolen();
+
+		void Run(JobFunction function, void* data, int begin, int end, JobCounter* counter, JobCounter* dependency = NULL);
+		void Wait(JobCounter* counter);
+		void ParallelFor(int count, int grainSize, JobFunction function, void* data);
+
+		static int GetHardwareWorkerCount();
+
+	private:
+		// Queue of a single worker, the owner uses the back and thieves the front. The jobs
+		// are a ring of count jobs starting at head, that only grows when it is full, so
+		// queueing a job allocates nothing once the queues are as big as they need to be.
+		struct WorkerQueue
+		{
+			std::mutex mutex;
+			std::vector<Job> jobs;
+			unsigned int head;
+			unsigned int count;
+
+			WorkerQueue() : head(0), count(0) {}
+		};
+
+		int _workerCount;
+		WorkerQueue* _queues;
+		std::vector<std::thread> _threads;
+
+		// Idle workers sleep until there are jobs queued.
+		std::mutex _sleepMutex;
+		std::condition_variable _wake;
+		std::atomic<int> _queuedJobs;
+		std::atomic<bool> _shutdown;
+
+		std::atomic<unsigned int> _jobsExecuted;
+		std::atomic<unsigned int> _jobsStolen;
+
+		void Push(const Job& job);
+		void GrowQueue(WorkerQueue& queue);
+		bool GetJob(int worker, Job& job);
+		void Execute(Job& job);
+		void WorkerMain(int worker);
+
+		// Private constructor. Should not be used directly.
+		JobSystem(void);
+};
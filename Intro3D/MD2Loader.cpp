@@ -272,8 +272,8 @@ bool MD2Loader::LoadModel(const char* filename, Model3D& model, const char* text
 		}
 	}
 
-	// Rebuild model lists.
-	model.RebuildTransformedVerticesList();
+	// Work out the models bounds.
+	model.CalculateBounds();
 
 	// Free dynamically allocated memory
 	delete [] triangles; // NOTE: this is 'array' delete. Must be sure to use this
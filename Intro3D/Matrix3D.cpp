@@ -124,6 +124,26 @@ const Vertex Matrix3D::operator*(const Vertex &p) const
 	return vert;
 }
 
+// Returns the element at the given row and column, as the matrix is written out.
+float Matrix3D::GetElement(int row, int column) const
+{
+	return _elements[column][row];
+}
+
+// Returns the largest amount the matrix scales any axis by.
+float Matrix3D::GetMaxScale() const
+{
+	float maxScale = 0.0f;
+	for (int column = 0; column < 3; column++)
+	{
+		float scale = sqrt((_elements[column][0] * _elements[column][0]) + 
+						   (_elements[column][1] * _elements[column][1]) + 
+						   (_elements[column][2] * _elements[column][2]));
+		maxScale = max(maxScale, scale);
+	}
+	return maxScale;
+}
+
 // Copys the values from one matrix to another.
 void Matrix3D::Copy(const Matrix3D& mat)
 {
@@ -34,6 +34,9 @@ class Matrix3D
 		static Matrix3D IdentityMatrix();
 		static Matrix3D ZeroMatrix();
 
+		float GetElement(int row, int column) const;
+		float GetMaxScale() const;
+
 	private:
 		float _elements[4][4];
 		
@@ -7,18 +7,6 @@
 
 #include "StdAfx.h"
 #include "Model3D.h"
-#include <algorithm>
-
-// This struct is used to sort polygon lists by depth.
-struct SortPolygonsByDepth 
-{
-    bool operator() (const Polygon3D& lhs, const Polygon3D& rhs) 
-	{
-        float ld = lhs.GetAvgDepth();
-		float rd = rhs.GetAvgDepth();
-		return ld > rd;
-    }
-};
 
 // Constructor.
 Model3D::Model3D(void)
@@ -30,6 +18,20 @@ Model3D::Model3D(void)
 	_texture = NULL;
 	_palette = NULL;
 	_textureWidth = 0;
+
+	_normalMapTexture = NULL;
+	_normalMapPalette = NULL;
+	_normalMapTextureWidth = 0;
+	_normalMapOn = false;
+
+	_colormap = NULL;
+	_redColormap = NULL;
+	_greenColormap = NULL;
+	_blueColormap = NULL;
+	_colormapLightLevels = 0;
+	_colormapOn = false;
+
+	_boundingSphereRadius = 0.0f;
 }
 
 // Destructor.
@@ -39,6 +41,7 @@ Model3D::~Model3D()
 		delete [] _texture;
 	if (_palette != NULL)
 		delete [] _palette;
+	FreeColormap();
 }
 
 // Accessor methods. Simple get/set code.
@@ -74,6 +77,23 @@ bool Model3D::GetNormalMapOn()
 {
 	return _normalMapOn;
 }
+void Model3D::GetColormap(unsigned int** colormap, BYTE** redColormap, BYTE** greenColormap, BYTE** blueColormap, int* lightLevels)
+{
+	*colormap = _colormap;
+	*redColormap = _redColormap;
+	*greenColormap = _greenColormap;
+	*blueColormap = _blueColormap;
+	*lightLevels = _colormapLightLevels;
+}
+void Model3D::SetColormapOn(bool val)
+{
+	_colormapOn = val;
+}
+bool Model3D::GetColormapOn()
+{
+	// Only report colormap shading as on if the tables have been built.
+	return _colormapOn && _colormapLightLevels > 0;
+}
 std::vector<Polygon3D>& Model3D::GetPolygonList()
 {
 	return _polygons;
@@ -86,10 +106,6 @@ std::vector<Vertex>& Model3D::GetVertexList()
 {
 	return _vertices;
 }
-std::vector<Vertex>& Model3D::GetTransformedVertexList()
-{
-	return _transformedVertices;
-}
 void Model3D::SetReflectionCoefficients(float ka, float kd, float ks)
 {
 	_kd_red = ka;
@@ -103,100 +119,168 @@ void Model3D::GetReflectionCoefficients(float& r, float& g, float& b)
 	b = _kd_blue;
 }
 
-// Applys the given matrix transformation to the un-transformated vertices
-// and pushes them into the transformed vertices list.
-void Model3D::ApplyTransformToLocalVertices(const Matrix3D& transform)
+// Works out the bounding sphere and axis aligned bounding box of the local vertices.
+void Model3D::CalculateBounds()
 {
-	_transformedVertices.clear();
-	for (unsigned int i = 0; i < _vertices.size(); i++)
-		_transformedVertices.push_back(transform * _vertices[i]);
-}
+	if (_vertices.size() == 0)
+	{
+		_aabbMin = Vector3D(0, 0, 0);
+		_aabbMax = Vector3D(0, 0, 0);
+		_boundingSphereCenter = Vector3D(0, 0, 0);
+		_boundingSphereRadius = 0.0f;
+		return;
+	}
 
-// Applys the given matrix transformation to the transformated vertices.
-void Model3D::ApplyTransformToTransformedVertices(const Matrix3D& transform)
-{
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
+	float minX = _vertices[0].GetX(), minY = _vertices[0].GetY(), minZ = _vertices[0].GetZ();
+	float maxX = minX, maxY = minY, maxZ = minZ;
+	for (unsigned int i = 1; i < _vertices.size(); i++)
 	{
-		Vertex retVal = transform * _transformedVertices[i];
-		_transformedVertices[i] = retVal;
+		Vertex& vertex = _vertices[i];
+		minX = min(minX, vertex.GetX());
+		minY = min(minY, vertex.GetY());
+		minZ = min(minZ, vertex.GetZ());
+		maxX = max(maxX, vertex.GetX());
+		maxY = max(maxY, vertex.GetY());
+		maxZ = max(maxZ, vertex.GetZ());
 	}
-}
+	_aabbMin = Vector3D(minX, minY, minZ);
+	_aabbMax = Vector3D(maxX, maxY, maxZ);
 
-// Resets the transformed vertices list to their non-transformed positions.
-void Model3D::RebuildTransformedVerticesList()
-{
+	// The sphere is centered on the box and reaches the furthest vertex.
+	_boundingSphereCenter = Vector3D((minX + maxX) * 0.5f, (minY + maxY) * 0.5f, (minZ + maxZ) * 0.5f);
+	_boundingSphereRadius = 0.0f;
 	for (unsigned int i = 0; i < _vertices.size(); i++)
-		_transformedVertices.push_back(_vertices[i]);
+	{
+		Vector3D offset = Vector3D(_vertices[i].GetX() - _boundingSphereCenter.GetX(), 
+								   _vertices[i].GetY() - _boundingSphereCenter.GetY(), 
+								   _vertices[i].GetZ() - _boundingSphereCenter.GetZ());
+		_boundingSphereRadius = max(_boundingSphereRadius, offset.GetLength());
+	}
+}
+void Model3D::GetBoundingSphere(Vector3D& center, float& radius)
+{
+	center = _boundingSphereCenter;
+	radius = _boundingSphereRadius;
+}
+void Model3D::GetAABB(Vector3D& min, Vector3D& max)
+{
+	min = _aabbMin;
+	max = _aabbMax;
 }
 
-// Dehomohenizes each vertice in the transformed vertices list.
-void Model3D::DehomogenizeTransformedVertices()
+// Works out the bounding sphere of the model once transformed by the given matrix.
+void Model3D::GetWorldBoundingSphere(const Matrix3D& transform, Vector3D& center, float& radius)
 {
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-		_transformedVertices[i].Dehomogenize();
+	Vertex worldCenter = transform * Vertex(_boundingSphereCenter.GetX(), _boundingSphereCenter.GetY(), _boundingSphereCenter.GetZ(), 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0);
+	center = Vector3D(worldCenter.GetX(), worldCenter.GetY(), worldCenter.GetZ());
+	radius = _boundingSphereRadius * transform.GetMaxScale();
 }
 
-// Goes through each polygon and flags those that are backfacing from given camera position.
-void Model3D::CalculateBackfaces(Camera* camera)
+// Works out the axis aligned box that contains each corner of the models box once
+// transformed by the given matrix.
+void Model3D::GetWorldAABB(const Matrix3D& transform, Vector3D& worldMin, Vector3D& worldMax)
 {
-	for (unsigned int i = 0; i < _polygons.size(); i++)
+	for (int i = 0; i < 8; i++)
 	{
-		Polygon3D polygon = _polygons[i];
-		Vertex v1 = _transformedVertices[polygon.GetVertexIndex(0)];
-		Vertex v2 = _transformedVertices[polygon.GetVertexIndex(1)];
-		Vertex v3 = _transformedVertices[polygon.GetVertexIndex(2)];
-	
-		// Get the polygons normal by working out the cross product of
-		// the vectors from the first vertex to each of the other vertexs.
-		Vector3D a = Vertex::GetVector(v1, v2);
-		Vector3D b = Vertex::GetVector(v1, v3);
-		Vector3D normal = Vector3D::CrossProduct(a, b);
-
-		// Work out the vector between the camera and the first vertex. (should be changed to middle of polygon not first vertex).
-		Vector3D eyeVector = Vertex::GetVector(v1, camera->GetPosition());
-
-		// Work out the dot product of the eye vector and the polygons normal.
-		float dotProduct = Vector3D::DotProduct(eyeVector, normal);
-
-		// If the dot product is less than 0, then polygon is backfacing, otherwise not.
-		if (dotProduct < 0)
-			_polygons[i].SetBackfacing(true);
-		else
-			_polygons[i].SetBackfacing(false);
+		Vertex corner = transform * Vertex((i & 1) ? _aabbMax.GetX() : _aabbMin.GetX(),
+										   (i & 2) ? _aabbMax.GetY() : _aabbMin.GetY(),
+										   (i & 4) ? _aabbMax.GetZ() : _aabbMin.GetZ(),
+										   1, Gdiplus::Color::Black, Vector3D(0,0,0), 0);
+		if (i == 0)
+		{
+			worldMin = Vector3D(corner.GetX(), corner.GetY(), corner.GetZ());
+			worldMax = worldMin;
+			continue;
+		}
+		worldMin = Vector3D(min(worldMin.GetX(), corner.GetX()), min(worldMin.GetY(), corner.GetY()), min(worldMin.GetZ(), corner.GetZ()));
+		worldMax = Vector3D(max(worldMax.GetX(), corner.GetX()), max(worldMax.GetY(), corner.GetY()), max(worldMax.GetZ(), corner.GetZ()));
 	}
 }
 
-// Sorts the polygon list by depth.
-void Model3D::DepthSort()
+// Tests the models bounds against the cameras view frustum, after transforming them by the
+// given matrix. The sphere is tested first as it is cheap, the box is only tested if the 
+// sphere is intersecting the frustum as it fits the model more tightly.
+FrustumTest Model3D::TestFrustum(Camera* camera, const Matrix3D& transform)
 {
-	// Calculate average Z depths.
-	for (unsigned int i = 0; i < _polygons.size(); i++)
-	{
-		Polygon3D polygon = _polygons[i];
-		
-		// Calculate the sum of all vertex Z coordinates.
-		float depthSum = 0;
-		for (int j = 0; j < 3; j++)
-			depthSum += _transformedVertices[polygon.GetVertexIndex(j)].GetZ();
-		
-		// Work out and set the average (sum/3).
-		depthSum /= 3.0f;
-		_polygons[i].SetAvgDepth(depthSum);
-	}
+	Vector3D center;
+	float radius;
+	GetWorldBoundingSphere(transform, center, radius);
 
-	// Sort the collection using the standard sort function.
-	std::sort(_polygons.begin(), _polygons.end(), SortPolygonsByDepth());
+	FrustumTest result = camera->TestSphere(center, radius);
+	if (result != FrustumIntersecting)
+		return result;
+
+	Vector3D worldMin, worldMax;
+	GetWorldAABB(transform, worldMin, worldMax);
+	return camera->TestAABB(worldMin, worldMax);
 }
 
-// Resets the lighting of the polygon back to black, ready for lighting calculations.
-void Model3D::ResetLighting()
+// Builds the colormap tables from the models texture palette. Each table maps a palette index and
+// a quantised light level to the lit colour, so textured shading becomes a single lookup per pixel
+// instead of a multiply and clamp per channel. If coloredLight is set a table is built for each
+// channel so coloured lights are kept, otherwise a single table of packed colours is built and
+// indexed by the average light level.
+void Model3D::BuildColormap(int lightLevels, bool coloredLight)
 {
-	for (unsigned int i = 0; i < _polygons.size(); i++)
+	FreeColormap();
+	if (_palette == NULL || lightLevels < 2)
+		return;
+
+	_colormapLightLevels = lightLevels;
+	if (coloredLight == true)
 	{
-		_polygons[i].SetColor(Gdiplus::Color::Black);
+		_redColormap = new BYTE[lightLevels * 256];
+		_greenColormap = new BYTE[lightLevels * 256];
+		_blueColormap = new BYTE[lightLevels * 256];
+	}
+	else
+		_colormap = new unsigned int[lightLevels * 256];
+
+	for (int level = 0; level < lightLevels; level++)
+	{
+		// Work out the light value this level represents. The rasterizer treats a 
+		// light value of 180 as full brightness, so brighter levels over saturate.
+		float light = ((level * 255.0f) / (lightLevels - 1)) / 180.0f;
+
+		for (int i = 0; i < 256; i++)
+		{
+			Gdiplus::Color textureColor = _palette[i];
+			BYTE finalR = (BYTE)max(0, min(255, textureColor.GetR() * light));
+			BYTE finalG = (BYTE)max(0, min(255, textureColor.GetG() * light));
+			BYTE finalB = (BYTE)max(0, min(255, textureColor.GetB() * light));
+
+			int index = (level * 256) + i;
+			if (coloredLight == true)
+			{
+				_redColormap[index] = finalR;
+				_greenColormap[index] = finalG;
+				_blueColormap[index] = finalB;
+			}
+			else
+				_colormap[index] = Gdiplus::Color::MakeARGB(255, finalR, finalG, finalB);
+		}
 	}
 }
 
+// Disposes of the colormap tables.
+void Model3D::FreeColormap()
+{
+	if (_colormap != NULL)
+		delete [] _colormap;
+	if (_redColormap != NULL)
+		delete [] _redColormap;
+	if (_greenColormap != NULL)
+		delete [] _greenColormap;
+	if (_blueColormap != NULL)
+		delete [] _blueColormap;
+
+	_colormap = NULL;
+	_redColormap = NULL;
+	_greenColormap = NULL;
+	_blueColormap = NULL;
+	_colormapLightLevels = 0;
+}
+
 // Calculates the directional lighting of a given pixel.
 Gdiplus::Color Model3D::CalculateLightingDirectionalPerPixel(std::vector<DirectionalLight*> lights, Vertex pixelPosition, Vector3D pixelNormal, Gdiplus::Color startColor)
 {
@@ -368,341 +452,3 @@ Gdiplus::Color Model3D::CalculateLightingPointPerPixel(std::vector<PointLight*>
 
 	return Gdiplus::Color((BYTE)totalR, (BYTE)totalG, (BYTE)totalB);
 }
-
-// Calculates the compound lighting of all polygons on the model from
-// the list of directional lights.
-void Model3D::CalculateLightingDirectional(std::vector<DirectionalLight*> lights)
-{
-	float totalR, totalG, totalB;
-	float tempR, tempG, tempB;
-
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-	{
-		Vertex vert = _transformedVertices[i];
-
-		// Reset total light.
-		totalR = vert.GetColor().GetR();
-		totalG = vert.GetColor().GetG();
-		totalB = vert.GetColor().GetB();
-
-		// Calculate lighting.
-		for (unsigned int j = 0; j < lights.size(); j++)
-		{
-			DirectionalLight* light = lights[j];
-			Gdiplus::Color c = light->GetIntensity();
-
-			if (light->GetEnabled() == false)
-				continue;
-
-			tempR = c.GetR();
-			tempG = c.GetG();
-			tempB = c.GetB();
-		
-			// Apply the lighting coefficients.
-			tempR *= _kd_red;
-			tempG *= _kd_green;
-			tempB *= _kd_blue;
-			
-			// Work out vector to light source.
-			Vector3D lightVector = Vertex::GetVector(vert, light->GetPosition());
-			lightVector.Normalize();
-
-			// Work out dot product.
-			float dotProduct = Vector3D::DotProduct(lightVector, vert.GetNormal());
-			if (dotProduct >= 0)
-				continue;
-
-			// Multiply the colour by the dot product.
-			tempR *= dotProduct;
-			tempG *= dotProduct;
-			tempB *= dotProduct;
-			
-			// Add the light color to the total polygon color.
-			totalR += abs(tempR);
-			totalG += abs(tempG);
-			totalB += abs(tempB);
-		}
-
-		// Clamp lighting.
-		totalR = max(min(totalR, 255.0f), 0.0f);
-		totalG = max(min(totalG, 255.0f), 0.0f);
-		totalB = max(min(totalB, 255.0f), 0.0f);
-
-		// Store color.
-		_transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
-	}
-}
-
-// Calculates the compound lighting of all polygons on the model from
-// the list of ambient lights.
-void Model3D::CalculateLightingAmbient(std::vector<AmbientLight*> lights)
-{
-	float totalR, totalG, totalB;
-	float tempR, tempG, tempB;
-
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-	{
-		Vertex vert = _transformedVertices[i];
-
-		// Reset total light.
-		totalR = vert.GetColor().GetR();
-		totalG = vert.GetColor().GetG();
-		totalB = vert.GetColor().GetB();
-
-		// Calculate lighting.
-		for (unsigned int j = 0; j < lights.size(); j++)
-		{
-			Light* light = lights[j];
-			Gdiplus::Color c = light->GetIntensity();
-
-			if (light->GetEnabled() == false)
-				continue;
-
-			// Set the temporary light color to the lights color.
-			tempR = c.GetR();
-			tempG = c.GetG();
-			tempB = c.GetB();
-		
-			// Apply the lighting coefficients.
-			tempR *= _kd_red;
-			tempG *= _kd_green;
-			tempB *= _kd_blue;
-			
-			// Add the light color to the total polygon color.
-			totalR += abs(tempR);
-			totalG += abs(tempG);
-			totalB += abs(tempB);
-		}
-
-		// Clamp lighting.
-		totalR = max(min(totalR, 255.0f), 0.0f);
-		totalG = max(min(totalG, 255.0f), 0.0f);
-		totalB = max(min(totalB, 255.0f), 0.0f);
-
-		// Store color.
-		_transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
-	}
-}
-
-// Calculates the compound lighting of all polygons on the model from
-// the list of point lights.
-void Model3D::CalculateLightingPoint(std::vector<PointLight*> lights)
-{
-	float totalR, totalG, totalB;
-	float tempR, tempG, tempB;
-
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-	{
-		Vertex vert = _transformedVertices[i];
-
-		// Reset total light.
-		totalR = vert.GetColor().GetR();
-		totalG = vert.GetColor().GetG();
-		totalB = vert.GetColor().GetB();
-
-		// Calculate lighting.
-		for (unsigned int j = 0; j < lights.size(); j++)
-		{
-			PointLight* light = lights[j];
-			Gdiplus::Color c = light->GetIntensity();
-
-			if (light->GetEnabled() == false)
-				continue;
-			
-			// Set the temporary light color to the lights color.
-			tempR = c.GetR();
-			tempG = c.GetG();
-			tempB = c.GetB();
-		
-			// Apply the lighting coefficients.
-			tempR *= _kd_red;
-			tempG *= _kd_green;
-			tempB *= _kd_blue;
-			
-			// Work out vector to light source.
-			Vector3D lightVector = Vertex::GetVector(vert, light->GetPosition());
-			float distance = lightVector.GetLength();
-			lightVector.Normalize();
-
-			// Work out attenuation.
-			float attnA, attnB, attnC;
-			light->GetAttenuation(attnA, attnB, attnC);
-
-			float attenuation = 1 / (attnA + attnB * distance + attnC * (distance * distance));
-			attenuation *= 100;
-
-			// Work out dot product.
-			float dotProduct = Vector3D::DotProduct(lightVector, vert.GetNormal());
-			if (dotProduct >= 0)
-				continue;
-
-			// Apply the dot product to the temporary light color.
-			tempR *= dotProduct;
-			tempG *= dotProduct;
-			tempB *= dotProduct;
-			
-			// Apply the attenuation to the temporary light color.
-			tempR *= attenuation;
-			tempG *= attenuation;
-			tempB *= attenuation;
-			
-			// Add the light color to the total polygon color.
-			totalR += abs(tempR);
-			totalG += abs(tempG);
-			totalB += abs(tempB);
-		}
-
-		// Clamp lighting.
-		totalR = max(min(totalR, 255.0f), 0.0f);
-		totalG = max(min(totalG, 255.0f), 0.0f);
-		totalB = max(min(totalB, 255.0f), 0.0f);
-
-		// Store color.
-		_transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
-	}
-}
-
-// Calculates the compound lighting of all polygons on the model from
-// the list of spot lights.
-void Model3D::CalculateLightingSpot(std::vector<SpotLight*> lights)
-{
-	float totalR, totalG, totalB;
-	float tempR, tempG, tempB;
-
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-	{
-		Vertex vert = _transformedVertices[i];
-
-		// Reset total light.
-		totalR = vert.GetColor().GetR();
-		totalG = vert.GetColor().GetG();
-		totalB = vert.GetColor().GetB();
-
-		// Calculate lighting.
-		for (unsigned int j = 0; j < lights.size(); j++)
-		{
-			SpotLight* light = lights[j];
-			Gdiplus::Color c = light->GetIntensity();
-
-			if (light->GetEnabled() == false)
-				continue;
-			
-			// Set the temporary light color to the lights color.
-			tempR = c.GetR();
-			tempG = c.GetG();
-			tempB = c.GetB();
-		
-			// Apply the lighting coefficients.
-			tempR *= _kd_red;
-			tempG *= _kd_green;
-			tempB *= _kd_blue;
-			
-			// Work out vector to light source.
-			Vector3D lightVector = Vertex::GetVector(vert, light->GetPosition());
-			float distance = lightVector.GetLength();
-			lightVector.Normalize();
-
-			// Work out attenuation.
-			float attnA, attnB, attnC;
-			light->GetAttenuation(attnA, attnB, attnC);
-
-			float attenuation = 1 / (attnA + attnB * distance + attnC * (distance * distance));
-			attenuation *= 100;
-
-			// Work out dot product.
-			float dotProduct = Vector3D::DotProduct(lightVector, vert.GetNormal());
-			if (dotProduct >= 0)
-				continue;
-
-			// Work out spotlight value.
-			float spotValue = 1.0f;//light->SmoothStep(cos(light->GetAngle()), cos());
-
-			// Apply the dot product to the temporary light color.
-			tempR *= dotProduct;
-			tempG *= dotProduct;
-			tempB *= dotProduct;
-			
-			// Apply the attenuation to the temporary light color.
-			tempR *= attenuation;
-			tempG *= attenuation;
-			tempB *= attenuation;
-
-			// Apply spotlight value.
-			tempR *= spotValue;
-			tempG *= spotValue;
-			tempB *= spotValue;
-			
-			// Add the light color to the total polygon color.
-			totalR += abs(tempR);
-			totalG += abs(tempG);
-			totalB += abs(tempB);
-		}
-
-		// Clamp lighting.
-		totalR = max(min(totalR, 255.0f), 0.0f);
-		totalG = max(min(totalG, 255.0f), 0.0f);
-		totalB = max(min(totalB, 255.0f), 0.0f);
-
-		// Store color.
-		_transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
-	}
-}
-
-// Calculates the normals of all transformed vertexs in the model. 
-void Model3D::CalculateVertexNormals()
-{
-	// Reset all the normals and normal counts of all 
-	// transformed vertices to default.
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-	{
-		_transformedVertices[i].SetNormal(Vector3D(0, 0, 0));
-		_transformedVertices[i].SetNormalCount(0);
-	}
-
-	// Work out the normal sum for each vertex in the polygon.
-	for (unsigned int i = 0; i < _polygons.size(); i++)
-	{
-		Polygon3D polygon = _polygons[i];
-
-		// Work out normal.
-		Vertex v1 = _transformedVertices[polygon.GetVertexIndex(0)];
-		Vertex v2 = _transformedVertices[polygon.GetVertexIndex(1)];
-		Vertex v3 = _transformedVertices[polygon.GetVertexIndex(2)];
-		Vector3D a = Vertex::GetVector(v1, v2);
-		Vector3D b = Vertex::GetVector(v1, v3);
-		Vector3D polyNormal = Vector3D::CrossProduct(a, b);
-
-		// Update normals.
-		for (int j = 0; j < 3; j++)
-		{
-			int index = polygon.GetVertexIndex(j);
-			Vertex v = _transformedVertices[index]; 
-			Vector3D vNormal = v1.GetNormal();
-
-			// Adds the vertex normal to the polygons current normal.
-			// Increments the normal count.
-			_transformedVertices[index].SetNormal(Vector3D(vNormal.GetX() + polyNormal.GetX(),
-												  vNormal.GetY() + polyNormal.GetY(),
-												  vNormal.GetZ() + polyNormal.GetZ()));
-			_transformedVertices[index].SetNormalCount(v.GetNormalCount() + 1);
-		}
-	}
-
-	// Work out the normal for each of the transformed vertices.
-	for (unsigned int i = 0; i < _transformedVertices.size(); i++)
-	{
-		Vertex v = _transformedVertices[i]; 
-
-		// Work out the normal for the vertex's by dividing the normal sum
-		// by the normal count.
-		_transformedVertices[i].SetNormal(Vector3D(v.GetX() / v.GetNormalCount(),
-										v.GetY() / v.GetNormalCount(),
-										v.GetZ() / v.GetNormalCount()));
-
-		// Normalize the vector and apply it to the transformed vertices.
-		Vector3D n = _transformedVertices[i].GetNormal();
-		n.Normalize();
-		_transformedVertices[i].SetNormal(Vector3D(-n.GetX(), -n.GetY(), -n.GetZ()));
-	}
-}
-
@@ -42,8 +42,10 @@ struct PcxHeader
 	BYTE  Filler[58];
 };
 
-// This is the model class it's responsible for storing all the data required
-// to render a model to the screne.
+// This is the model class it's responsible for storing the mesh data required
+// to render a model to the screne. The vertices, polygons, uv coordinates and textures
+// never change once loaded, so any number of model instances can share them. The 
+// per-frame results of drawing the model are kept by each instance.
 class Model3D
 {
 	public:
@@ -53,7 +55,6 @@ class Model3D
 		std::vector<Polygon3D>& GetPolygonList();
 		std::vector<Vertex>& GetVertexList();
 		std::vector<UVCoordinate>& GetUVCoordinateList();
-		std::vector<Vertex>& GetTransformedVertexList();
 		
 		void SetTexture(BYTE* texture, Gdiplus::Color* palette, int textureWidth);
 		void GetTexture(BYTE** texture, Gdiplus::Color** palette, int* textureWidth);
@@ -64,39 +65,38 @@ class Model3D
 		void SetNormalMapOn(bool val);
 		bool GetNormalMapOn();
 
-		void ApplyTransformToLocalVertices(const Matrix3D& transform);
-		void ApplyTransformToTransformedVertices(const Matrix3D& transform);
-		void RebuildTransformedVerticesList();
-		
-		void DehomogenizeTransformedVertices();
+		void BuildColormap(int lightLevels, bool coloredLight);
+		void GetColormap(unsigned int** colormap, BYTE** redColormap, BYTE** greenColormap, BYTE** blueColormap, int* lightLevels);
+		void SetColormapOn(bool val);
+		bool GetColormapOn();
 
-		void CalculateBackfaces(Camera* camera);
-		void DepthSort();
+		void CalculateBounds();
+		void GetBoundingSphere(Vector3D& center, float& radius);
+		void GetAABB(Vector3D& min, Vector3D& max);
+		void GetWorldBoundingSphere(const Matrix3D& transform, Vector3D& center, float& radius);
+		void GetWorldAABB(const Matrix3D& transform, Vector3D& worldMin, Vector3D& worldMax);
+		FrustumTest TestFrustum(Camera* camera, const Matrix3D& transform);
 
 		void SetReflectionCoefficients(float r, float g, float b);
 		void GetReflectionCoefficients(float& r, float& g, float& b);
 
-		void ResetLighting();
-		void CalculateLightingDirectional(std::vector<DirectionalLight*> lights);
-		void CalculateLightingAmbient(std::vector<AmbientLight*> lights);
-		void CalculateLightingPoint(std::vector<PointLight*> lights);
-		void CalculateLightingSpot(std::vector<SpotLight*> lights);
-		
 		Gdiplus::Color CalculateLightingDirectionalPerPixel(std::vector<DirectionalLight*> lights, Vertex pixelPosition, Vector3D pixelNormal, Gdiplus::Color startColor);
 		Gdiplus::Color CalculateLightingAmbientPerPixel(std::vector<AmbientLight*> lights, Vertex pixelPosition, Vector3D pixelNormal, Gdiplus::Color startColor);
 		Gdiplus::Color CalculateLightingPointPerPixel(std::vector<PointLight*> lights, Vertex pixelPosition, Vector3D pixelNormal, Gdiplus::Color startColor);
 
-		void CalculateVertexNormals();
-
 	private:
 		std::vector<Polygon3D> _polygons;
 		std::vector<Vertex> _vertices;	
 		std::vector<UVCoordinate> _uvCoordinates;
 
-		std::vector<Vertex> _transformedVertices;
-
 		float _kd_red, _kd_green, _kd_blue; // Reflection coefficients
 
+		// Bounding volumes of the local vertices, worked out when the model is loaded.
+		Vector3D _boundingSphereCenter;
+		float _boundingSphereRadius;
+		Vector3D _aabbMin;
+		Vector3D _aabbMax;
+
 		BYTE* _texture;
 		Gdiplus::Color* _palette;
 		int _textureWidth;
@@ -106,4 +106,14 @@ class Model3D
 		int _normalMapTextureWidth;
 
 		bool _normalMapOn;
+
+		// Colormap tables, indexed by [light level * 256 + palette index].
+		unsigned int* _colormap;
+		BYTE* _redColormap;
+		BYTE* _greenColormap;
+		BYTE* _blueColormap;
+		int _colormapLightLevels;
+		bool _colormapOn;
+
+		void FreeColormap();
 };
@@ -0,0 +1,723 @@
+// =========================================================================================
+//	ModelInstance.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "ModelInstance.h"
+#include <algorithm>
+
+// This struct is used to sort polygon lists by depth.
+struct SortPolygonsByDepth 
+{
+    bool operator() (const Polygon3D& lhs, const Polygon3D& rhs) 
+	{
+        float ld = lhs.GetAvgDepth();
+		float rd = rhs.GetAvgDepth();
+		return ld > rd;
+    }
+};
+
+// Planes that polygons are clipped against in homogeneous space.
+enum ClipPlane
+{
+	ClipPlaneNear,
+	ClipPlaneLeft,
+	ClipPlaneRight,
+	ClipPlaneBottom,
+	ClipPlaneTop
+};
+
+// Number of clip planes, and the most vertexs a triangle can have once clipped by all of them.
+#define CLIP_PLANE_COUNT		5
+#define MAX_CLIP_VERTICES		(3 + CLIP_PLANE_COUNT)
+
+// Returns the distance of a homogeneous vertex inside the given plane, negative if it is 
+// outside. The side planes are scaled by the given multiple of the view frustum.
+static float GetClipDistance(Vertex& vertex, int plane, float nearPlane, float scale)
+{
+	switch (plane)
+	{
+		case ClipPlaneNear:		return vertex.GetW() - nearPlane;
+		case ClipPlaneLeft:		return (vertex.GetW() * scale) + vertex.GetX();
+		case ClipPlaneRight:	return (vertex.GetW() * scale) - vertex.GetX();
+		case ClipPlaneBottom:	return (vertex.GetW() * scale) + vertex.GetY();
+		case ClipPlaneTop:		return (vertex.GetW() * scale) - vertex.GetY();
+	}
+	return 0.0f;
+}
+
+// Returns a bit for each plane the vertex is outside of.
+static int GetClipCode(Vertex& vertex, float nearPlane, float scale)
+{
+	int code = 0;
+	for (int plane = 0; plane < CLIP_PLANE_COUNT; plane++)
+	{
+		if (GetClipDistance(vertex, plane, nearPlane, scale) < 0)
+			code |= (1 << plane);
+	}
+	return code;
+}
+
+// Clips a polygon against a single plane (Sutherland-Hodgman) and returns the number of
+// vertexs in the clipped polygon. Vertexs are written back into the given array.
+static int ClipPolygonToPlane(Vertex* vertices, int count, int plane, float nearPlane, float scale)
+{
+	Vertex input[MAX_CLIP_VERTICES];
+	for (int i = 0; i < count; i++)
+		input[i] = vertices[i];
+
+	int outputCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		Vertex& current = input[i];
+		Vertex& next = input[(i + 1) % count];
+		float currentDistance = GetClipDistance(current, plane, nearPlane, scale);
+		float nextDistance = GetClipDistance(next, plane, nearPlane, scale);
+
+		// Keep the vertexs inside the plane, and add a new vertex wherever an edge crosses it.
+		if (currentDistance >= 0)
+			vertices[outputCount++] = current;
+		if ((currentDistance >= 0) != (nextDistance >= 0))
+			vertices[outputCount++] = Vertex::Interpolate(current, next, currentDistance / (currentDistance - nextDistance));
+	}
+
+	return outputCount;
+}
+
+// No-Argument Constructor. Declared private, should not get called.
+ModelInstance::ModelInstance(void)
+{
+	_model = NULL;
+	_buffers = NULL;
+	_renderLayer = RenderLayerScene;
+	_worldRadius = 0.0f;
+}
+
+// Constructor. Places the given model in the world using the given transform.
+ModelInstance::ModelInstance(Model3D* model, const Matrix3D& transform)
+{
+	_model = model;
+	_buffers = NULL;
+	_renderLayer = RenderLayerScene;
+	_worldRadius = 0.0f;
+	SetTransform(transform);
+}
+
+// Destructor. The model is shared so is not deleted, and the buffers belong to their pool.
+ModelInstance::~ModelInstance(void)
+{
+}
+
+// Accessor methods. Simple get/set code.
+Model3D* ModelInstance::GetModel()
+{
+	return _model;
+}
+void ModelInstance::SetTransform(const Matrix3D& transform)
+{
+	_transform = transform;
+	_model->GetWorldBoundingSphere(_transform, _worldCenter, _worldRadius);
+	_model->GetWorldAABB(_transform, _worldMin, _worldMax);
+}
+const Matrix3D& ModelInstance::GetTransform()
+{
+	return _transform;
+}
+void ModelInstance::SetRenderLayer(RenderLayer val)
+{
+	_renderLayer = val;
+}
+RenderLayer ModelInstance::GetRenderLayer()
+{
+	return _renderLayer;
+}
+void ModelInstance::GetWorldBoundingSphere(Vector3D& center, float& radius)
+{
+	center = _worldCenter;
+	radius = _worldRadius;
+}
+void ModelInstance::GetWorldAABB(Vector3D& worldMin, Vector3D& worldMax)
+{
+	worldMin = _worldMin;
+	worldMax = _worldMax;
+}
+std::vector<Polygon3D>& ModelInstance::GetPolygonList()
+{
+	return _buffers->polygons;
+}
+std::vector<Vertex>& ModelInstance::GetTransformedVertexList()
+{
+	return _buffers->transformedVertices;
+}
+
+// Returns a uv coordinate by the index a polygon refers to it with. Indexs past the end
+// of the models list refer to the uv coordinates clipping generated this frame.
+const UVCoordinate& ModelInstance::GetUVCoordinate(int index)
+{
+	std::vector<UVCoordinate>& uvCoordinates = _model->GetUVCoordinateList();
+	if (index < (int)uvCoordinates.size())
+		return uvCoordinates[index];
+	return _buffers->clippedUVCoordinates[index - uvCoordinates.size()];
+}
+
+// Takes a set of buffers from the pool to hold this frames results. The instance must
+// hold buffers from before it is transformed until after it is drawn.
+void ModelInstance::AcquireBuffers(InstanceBufferPool* pool)
+{
+	if (_buffers == NULL)
+		_buffers = pool->Acquire();
+}
+
+// Gives the buffers back to the pool, once the instance has been drawn.
+void ModelInstance::ReleaseBuffers(InstanceBufferPool* pool)
+{
+	pool->Release(_buffers);
+	_buffers = NULL;
+}
+
+// Tests the bounds of the instance against the cameras view frustum.
+FrustumTest ModelInstance::TestFrustum(Camera* camera)
+{
+	return _model->TestFrustum(camera, _transform);
+}
+
+// Starts this frames processing from scratch. The models polygons are copied into the
+// instance buffers, and the transformed vertices list is made the size of the models.
+void ModelInstance::ResetBuffers()
+{
+	_buffers->polygons = _model->GetPolygonList();
+	_buffers->clippedUVCoordinates.clear();
+	_buffers->transformedVertices.resize(_model->GetVertexList().size());
+}
+
+// Applys the instances transform to the models vertices in the range [begin, end) and
+// stores them in the transformed vertices list. Each of the methods that take a range
+// only touch the vertexs or polygons in it, so ranges can be worked on at the same time.
+void ModelInstance::ApplyTransformToLocalVertices(int begin, int end)
+{
+	std::vector<Vertex>& vertices = _model->GetVertexList();
+	for (int i = begin; i < end; i++)
+		_buffers->transformedVertices[i] = _transform * vertices[i];
+}
+
+// Applys the given matrix transformation to the transformated vertices.
+void ModelInstance::ApplyTransformToTransformedVertices(const Matrix3D& transform, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Vertex retVal = transform * _buffers->transformedVertices[i];
+		_buffers->transformedVertices[i] = retVal;
+	}
+}
+
+// Dehomohenizes each vertice in the transformed vertices list.
+void ModelInstance::DehomogenizeTransformedVertices(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+		_buffers->transformedVertices[i].Dehomogenize();
+}
+
+// Goes through each polygon and flags those that are backfacing from given camera position,
+// and counts them in the given stats.
+void ModelInstance::CalculateBackfaces(Camera* camera, int begin, int end, RenderStats& stats)
+{
+	unsigned int backfaceCount = 0;
+	for (int i = begin; i < end; i++)
+	{
+		Polygon3D polygon = _buffers->polygons[i];
+		Vertex v1 = _buffers->transformedVertices[polygon.GetVertexIndex(0)];
+		Vertex v2 = _buffers->transformedVertices[polygon.GetVertexIndex(1)];
+		Vertex v3 = _buffers->transformedVertices[polygon.GetVertexIndex(2)];
+	
+		// Get the polygons normal by working out the cross product of
+		// the vectors from the first vertex to each of the other vertexs.
+		Vector3D a = Vertex::GetVector(v1, v2);
+		Vector3D b = Vertex::GetVector(v1, v3);
+		Vector3D normal = Vector3D::CrossProduct(a, b);
+
+		// Work out the vector between the camera and the first vertex. (should be changed to middle of polygon not first vertex).
+		Vector3D eyeVector = Vertex::GetVector(v1, camera->GetPosition());
+
+		// Work out the dot product of the eye vector and the polygons normal.
+		float dotProduct = Vector3D::DotProduct(eyeVector, normal);
+
+		// If the dot product is less than 0, then polygon is backfacing, otherwise not.
+		if (dotProduct < 0)
+		{
+			_buffers->polygons[i].SetBackfacing(true);
+			backfaceCount++;
+		}
+		else
+			_buffers->polygons[i].SetBackfacing(false);
+	}
+	stats.trianglesBackfaceCulled += backfaceCount;
+}
+
+// Clips the polygons against the near plane in homogeneous space. This should be called after
+// the perspective matrix has been applied and before the vertices are dehomogenized, so no
+// vertex is ever divided by a w behind the camera. Polygons entirely outside the view frustum
+// are culled. Clipping against the other planes is only done for polygons that cross the guard
+// band, anything inside it is left for the rasterizer to clip to the screen. The polygons
+// culled and clipped are counted in the given stats.
+void ModelInstance::ClipPolygons(Camera* camera, RenderStats& stats)
+{
+	float nearPlane = camera->GetNearPlane();
+	std::vector<UVCoordinate>& uvCoordinates = _model->GetUVCoordinateList();
+	bool textured = (uvCoordinates.size() > 0);
+
+	// Only the models own polygons are clipped, not the ones clipping adds to the list.
+	unsigned int polygonCount = _buffers->polygons.size();
+	for (unsigned int i = 0; i < polygonCount; i++)
+	{
+		Polygon3D polygon = _buffers->polygons[i];
+		if (polygon.GetBackfacing() == true)
+			continue;
+
+		// Work out which planes the vertexs are outside of.
+		Vertex vertices[MAX_CLIP_VERTICES];
+		int frustumCode = ~0;
+		int guardBandCode = 0;
+		for (int j = 0; j < 3; j++)
+		{
+			vertices[j] = _buffers->transformedVertices[polygon.GetVertexIndex(j)];
+			if (textured == true)
+				vertices[j].SetUVCoordinate(uvCoordinates[polygon.GetUVIndex(j)]);
+
+			frustumCode &= GetClipCode(vertices[j], nearPlane, 1.0f);
+			guardBandCode |= GetClipCode(vertices[j], nearPlane, CAMERA_GUARD_BAND);
+		}
+
+		// Cull the polygon if every vertex is outside the same plane of the view frustum.
+		if (frustumCode != 0)
+		{
+			_buffers->polygons[i].SetCulled(true);
+			stats.trianglesFrustumCulled++;
+			continue;
+		}
+
+		// Nothing to do if the polygon is in front of the near plane and inside the guard band.
+		if (guardBandCode == 0)
+			continue;
+
+		// Clip the polygon against each plane it crosses and replace it with the result.
+		_buffers->polygons[i].SetCulled(true);
+		stats.trianglesClipped++;
+
+		int count = 3;
+		for (int plane = 0; plane < CLIP_PLANE_COUNT && count >= 3; plane++)
+		{
+			if (guardBandCode & (1 << plane))
+				count = ClipPolygonToPlane(vertices, count, plane, nearPlane, CAMERA_GUARD_BAND);
+		}
+		if (count < 3)
+			continue;
+
+		int firstVertex = _buffers->transformedVertices.size();
+		int firstUVCoordinate = uvCoordinates.size() + _buffers->clippedUVCoordinates.size();
+
+		for (int j = 0; j < count; j++)
+		{
+			_buffers->transformedVertices.push_back(vertices[j]);
+			if (textured == true)
+				_buffers->clippedUVCoordinates.push_back(vertices[j].GetUVCoordinate());
+		}
+
+		// Triangulate the clipped polygon as a fan.
+		for (int j = 1; j < count - 1; j++)
+		{
+			Polygon3D generated = Polygon3D(firstVertex, firstVertex + j, firstVertex + j + 1);
+			generated.SetUVIndex(0, firstUVCoordinate);
+			generated.SetUVIndex(1, firstUVCoordinate + j);
+			generated.SetUVIndex(2, firstUVCoordinate + j + 1);
+			generated.SetColor(polygon.GetColor());
+			generated.SetGenerated(true);
+			_buffers->polygons.push_back(generated);
+		}
+	}
+}
+
+// Works out the average depth of each polygon.
+void ModelInstance::CalculatePolygonDepths(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Polygon3D polygon = _buffers->polygons[i];
+		
+		// Calculate the sum of all vertex Z coordinates.
+		float depthSum = 0;
+		for (int j = 0; j < 3; j++)
+			depthSum += _buffers->transformedVertices[polygon.GetVertexIndex(j)].GetZ();
+		
+		// Work out and set the average (sum/3).
+		depthSum /= 3.0f;
+		_buffers->polygons[i].SetAvgDepth(depthSum);
+	}
+}
+
+// Sorts the polygon list by the depths worked out by CalculatePolygonDepths.
+void ModelInstance::DepthSort()
+{
+	// Sort the collection using the standard sort function.
+	std::sort(_buffers->polygons.begin(), _buffers->polygons.end(), SortPolygonsByDepth());
+}
+
+// Resets the lighting of the polygon back to black, ready for lighting calculations.
+void ModelInstance::ResetLighting(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		_buffers->polygons[i].SetColor(Gdiplus::Color::Black);
+	}
+}
+
+// Calculates the compound lighting of all polygons on the model from
+// the list of directional lights.
+void ModelInstance::CalculateLightingDirectional(const std::vector<DirectionalLight*>& lights, int begin, int end)
+{
+	float totalR, totalG, totalB;
+	float tempR, tempG, tempB;
+	float kdRed, kdGreen, kdBlue;
+	_model->GetReflectionCoefficients(kdRed, kdGreen, kdBlue);
+
+	for (int i = begin; i < end; i++)
+	{
+		Vertex vert = _buffers->transformedVertices[i];
+
+		// Reset total light.
+		totalR = vert.GetColor().GetR();
+		totalG = vert.GetColor().GetG();
+		totalB = vert.GetColor().GetB();
+
+		// Calculate lighting.
+		for (unsigned int j = 0; j < lights.size(); j++)
+		{
+			DirectionalLight* light = lights[j];
+			Gdiplus::Color c = light->GetIntensity();
+
+			if (light->GetEnabled() == false)
+				continue;
+
+			tempR = c.GetR();
+			tempG = c.GetG();
+			tempB = c.GetB();
+		
+			// Apply the lighting coefficients.
+			tempR *= kdRed;
+			tempG *= kdGreen;
+			tempB *= kdBlue;
+			
+			// Work out vector to light source.
+			Vector3D lightVector = Vertex::GetVector(vert, light->GetPosition());
+			lightVector.Normalize();
+
+			// Work out dot product.
+			float dotProduct = Vector3D::DotProduct(lightVector, vert.GetNormal());
+			if (dotProduct >= 0)
+				continue;
+
+			// Multiply the colour by the dot product.
+			tempR *= dotProduct;
+			tempG *= dotProduct;
+			tempB *= dotProduct;
+			
+			// Add the light color to the total polygon color.
+			totalR += abs(tempR);
+			totalG += abs(tempG);
+			totalB += abs(tempB);
+		}
+
+		// Clamp lighting.
+		totalR = max(min(totalR, 255.0f), 0.0f);
+		totalG = max(min(totalG, 255.0f), 0.0f);
+		totalB = max(min(totalB, 255.0f), 0.0f);
+
+		// Store color.
+		_buffers->transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
+	}
+}
+
+// Calculates the compound lighting of all polygons on the model from
+// the list of ambient lights.
+void ModelInstance::CalculateLightingAmbient(const std::vector<AmbientLight*>& lights, int begin, int end)
+{
+	float totalR, totalG, totalB;
+	float tempR, tempG, tempB;
+	float kdRed, kdGreen, kdBlue;
+	_model->GetReflectionCoefficients(kdRed, kdGreen, kdBlue);
+
+	for (int i = begin; i < end; i++)
+	{
+		Vertex vert = _buffers->transformedVertices[i];
+
+		// Reset total light.
+		totalR = vert.GetColor().GetR();
+		totalG = vert.GetColor().GetG();
+		totalB = vert.GetColor().GetB();
+
+		// Calculate lighting.
+		for (unsigned int j = 0; j < lights.size(); j++)
+		{
+			Light* light = lights[j];
+			Gdiplus::Color c = light->GetIntensity();
+
+			if (light->GetEnabled() == false)
+				continue;
+
+			// Set the temporary light color to the lights color.
+			tempR = c.GetR();
+			tempG = c.GetG();
+			tempB = c.GetB();
+		
+			// Apply the lighting coefficients.
+			tempR *= kdRed;
+			tempG *= kdGreen;
+			tempB *= kdBlue;
+			
+			// Add the light color to the total polygon color.
+			totalR += abs(tempR);
+			totalG += abs(tempG);
+			totalB += abs(tempB);
+		}
+
+		// Clamp lighting.
+		totalR = max(min(totalR, 255.0f), 0.0f);
+		totalG = max(min(totalG, 255.0f), 0.0f);
+		totalB = max(min(totalB, 255.0f), 0.0f);
+
+		// Store color.
+		_buffers->transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
+	}
+}
+
+// Calculates the compound lighting of all polygons on the model from
+// the list of point lights.
+void ModelInstance::CalculateLightingPoint(const std::vector<PointLight*>& lights, int begin, int end)
+{
+	float totalR, totalG, totalB;
+	float tempR, tempG, tempB;
+	float kdRed, kdGreen, kdBlue;
+	_model->GetReflectionCoefficients(kdRed, kdGreen, kdBlue);
+
+	for (int i = begin; i < end; i++)
+	{
+		Vertex vert = _buffers->transformedVertices[i];
+
+		// Reset total light.
+		totalR = vert.GetColor().GetR();
+		totalG = vert.GetColor().GetG();
+		totalB = vert.GetColor().GetB();
+
+		// Calculate lighting.
+		for (unsigned int j = 0; j < lights.size(); j++)
+		{
+			PointLight* light = lights[j];
+			Gdiplus::Color c = light->GetIntensity();
+
+			if (light->GetEnabled() == false)
+				continue;
+			
+			// Set the temporary light color to the lights color.
+			tempR = c.GetR();
+			tempG = c.GetG();
+			tempB = c.GetB();
+		
+			// Apply the lighting coefficients.
+			tempR *= kdRed;
+			tempG *= kdGreen;
+			tempB *= kdBlue;
+			
+			// Work out vector to light source.
+			Vector3D lightVector = Vertex::GetVector(vert, light->GetPosition());
+			float distance = lightVector.GetLength();
+			lightVector.Normalize();
+
+			// Work out attenuation.
+			float attnA, attnB, attnC;
+			light->GetAttenuation(attnA, attnB, attnC);
+
+			float attenuation = 1 / (attnA + attnB * distance + attnC * (distance * distance));
+			attenuation *= 100;
+
+			// Work out dot product.
+			float dotProduct = Vector3D::DotProduct(lightVector, vert.GetNormal());
+			if (dotProduct >= 0)
+				continue;
+
+			// Apply the dot product to the temporary light color.
+			tempR *= dotProduct;
+			tempG *= dotProduct;
+			tempB *= dotProduct;
+			
+			// Apply the attenuation to the temporary light color.
+			tempR *= attenuation;
+			tempG *= attenuation;
+			tempB *= attenuation;
+			
+			// Add the light color to the total polygon color.
+			totalR += abs(tempR);
+			totalG += abs(tempG);
+			totalB += abs(tempB);
+		}
+
+		// Clamp lighting.
+		totalR = max(min(totalR, 255.0f), 0.0f);
+		totalG = max(min(totalG, 255.0f), 0.0f);
+		totalB = max(min(totalB, 255.0f), 0.0f);
+
+		// Store color.
+		_buffers->transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
+	}
+}
+
+// Calculates the compound lighting of all polygons on the model from
+// the list of spot lights.
+void ModelInstance::CalculateLightingSpot(const std::vector<SpotLight*>& lights, int begin, int end)
+{
+	float totalR, totalG, totalB;
+	float tempR, tempG, tempB;
+	float kdRed, kdGreen, kdBlue;
+	_model->GetReflectionCoefficients(kdRed, kdGreen, kdBlue);
+
+	for (int i = begin; i < end; i++)
+	{
+		Vertex vert = _buffers->transformedVertices[i];
+
+		// Reset total light.
+		totalR = vert.GetColor().GetR();
+		totalG = vert.GetColor().GetG();
+		totalB = vert.GetColor().GetB();
+
+		// Calculate lighting.
+		for (unsigned int j = 0; j < lights.size(); j++)
+		{
+			SpotLight* light = lights[j];
+			Gdiplus::Color c = light->GetIntensity();
+
+			if (light->GetEnabled() == false)
+				continue;
+			
+			// Set the temporary light color to the lights color.
+			tempR = c.GetR();
+			tempG = c.GetG();
+			tempB = c.GetB();
+		
+			// Apply the lighting coefficients.
+			tempR *= kdRed;
+			tempG *= kdGreen;
+			tempB *= kdBlue;
+			
+			// Work out vector to light source.
+			Vector3D lightVector = Vertex::GetVector(vert, light->GetPosition());
+			float distance = lightVector.GetLength();
+			lightVector.Normalize();
+
+			// Work out attenuation.
+			float attnA, attnB, attnC;
+			light->GetAttenuation(attnA, attnB, attnC);
+
+			float attenuation = 1 / (attnA + attnB * distance + attnC * (distance * distance));
+			attenuation *= 100;
+
+			// Work out dot product.
+			float dotProduct = Vector3D::DotProduct(lightVector, vert.GetNormal());
+			if (dotProduct >= 0)
+				continue;
+
+			// Work out spotlight value.
+			float spotValue = 1.0f;//light->SmoothStep(cos(light->GetAngle()), cos());
+
+			// Apply the dot product to the temporary light color.
+			tempR *= dotProduct;
+			tempG *= dotProduct;
+			tempB *= dotProduct;
+			
+			// Apply the attenuation to the temporary light color.
+			tempR *= attenuation;
+			tempG *= attenuation;
+			tempB *= attenuation;
+
+			// Apply spotlight value.
+			tempR *= spotValue;
+			tempG *= spotValue;
+			tempB *= spotValue;
+			
+			// Add the light color to the total polygon color.
+			totalR += abs(tempR);
+			totalG += abs(tempG);
+			totalB += abs(tempB);
+		}
+
+		// Clamp lighting.
+		totalR = max(min(totalR, 255.0f), 0.0f);
+		totalG = max(min(totalG, 255.0f), 0.0f);
+		totalB = max(min(totalB, 255.0f), 0.0f);
+
+		// Store color.
+		_buffers->transformedVertices[i].SetColor(Gdiplus::Color((int)totalR, (int)totalG, (int)totalB));
+	}
+}
+
+// Sums the normals of the polygons each transformed vertex is part of, ready for
+// NormalizeVertexNormals. Polygons share vertexs so this can not be split into ranges.
+void ModelInstance::SumVertexNormals()
+{
+	// Reset all the normals and normal counts of all 
+	// transformed vertices to default.
+	for (unsigned int i = 0; i < _buffers->transformedVertices.size(); i++)
+	{
+		_buffers->transformedVertices[i].SetNormal(Vector3D(0, 0, 0));
+		_buffers->transformedVertices[i].SetNormalCount(0);
+	}
+
+	// Work out the normal sum for each vertex in the polygon.
+	for (unsigned int i = 0; i < _buffers->polygons.size(); i++)
+	{
+		Polygon3D polygon = _buffers->polygons[i];
+
+		// Work out normal.
+		Vertex v1 = _buffers->transformedVertices[polygon.GetVertexIndex(0)];
+		Vertex v2 = _buffers->transformedVertices[polygon.GetVertexIndex(1)];
+		Vertex v3 = _buffers->transformedVertices[polygon.GetVertexIndex(2)];
+		Vector3D a = Vertex::GetVector(v1, v2);
+		Vector3D b = Vertex::GetVector(v1, v3);
+		Vector3D polyNormal = Vector3D::CrossProduct(a, b);
+
+		// Update normals.
+		for (int j = 0; j < 3; j++)
+		{
+			int index = polygon.GetVertexIndex(j);
+			Vertex v = _buffers->transformedVertices[index]; 
+			Vector3D vNormal = v1.GetNormal();
+
+			// Adds the vertex normal to the polygons current normal.
+			// Increments the normal count.
+			_buffers->transformedVertices[index].SetNormal(Vector3D(vNormal.GetX() + polyNormal.GetX(),
+												  vNormal.GetY() + polyNormal.GetY(),
+												  vNormal.GetZ() + polyNormal.GetZ()));
+			_buffers->transformedVertices[index].SetNormalCount(v.GetNormalCount() + 1);
+		}
+	}
+}
+
+// Works out the normal of each transformed vertex from the sums.
+void ModelInstance::NormalizeVertexNormals(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Vertex v = _buffers->transformedVertices[i]; 
+
+		// Work out the normal for the vertex's by dividing the normal sum
+		// by the normal count.
+		_buffers->transformedVertices[i].SetNormal(Vector3D(v.GetX() / v.GetNormalCount(),
+										v.GetY() / v.GetNormalCount(),
+										v.GetZ() / v.GetNormalCount()));
+
+		// Normalize the vector and apply it to the transformed vertices.
+		Vector3D n = _buffers->transformedVertices[i].GetNormal();
+		n.Normalize();
+		_buffers->transformedVertices[i].SetNormal(Vector3D(-n.GetX(), -n.GetY(), -n.GetZ()));
+	}
+}
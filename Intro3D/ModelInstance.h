@@ -0,0 +1,81 @@
+// =========================================================================================
+//	ModelInstance.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Model3D.h"
+#include "Matrix3D.h"
+#include "InstanceBufferPool.h"
+#include "RenderLayer.h"
+#include "RenderStats.h"
+#include <vector>
+
+// This class places a model in the scene with its own world transform. Any 
+// number of instances can share the same model. While being drawn an instance holds
+// buffers from a pool for its transformed vertices, lighting and polygon order, so the
+// models own data is never written to.
+class ModelInstance
+{
+	public:
+		ModelInstance(Model3D* model, const Matrix3D& transform);
+		~ModelInstance(void);
+
+		Model3D* GetModel();
+
+		void SetTransform(const Matrix3D& transform);
+		const Matrix3D& GetTransform();
+
+		void SetRenderLayer(RenderLayer val);
+		RenderLayer GetRenderLayer();
+
+		void GetWorldBoundingSphere(Vector3D& center, float& radius);
+		void GetWorldAABB(Vector3D& worldMin, Vector3D& worldMax);
+
+		void AcquireBuffers(InstanceBufferPool* pool);
+		void ReleaseBuffers(InstanceBufferPool* pool);
+
+		std::vector<Polygon3D>& GetPolygonList();
+		std::vector<Vertex>& GetTransformedVertexList();
+		const UVCoordinate& GetUVCoordinate(int index);
+
+		FrustumTest TestFrustum(Camera* camera);
+
+		void ResetBuffers();
+		void ApplyTransformToLocalVertices(int begin, int end);
+		void ApplyTransformToTransformedVertices(const Matrix3D& transform, int begin, int end);
+		void DehomogenizeTransformedVertices(int begin, int end);
+
+		void CalculateBackfaces(Camera* camera, int begin, int end, RenderStats& stats);
+		void ClipPolygons(Camera* camera, RenderStats& stats);
+		void CalculatePolygonDepths(int begin, int end);
+		void DepthSort();
+
+		void ResetLighting(int begin, int end);
+		void CalculateLightingDirectional(const std::vector<DirectionalLight*>& lights, int begin, int end);
+		void CalculateLightingAmbient(const std::vector<AmbientLight*>& lights, int begin, int end);
+		void CalculateLightingPoint(const std::vector<PointLight*>& lights, int begin, int end);
+		void CalculateLightingSpot(const std::vector<SpotLight*>& lights, int begin, int end);
+
+		void SumVertexNormals();
+		void NormalizeVertexNormals(int begin, int end);
+
+	private:
+		Model3D* _model;
+		Matrix3D _transform;
+		RenderLayer _renderLayer;
+
+		// Buffers holding this frames results, only set while the instance is being drawn.
+		InstanceBuffers* _buffers;
+
+		// Bounds of the model in world space, updated whenever the transform changes.
+		Vector3D _worldCenter;
+		float _worldRadius;
+		Vector3D _worldMin;
+		Vector3D _worldMax;
+
+		// Private constructor. Should not be used directly.
+		ModelInstance(void);
+};
@@ -0,0 +1,24 @@
+// =========================================================================================
+//	NullPresenter.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "NullPresenter.h"
+
+// Constructor.
+NullPresenter::NullPresenter(void)
+{
+}
+
+// Destructor.
+NullPresenter::~NullPresenter(void)
+{
+}
+
+// Does nothing with the frame.
+void NullPresenter::Present(Gdiplus::Bitmap*)
+{
+}
@@ -0,0 +1,20 @@
+// =========================================================================================
+//	NullPresenter.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Presenter.h"
+
+// This presenter throws every frame away. Used when running without a window, where
+// only the rendering itself matters.
+class NullPresenter : public Presenter
+{
+	public:
+		NullPresenter(void);
+		~NullPresenter(void);
+
+		void Present(Gdiplus::Bitmap* frame);
+};
@@ -0,0 +1,608 @@
+// =========================================================================================
+//	OfflineRenderer.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "OfflineRenderer.h"
+
+// Names of the display modes, camera paths and debug views, as they are given on the command line.
+static const char* DisplayModeArgumentNames[] =
+{
+	"WireFrame",
+	"FlatShadedUnlit",
+	"FlatShadedAmbient",
+	"FlatShadedDirectionalAmbient",
+	"FlatShadedDirectionalPointAmbient",
+	"GouraudShadedUnlit",
+	"GouraudShadedAmbient",
+	"GouraudShadedDirectionalAmbient",
+	"GouraudShadedDirectionalPointAmbient",
+	"TexturedUnlit",
+	"TexturedAmbient",
+	"TexturedDirectionalAmbient",
+	"TexturedNormalMappedDirectionalAmbient",
+	"TexturedDirectionalPointAmbient",
+	"TexturedNormalMappedDirectionalPointAmbient"
+};
+
+static const char* CameraPathNames[] =
+{
+	"static",
+	"orbit",
+	"dolly"
+};
+
+static const char* DebugViewNames[] =
+{
+	"none",
+	"overdraw",
+	"tilecost"
+};
+
+// No-Argument Constructor. Declared private, should not get called.
+OfflineRenderer::OfflineRenderer(void)
+{
+}
+
+// Constructor. Makes an empty scene rendered into a framebuffer of the given size.
+OfflineRenderer::OfflineRenderer(unsigned int width, unsigned int height)
+{
+	_rasterizer = new Rasterizer(width, height);
+	_rasterizer->SetFastClearOn(FAST_CLEAR_ON);
+
+	_camera = new Camera(0, 0, 0, Vertex(OFFLINE_CAMERA_X, OFFLINE_CAMERA_Y, OFFLINE_CAMERA_Z, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0), width, height);
+	_scene = new Scene();
+	_renderQueue = new RenderQueue();
+	_displayMode = TexturedNormalMappedDirectionalPointAmbient;
+	_cameraPath = CameraPathStatic;
+
+	// Unlit modes are lit by a white ambient light.
+	_unlitAmbientLight = new AmbientLight();
+	_unlitAmbientLight->SetIntensity(Color::White);
+	_ambientLightList.push_back(_unlitAmbientLight);
+	_lightsChanged = true;
+	_colormapOn = COLORMAP_ON;
+	_capture = NULL;
+}
+
+// Destructor.
+OfflineRenderer::~OfflineRenderer(void)
+{
+	// The render queue holds instance buffers until it is deleted, so it goes first.
+	delete _renderQueue;
+	delete _scene;
+	delete _camera;
+	delete _rasterizer;
+	delete _capture;
+
+	for (unsigned int i = 0; i < _models.size(); i++)
+		delete _models[i];
+	for (unsigned int i = 0; i < _directionalLightList.size(); i++)
+		delete _directionalLightList[i];
+	for (unsigned int i = 0; i < _ambientLightList.size(); i++)
+		delete _ambientLightList[i];
+	for (unsigned int i = 0; i < _pointLightList.size(); i++)
+		delete _pointLightList[i];
+}
+
+// Loads a model and the textures it is drawn with, and returns its index. Returns -1 if
+// any of the files could not be loaded.
+int OfflineRenderer::LoadModel(const char* modelFilename, const char* textureFilename, const char* normalMapFilename)
+{
+	Model3D* model = new Model3D();
+	if (MD2Loader::LoadModel(modelFilename, *model, textureFilename, normalMapFilename) == false)
+	{
+		delete model;
+		return -1;
+	}
+
+	model->BuildColormap(COLORMAP_LIGHT_LEVELS, COLORMAP_COLORED_LIGHT);
+	model->SetColormapOn(_colormapOn);
+	_models.push_back(model);
+
+	// The files are kept so the model can be recorded in a capture.
+	CapturedModel files;
+	files.modelFilename = modelFilename;
+	files.textureFilename = textureFilename ? textureFilename : "";
+	files.normalMapFilename = normalMapFilename ? normalMapFilename : "";
+	_modelFiles.push_back(files);
+	return (int)_models.size() - 1;
+}
+
+// Places an instance of a loaded model in the scene, turning by the given number of
+// radians each frame. Returns the index of the instance.
+int OfflineRenderer::AddInstance(int model, const Vector3D& position, float spin, RenderLayer layer)
+{
+	OfflineInstance instance;
+	instance.position = position;
+	instance.spin = spin;
+	instance.sceneIndex = _scene->AddInstance(_models[model], Matrix3D::TranslateMatrix(position.GetX(), position.GetY(), position.GetZ()));
+	_scene->GetInstance(instance.sceneIndex)->SetRenderLayer(layer);
+
+	_instances.push_back(instance);
+	return (int)_instances.size() - 1;
+}
+
+// Light adding methods.
+void OfflineRenderer::AddDirectionalLight(const Vector3D& position, const Gdiplus::Color& intensity)
+{
+	DirectionalLight* light = new DirectionalLight();
+	light->SetPosition(Vertex(position.GetX(), position.GetY(), position.GetZ(), 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0));
+	light->SetIntensity(intensity);
+	_directionalLightList.push_back(light);
+	_lightsChanged = true;
+}
+void OfflineRenderer::AddAmbientLight(const Gdiplus::Color& intensity)
+{
+	AmbientLight* light = new AmbientLight();
+	light->SetIntensity(intensity);
+	_ambientLightList.push_back(light);
+	_lightsChanged = true;
+}
+void OfflineRenderer::AddPointLight(const Vector3D& position, const Gdiplus::Color& intensity, float atnA, float atnB, float atnC)
+{
+	PointLight* light = new PointLight(intensity, atnA, atnB, atnC);
+	light->SetPosition(Vertex(position.GetX(), position.GetY(), position.GetZ(), 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0));
+	_pointLightList.push_back(light);
+	_lightsChanged = true;
+}
+
+// Places the models of the demonstration in the scene, the character standing on a floor
+// of grass. Returns false if they could not be loaded.
+bool OfflineRenderer::LoadDemoModels()
+{
+	int floor = LoadModel("grass.md2", "grass.pcx");
+	int character = LoadModel("baron.md2", "baron.pcx", "baron_nm.pcx");
+	if (floor < 0 || character < 0)
+		return false;
+
+	AddInstance(floor, Vector3D(0, -50, 150), 0.0f, RenderLayerBackground);
+	AddInstance(character, Vector3D(0, 0, 30), OFFLINE_DEMO_SPIN, RenderLayerScene);
+	return true;
+}
+
+// Adds the lights of the demonstration.
+void OfflineRenderer::AddDemoLights()
+{
+	AddDirectionalLight(Vector3D(500, 150, 50), Color(255, 0, 0));
+	AddAmbientLight(Color(100, 100, 100));
+	AddPointLight(Vector3D(-500, 150, 10), Color(0, 0, 255), 0, 0.1f, 0);
+}
+
+// Accessor methods.
+void OfflineRenderer::SetDisplayMode(DisplayMode mode)
+{
+	_displayMode = mode;
+	_lightsChanged = true;
+}
+DisplayMode OfflineRenderer::GetDisplayMode()
+{
+	return _displayMode;
+}
+void OfflineRenderer::SetCameraPath(CameraPath path)
+{
+	_cameraPath = path;
+}
+CameraPath OfflineRenderer::GetCameraPath()
+{
+	return _cameraPath;
+}
+void OfflineRenderer::SetDebugView(DebugView view)
+{
+	_rasterizer->SetDebugView(view);
+}
+DebugView OfflineRenderer::GetDebugView()
+{
+	return _rasterizer->GetDebugView();
+}
+bool OfflineRenderer::GetColormapOn()
+{
+	return _colormapOn;
+}
+
+// Turns colormap shading on or off for the models loaded and those loaded later.
+void OfflineRenderer::SetColormapOn(bool val)
+{
+	_colormapOn = val;
+	for (unsigned int i = 0; i < _models.size(); i++)
+		_models[i]->SetColormapOn(val);
+}
+void OfflineRenderer::SetJobSystem(JobSystem* jobSystem)
+{
+	_renderQueue->SetJobSystem(jobSystem);
+}
+void OfflineRenderer::SetPipelineOn(bool val)
+{
+	_renderQueue->SetPipelineOn(val);
+}
+bool OfflineRenderer::GetPipelineOn()
+{
+	return _renderQueue->GetPipelineOn();
+}
+Gdiplus::Bitmap* OfflineRenderer::GetFrame()
+{
+	return _rasterizer->GetBitmap();
+}
+Rasterizer* OfflineRenderer::GetRasterizer()
+{
+	return _rasterizer;
+}
+RenderQueue* OfflineRenderer::GetRenderQueue()
+{
+	return _renderQueue;
+}
+Scene* OfflineRenderer::GetScene()
+{
+	return _scene;
+}
+Camera* OfflineRenderer::GetCamera()
+{
+	return _camera;
+}
+unsigned int OfflineRenderer::GetModelCount()
+{
+	return (unsigned int)_models.size();
+}
+unsigned int OfflineRenderer::GetInstanceCount()
+{
+	return (unsigned int)_instances.size();
+}
+const RenderStats& OfflineRenderer::GetStats()
+{
+	return _stats;
+}
+
+// Returns the name of a display mode, camera path or debug view as given on the command line.
+const char* OfflineRenderer::GetDisplayModeName(DisplayMode mode)
+{
+	return DisplayModeArgumentNames[mode];
+}
+const char* OfflineRenderer::GetCameraPathName(CameraPath path)
+{
+	return CameraPathNames[path];
+}
+const char* OfflineRenderer::GetDebugViewName(DebugView view)
+{
+	return DebugViewNames[view];
+}
+
+// Renders the given frame into the framebuffer. When pipelined the framebuffer holds the
+// frame before it, and Flush renders the last frame.
+void OfflineRenderer::RenderFrame(int frame)
+{
+	Profiler::BeginFrame();
+	UpdateLights();
+	UpdateCamera(frame);
+
+	// Animate each instance from its starting place.
+	{
+		PROFILE_SCOPE(ProfileStageScene);
+		for (unsigned int i = 0; i < _instances.size(); i++)
+		{
+			OfflineInstance& instance = _instances[i];
+			Matrix3D transform = Matrix3D::RotateMatrix(0, instance.spin * frame, 0) *
+								 Matrix3D::TranslateMatrix(instance.position.GetX(), instance.position.GetY(), instance.position.GetZ());
+			_scene->SetInstanceTransform(instance.sceneIndex, transform);
+		}
+		_scene->Update();
+	}
+
+	RenderScene();
+	Profiler::EndFrame();
+}
+
+// Renders the frame the pipelined render queue is still holding. Does nothing if the
+// renderer is not pipelined, the framebuffer already holds the last frame rendered.
+void OfflineRenderer::Flush()
+{
+	if (GetPipelineOn() == false)
+		return;
+
+	Profiler::BeginFrame();
+	BeginFrame();
+	_renderQueue->Flush();
+	FinishFrame(_pipelineGeometryStats);
+	_pipelineGeometryStats.Reset();
+	Profiler::EndFrame();
+}
+
+// Records the frames rendered to a capture file, from the next frame on. The models and
+// lights that are recorded are those the renderer has now. Returns false if the file
+// could not be written.
+bool OfflineRenderer::StartCapture(const char* filename)
+{
+	StopCapture();
+	_capture = new FrameCapture();
+	for (unsigned int i = 0; i < _models.size(); i++)
+	{
+		const CapturedModel& files = _modelFiles[i];
+		_capture->AddModel(_models[i], files.modelFilename.c_str(), files.textureFilename.c_str(), files.normalMapFilename.c_str());
+	}
+	_capture->SetLights(_directionalLightList, _ambientLightList, _pointLightList);
+
+	if (_capture->Open(filename, _rasterizer->GetWidth(), _rasterizer->GetHeight()) == false)
+	{
+		StopCapture();
+		return false;
+	}
+	return true;
+}
+
+// Stops recording frames, closing the capture file.
+void OfflineRenderer::StopCapture()
+{
+	if (_capture)
+	{
+		delete _capture;
+		_capture = NULL;
+	}
+}
+
+// Loads the models and lights of a capture, so its frames can be rendered. The renderers
+// own unlit light is not used, the capture holds the lights as they were. Returns false
+// if any of the models could not be loaded, or the renderer already has models.
+bool OfflineRenderer::LoadCapture(const FrameCapture& capture)
+{
+	if (_models.size() > 0)
+		return false;
+
+	for (unsigned int i = 0; i < capture.GetModelCount(); i++)
+	{
+		const CapturedModel& files = capture.GetModel(i);
+		if (LoadModel(files.modelFilename.c_str(),
+					  files.textureFilename.empty() ? NULL : files.textureFilename.c_str(),
+					  files.normalMapFilename.empty() ? NULL : files.normalMapFilename.c_str()) < 0)
+			return false;
+	}
+
+	_capturedLights.clear();
+	for (unsigned int i = 0; i < capture.GetLightCount(); i++)
+	{
+		const CapturedLight& light = capture.GetLight(i);
+		Vector3D position(light.position[0], light.position[1], light.position[2]);
+		Gdiplus::Color intensity(light.intensity[0], light.intensity[1], light.intensity[2]);
+		switch (light.type)
+		{
+		case CapturedLightDirectional:
+			AddDirectionalLight(position, intensity);
+			_capturedLights.push_back(_directionalLightList.back());
+			break;
+		case CapturedLightAmbient:
+			AddAmbientLight(intensity);
+			_capturedLights.push_back(_ambientLightList.back());
+			break;
+		case CapturedLightPoint:
+			AddPointLight(position, intensity, light.attenuation[0], light.attenuation[1], light.attenuation[2]);
+			_capturedLights.push_back(_pointLightList.back());
+			break;
+		}
+	}
+	_unlitAmbientLight->SetEnabled(false);
+	return true;
+}
+
+// Renders a frame of the capture loaded by LoadCapture, with the instances, camera and
+// lights as they were captured. Like RenderFrame, when pipelined the framebuffer holds the
+// frame before it.
+void OfflineRenderer::RenderCapturedFrame(const CapturedFrame& frame)
+{
+	Profiler::BeginFrame();
+
+	// The lights and normal maps are set as they were, rather than from the display mode.
+	_displayMode = frame.displayMode;
+	if (_lightsChanged == true)
+	{
+		_lightsChanged = false;
+		_rasterizer->SetLights(_directionalLightList, _ambientLightList, _pointLightList);
+		_renderQueue->SetLights(_directionalLightList, _ambientLightList, _pointLightList, _spotLightList);
+	}
+	for (unsigned int i = 0; i < _capturedLights.size(); i++)
+		_capturedLights[i]->SetEnabled(((frame.lightsEnabled >> i) & 1) != 0);
+	for (unsigned int i = 0; i < _models.size(); i++)
+		_models[i]->SetNormalMapOn(((frame.normalMapsOn >> i) & 1) != 0);
+
+	Vertex position(frame.cameraPosition[0], frame.cameraPosition[1], frame.cameraPosition[2], 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0);
+	_camera->SetViewSize(frame.viewWidth, frame.viewHeight);
+	_camera->SetRotation(frame.cameraRotation[0], frame.cameraRotation[1], frame.cameraRotation[2]);
+	_camera->SetPosition(position);
+
+	{
+		PROFILE_SCOPE(ProfileStageScene);
+
+		// The instances are moved where they were if they are the same as last frame,
+		// otherwise the scene is built again.
+		bool sameInstances = (_scene->GetInstanceCount() == frame.instances.size());
+		for (unsigned int i = 0; i < frame.instances.size() && sameInstances == true; i++)
+		{
+			ModelInstance* instance = _scene->GetInstance(i);
+			sameInstances = (instance->GetModel() == _models[frame.instances[i].model] && instance->GetRenderLayer() == frame.instances[i].layer);
+		}
+
+		// The pipeline holds the instances of the last frame, so it is flushed before they
+		// are deleted. The frame it draws is replaced by this one.
+		if (sameInstances == false && _scene->GetInstanceCount() > 0)
+		{
+			if (_renderQueue->GetPipelineOn() == true)
+			{
+				BeginFrame();
+				_renderQueue->Flush();
+				FinishFrame(_pipelineGeometryStats);
+				_pipelineGeometryStats.Reset();
+			}
+			_scene->Clear();
+		}
+
+		for (unsigned int i = 0; i < frame.instances.size(); i++)
+		{
+			const CapturedInstance& instance = frame.instances[i];
+			const float (*m)[4] = instance.transform;
+			Matrix3D transform(m[0][0], m[0][1], m[0][2], m[0][3],
+							   m[1][0], m[1][1], m[1][2], m[1][3],
+							   m[2][0], m[2][1], m[2][2], m[2][3],
+							   m[3][0], m[3][1], m[3][2], m[3][3]);
+
+			if (sameInstances == true)
+				_scene->SetInstanceTransform(i, transform);
+			else
+			{
+				int index = _scene->AddInstance(_models[instance.model], transform);
+				_scene->GetInstance(index)->SetRenderLayer(instance.layer);
+			}
+		}
+		_scene->Update();
+	}
+
+	RenderScene();
+	Profiler::EndFrame();
+}
+
+// Renders the instances of the scene in view of the camera into the framebuffer, and
+// records what it is rendered from if capturing.
+void OfflineRenderer::RenderScene()
+{
+	if (_capture != NULL)
+		_capture->WriteFrame(_displayMode, _camera, _scene);
+
+	BeginFrame();
+	{
+		PROFILE_SCOPE(ProfileStageScene);
+		_scene->QueryFrustum(_camera, _visibleInstances);
+	}
+	{
+		PROFILE_SCOPE(ProfileStageSubmit);
+		_renderQueue->Begin(_camera, _rasterizer);
+		for (unsigned int i = 0; i < _visibleInstances.size(); i++)
+			_renderQueue->Submit(_visibleInstances[i], _displayMode);
+	}
+	_renderQueue->Execute();
+
+	// When pipelined the frame drawn is the one whose geometry was processed last time.
+	if (_renderQueue->GetPipelineOn() == true)
+	{
+		FinishFrame(_pipelineGeometryStats);
+		_pipelineGeometryStats = _renderQueue->GetStats();
+	}
+	else
+		FinishFrame(_renderQueue->GetStats());
+}
+
+// Enables the lights the display mode uses, and gives the lists to the rasterizer and
+// render queue if they have changed.
+void OfflineRenderer::UpdateLights()
+{
+	if (_lightsChanged == false)
+		return;
+	_lightsChanged = false;
+
+	bool ambientOn = false;
+	bool directionalOn = false;
+	bool pointOn = false;
+	bool normalMapOn = false;
+	switch (_displayMode)
+	{
+	case FlatShadedAmbient:
+	case GouraudShadedAmbient:
+	case TexturedAmbient:
+		ambientOn = true;
+		break;
+	case FlatShadedDirectionalAmbient:
+	case GouraudShadedDirectionalAmbient:
+	case TexturedDirectionalAmbient:
+		ambientOn = true;
+		directionalOn = true;
+		break;
+	case TexturedNormalMappedDirectionalAmbient:
+		ambientOn = true;
+		directionalOn = true;
+		normalMapOn = true;
+		break;
+	case FlatShadedDirectionalPointAmient:
+	case GouraudShadedDirectionalPointAmient:
+	case TexturedDirectionalPointAmbient:
+		ambientOn = true;
+		directionalOn = true;
+		pointOn = true;
+		break;
+	case TexturedNormalMappedDirectionalPointAmbient:
+		ambientOn = true;
+		directionalOn = true;
+		pointOn = true;
+		normalMapOn = true;
+		break;
+	default:
+		break;
+	}
+
+	for (unsigned int i = 0; i < _directionalLightList.size(); i++)
+		_directionalLightList[i]->SetEnabled(directionalOn);
+	for (unsigned int i = 0; i < _ambientLightList.size(); i++)
+		_ambientLightList[i]->SetEnabled(ambientOn);
+	for (unsigned int i = 0; i < _pointLightList.size(); i++)
+		_pointLightList[i]->SetEnabled(pointOn);
+	_unlitAmbientLight->SetEnabled(ambientOn == false && directionalOn == false);
+
+	// Only models loaded with a normal map can be drawn with one.
+	for (unsigned int i = 0; i < _models.size(); i++)
+	{
+		BYTE* normalMap = NULL;
+		Gdiplus::Color* palette = NULL;
+		int normalMapWidth = 0;
+		_models[i]->GetNormalMapTexture(&normalMap, &palette, &normalMapWidth);
+		_models[i]->SetNormalMapOn(normalMapOn == true && normalMap != NULL);
+	}
+
+	_rasterizer->SetLights(_directionalLightList, _ambientLightList, _pointLightList);
+	_renderQueue->SetLights(_directionalLightList, _ambientLightList, _pointLightList, _spotLightList);
+}
+
+// Moves the camera to where its path is at the given frame.
+void OfflineRenderer::UpdateCamera(int frame)
+{
+	float rotation = 0.0f;
+	float x = OFFLINE_CAMERA_X;
+	float z = OFFLINE_CAMERA_Z;
+	switch (_cameraPath)
+	{
+	case CameraPathOrbit:
+		// Turn the starting position around the y axis, and turn the camera with it so
+		// it keeps looking at the origin.
+		rotation = OFFLINE_ORBIT_STEP * frame;
+		x = (OFFLINE_CAMERA_X * cos(rotation)) + (OFFLINE_CAMERA_Z * sin(rotation));
+		z = (OFFLINE_CAMERA_Z * cos(rotation)) - (OFFLINE_CAMERA_X * sin(rotation));
+		break;
+	case CameraPathDolly:
+		z += OFFLINE_DOLLY_DISTANCE * sin(OFFLINE_DOLLY_STEP * frame);
+		break;
+	default:
+		break;
+	}
+
+	Vertex position(x, OFFLINE_CAMERA_Y, z, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0);
+	_camera->SetRotation(0, rotation, 0);
+	_camera->SetPosition(position);
+}
+
+// Starts rendering a frame into the framebuffer.
+void OfflineRenderer::BeginFrame()
+{
+	_rasterizer->BeginLockBits();
+	_rasterizer->ResetStats();
+	_rasterizer->ResetSetupBytesWritten();
+
+	PROFILE_SCOPE(ProfileStageClear);
+	_rasterizer->Clear(OFFLINE_CLEAR_COLOR);
+}
+
+// Finishes rendering a frame, drawing the debug view over it if one is on. Its stats are
+// the given stats of its geometry and those the rasterizer counted drawing it.
+void OfflineRenderer::FinishFrame(const RenderStats& geometryStats)
+{
+	_rasterizer->DrawDebugView();
+	_rasterizer->FinishLockBits();
+
+	_stats = geometryStats;
+	_stats.Add(_rasterizer->GetStats());
+}
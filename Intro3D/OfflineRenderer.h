@@ -0,0 +1,168 @@
+// =========================================================================================
+//	OfflineRenderer.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Rasterizer.h"
+#include "Model3D.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "DisplayMode.h"
+#include "FrameCapture.h"
+#include <vector>
+
+// Position the camera starts at, the same view as the demonstration.
+#define OFFLINE_CAMERA_X			0.0f
+#define OFFLINE_CAMERA_Y			50.0f
+#define OFFLINE_CAMERA_Z			-100.0f
+
+// Radians the orbiting camera turns around the scene each frame.
+#define OFFLINE_ORBIT_STEP			0.05f
+
+// How far the dollying camera moves in and out of the scene, and the radians of the
+// movement it goes through each frame.
+#define OFFLINE_DOLLY_DISTANCE		60.0f
+#define OFFLINE_DOLLY_STEP			0.05f
+
+// Radians the character in the demonstration scene turns each frame.
+#define OFFLINE_DEMO_SPIN			0.05f
+
+// Color the frame is cleared to before anything is drawn.
+#define OFFLINE_CLEAR_COLOR			Gdiplus::Color::SteelBlue
+
+// Paths the camera can follow. Each is a function of the frame number alone, so the
+// same frame always looks the same however the frames before it were rendered.
+enum CameraPath
+{
+	CameraPathStatic,		// Stays where the demonstration camera is.
+	CameraPathOrbit,		// Turns around the origin of the scene.
+	CameraPathDolly			// Moves towards and away from the origin of the scene.
+};
+
+// Number of camera paths in the enumeration above.
+#define CAMERA_PATH_COUNT	3
+
+// An instance placed in the scene by the offline renderer, and how it is animated.
+struct OfflineInstance
+{
+	int sceneIndex;
+	Vector3D position;
+	float spin;				// Radians turned around the y axis each frame.
+};
+
+// This class renders frames without a window, into a framebuffer held in memory. The
+// scene is built from models and lights given to it, and each frame is rendered as a
+// function of its number, so a sequence of frames can be rendered again and give the
+// same images. Frames are rendered on the calling thread, with the geometry processed
+// on the job system if one is set.
+//
+// The display modes use the lights the same way the demonstration does, unlit modes use
+// a white ambient light the renderer adds itself, and only the lights named by the other
+// modes are enabled in them.
+//
+// When pipelined each frame is drawn while the next is rendered, so the framebuffer holds
+// the frame before the one last rendered, and Flush draws the last one. Flush only applies
+// to pipelined rendering, otherwise it does nothing.
+//
+// The frames rendered can be recorded to a capture file, and the frames of a capture can
+// be rendered instead of animating the scene. A renderer replaying a capture loads its
+// models and lights from it, so should not be given any of its own.
+class OfflineRenderer
+{
+	public:
+		OfflineRenderer(unsigned int width, unsigned int height);
+		~OfflineRenderer(void);
+
+		int LoadModel(const char* modelFilename, const char* textureFilename = NULL, const char* normalMapFilename = NULL);
+		int AddInstance(int model, const Vector3D& position, float spin, RenderLayer layer = RenderLayerScene);
+		void AddDirectionalLight(const Vector3D& position, const Gdiplus::Color& intensity);
+		void AddAmbientLight(const Gdiplus::Color& intensity);
+		void AddPointLight(const Vector3D& position, const Gdiplus::Color& intensity, float atnA, float atnB, float atnC);
+
+		bool LoadDemoModels();
+		void AddDemoLights();
+
+		void SetDisplayMode(DisplayMode mode);
+		DisplayMode GetDisplayMode();
+
+		void SetCameraPath(CameraPath path);
+		CameraPath GetCameraPath();
+
+		void SetDebugView(DebugView view);
+		DebugView GetDebugView();
+
+		void SetColormapOn(bool val);
+		bool GetColormapOn();
+
+		void SetJobSystem(JobSystem* jobSystem);
+		void SetPipelineOn(bool val);
+		bool GetPipelineOn();
+
+		void RenderFrame(int frame);
+		void Flush();
+
+		bool StartCapture(const char* filename);
+		void StopCapture();
+
+		bool LoadCapture(const FrameCapture& capture);
+		void RenderCapturedFrame(const CapturedFrame& frame);
+
+		Gdiplus::Bitmap* GetFrame();
+		Rasterizer* GetRasterizer();
+		RenderQueue* GetRenderQueue();
+		Scene* GetScene();
+		Camera* GetCamera();
+		unsigned int GetModelCount();
+		unsigned int GetInstanceCount();
+		const RenderStats& GetStats();
+
+		static const char* GetDisplayModeName(DisplayMode mode);
+		static const char* GetCameraPathName(CameraPath path);
+		static const char* GetDebugViewName(DebugView view);
+
+	private:
+		Rasterizer* _rasterizer;
+		Camera* _camera;
+		Scene* _scene;
+		RenderQueue* _renderQueue;
+		DisplayMode _displayMode;
+		CameraPath _cameraPath;
+
+		std::vector<Model3D*> _models;
+		std::vector<CapturedModel> _modelFiles;
+		std::vector<OfflineInstance> _instances;
+		std::vector<ModelInstance*> _visibleInstances;
+
+		// Lighting lists, the unlit ambient light is always the first ambient light.
+		std::vector<DirectionalLight*> _directionalLightList;
+		std::vector<AmbientLight*> _ambientLightList;
+		std::vector<PointLight*> _pointLightList;
+		std::vector<SpotLight*> _spotLightList;
+		AmbientLight* _unlitAmbientLight;
+		bool _lightsChanged;
+		bool _colormapOn;
+
+		// Stats of the frame in the framebuffer, and when pipelined those of the geometry
+		// processed for the frame that will be drawn next.
+		RenderStats _stats;
+		RenderStats _pipelineGeometryStats;
+
+		// Capture the frames are recorded to, and the lights loaded from a capture in the
+		// order their states are stored in its frames.
+		FrameCapture* _capture;
+		std::vector<Light*> _capturedLights;
+
+		void UpdateLights();
+		void UpdateCamera(int frame);
+		void RenderScene();
+		void BeginFrame();
+		void FinishFrame(const RenderStats& geometryStats);
+
+		// Private constructor. Should not be used directly.
+		OfflineRenderer(void);
+};
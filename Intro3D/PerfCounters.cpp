@@ -0,0 +1,259 @@
+// =========================================================================================
+//	PerfCounters.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "PerfCounters.h"
+#include <mutex>
+#ifdef PERF_COUNTERS_SUPPORTED
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+// Names of each counter, indexed by PerfCounter.
+static const char* PerfCounterNames[PERF_COUNTER_COUNT] =
+{
+	"Cycles",
+	"Instructions",
+	"L1DMisses",
+	"LLCMisses",
+	"BranchMisses"
+};
+
+// Clears every count.
+void PerfCounterValues::Reset()
+{
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		counts[i] = 0;
+}
+
+// Adds the counts of another set of values to these.
+void PerfCounterValues::Add(const PerfCounterValues& values)
+{
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		counts[i] += values.counts[i];
+}
+
+// Takes the counts of an earlier read away from these, leaving the counts in between. The
+// counts are scaled when the counters take turns, so they are kept from going below 0.
+void PerfCounterValues::Subtract(const PerfCounterValues& values)
+{
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		counts[i] = (counts[i] > values.counts[i]) ? counts[i] - values.counts[i] : 0;
+}
+
+// Returns the instructions retired per cycle, or 0 if no cycles were counted.
+double PerfCounterValues::GetInstructionsPerCycle() const
+{
+	if (counts[PerfCounterCycles] == 0)
+		return 0;
+	return counts[PerfCounterInstructions] / (double)counts[PerfCounterCycles];
+}
+
+// Whether the counters could be opened, which of them could, and why not if none could.
+// Worked out once by the first thread to ask.
+static std::once_flag PerfCountersProbed;
+static bool PerfCountersSupported = false;
+static bool PerfCounterAvailable[PERF_COUNTER_COUNT];
+static char PerfCountersUnsupportedReason[256] = "";
+
+#ifdef PERF_COUNTERS_SUPPORTED
+
+// Event type and config of each counter, indexed by PerfCounter.
+struct PerfCounterEvent
+{
+	unsigned int type;
+	unsigned long long config;
+};
+
+static const PerfCounterEvent PerfCounterEvents[PERF_COUNTER_COUNT] =
+{
+	{ PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE,	PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE,	PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE,	PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_HARDWARE,	PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+// The counters of a single thread, opened as one group so they are all read at once
+// through the first of them.
+struct PerfCounterGroup
+{
+	int fds[PERF_COUNTER_COUNT];		// -1 for the counters that are not open.
+	int slots[PERF_COUNTER_COUNT];		// Where each counter is in a read of the group.
+	int count;
+	int leader;
+	bool opened;
+
+	PerfCounterGroup()
+	{
+		for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		{
+			fds[i] = -1;
+			slots[i] = -1;
+		}
+		count = 0;
+		leader = -1;
+		opened = false;
+	}
+	~PerfCounterGroup()
+	{
+		Close();
+	}
+
+	// Opens the counters for the calling thread. Only the counters available is true for
+	// are opened, or every counter if it is NULL. Returns the errno of the last counter that
+	// could not be opened, or 0.
+	int Open(const bool* available)
+	{
+		opened = true;
+		int error = 0;
+		for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		{
+			if (available != NULL && available[i] == false)
+				continue;
+
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = PerfCounterEvents[i].type;
+			attr.config = PerfCounterEvents[i].config;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+
+			int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+			if (fd < 0)
+			{
+				error = errno;
+				continue;
+			}
+
+			if (leader < 0)
+				leader = fd;
+			fds[i] = fd;
+			slots[i] = count++;
+		}
+		return error;
+	}
+
+	void Close()
+	{
+		// The group members are closed before the leader.
+		for (int i = PERF_COUNTER_COUNT - 1; i >= 0; i--)
+		{
+			if (fds[i] >= 0 && fds[i] != leader)
+				close(fds[i]);
+		}
+		if (leader >= 0)
+			close(leader);
+
+		for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		{
+			fds[i] = -1;
+			slots[i] = -1;
+		}
+		count = 0;
+		leader = -1;
+	}
+};
+
+static thread_local PerfCounterGroup CurrentPerfCounterGroup;
+
+#endif
+
+// Finds out which counters can be opened, by opening them all once on the calling thread.
+static void ProbePerfCounters()
+{
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		PerfCounterAvailable[i] = false;
+
+#ifdef PERF_COUNTERS_SUPPORTED
+	PerfCounterGroup group;
+	int error = group.Open(NULL);
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+		PerfCounterAvailable[i] = (group.fds[i] >= 0);
+	PerfCountersSupported = (group.count > 0);
+
+	if (PerfCountersSupported == false)
+	{
+		if (error == ENOENT || error == EOPNOTSUPP)
+			snprintf(PerfCountersUnsupportedReason, sizeof(PerfCountersUnsupportedReason), "the processor has no performance counters that can be used (%s)", strerror(error));
+		else if (error == EACCES || error == EPERM)
+			snprintf(PerfCountersUnsupportedReason, sizeof(PerfCountersUnsupportedReason), "perf events are not allowed, see /proc/sys/kernel/perf_event_paranoid (%s)", strerror(error));
+		else
+			snprintf(PerfCountersUnsupportedReason, sizeof(PerfCountersUnsupportedReason), "perf_event_open failed (%s)", strerror(error));
+	}
+#else
+	snprintf(PerfCountersUnsupportedReason, sizeof(PerfCountersUnsupportedReason), "hardware counters are only read on Linux");
+#endif
+}
+
+// Returns true if at least one of the counters can be read.
+bool PerfCounters::GetSupported()
+{
+	std::call_once(PerfCountersProbed, ProbePerfCounters);
+	return PerfCountersSupported;
+}
+
+// Returns why no counters can be read, or an empty string if some can.
+const char* PerfCounters::GetUnsupportedReason()
+{
+	GetSupported();
+	return PerfCountersUnsupportedReason;
+}
+
+// Returns true if the given counter can be read.
+bool PerfCounters::GetCounterAvailable(PerfCounter counter)
+{
+	GetSupported();
+	return PerfCounterAvailable[counter];
+}
+
+// Returns the name of the given counter.
+const char* PerfCounters::GetCounterName(PerfCounter counter)
+{
+	return PerfCounterNames[counter];
+}
+
+// Reads the counts of the calling threads counters, opening them the first time. The
+// counts only mean anything as the difference between two reads on the same thread.
+void PerfCounters::Read(PerfCounterValues& values)
+{
+	values.Reset();
+	if (GetSupported() == false)
+		return;
+
+#ifdef PERF_COUNTERS_SUPPORTED
+	PerfCounterGroup& group = CurrentPerfCounterGroup;
+	if (group.opened == false)
+		group.Open(PerfCounterAvailable);
+	if (group.count == 0)
+		return;
+
+	// A group read is the number of counters, the time the group was enabled and running
+	// for, then the count of each counter in the order they were opened.
+	unsigned long long buffer[3 + PERF_COUNTER_COUNT];
+	ssize_t size = read(group.leader, buffer, sizeof(buffer));
+	if (size < (ssize_t)((3 + group.count) * sizeof(unsigned long long)))
+		return;
+
+	unsigned long long enabled = buffer[1];
+	unsigned long long running = buffer[2];
+	if (running == 0)
+		return;
+	double scale = (running < enabled) ? enabled / (double)running : 1.0;
+
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+	{
+		if (group.slots[i] >= 0)
+			values.counts[i] = (unsigned long long)(buffer[3 + group.slots[i]] * scale);
+	}
+#endif
+}
@@ -0,0 +1,60 @@
+// =========================================================================================
+//	PerfCounters.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+
+// Hardware counters are read with perf_event_open, so they are only supported on Linux.
+#if defined(__linux__)
+#define PERF_COUNTERS_SUPPORTED
+#endif
+
+// Hardware events that are counted.
+enum PerfCounter
+{
+	PerfCounterCycles,				// CPU cycles.
+	PerfCounterInstructions,		// Instructions retired.
+	PerfCounterL1DMisses,			// Level 1 data cache read misses.
+	PerfCounterLLCMisses,			// Last level cache misses.
+	PerfCounterBranchMisses			// Mispredicted branches.
+};
+
+// Number of counters in the enumeration above.
+#define PERF_COUNTER_COUNT		5
+
+// Counts of each of the counters, as read or summed. Counters that are not available
+// stay at 0. This is plain data so the profile scopes can hold one without clearing it,
+// Reset should be called before adding to one.
+struct PerfCounterValues
+{
+	unsigned long long counts[PERF_COUNTER_COUNT];
+
+	void Reset();
+	void Add(const PerfCounterValues& values);
+	void Subtract(const PerfCounterValues& values);
+
+	double GetInstructionsPerCycle() const;
+};
+
+// This class reads the hardware performance counters of the calling thread. Each thread
+// opens its own group of counters the first time it reads them, and they count only
+// while that thread is running in user mode. Whether the counters can be opened at all is
+// found out once, by the first call to GetSupported or Read. Containers, virtual machines
+// and kernels that do not allow perf events have no counters, in which case every read
+// returns zeros and GetUnsupportedReason says why.
+//
+// Some processors cannot count every event at once, then the kernel takes turns counting
+// them and the counts read are scaled up by how long they were counted for.
+class PerfCounters
+{
+	public:
+		static bool GetSupported();
+		static const char* GetUnsupportedReason();
+		static bool GetCounterAvailable(PerfCounter counter);
+		static const char* GetCounterName(PerfCounter counter);
+
+		static void Read(PerfCounterValues& values);
+};
@@ -12,6 +12,9 @@
 Polygon3D::Polygon3D(void)
 {
 	_avgDepth = 0.0f;
+	_backfacing = false;
+	_culled = false;
+	_generated = false;
 }
 Polygon3D::Polygon3D(int i1, int i2, int i3)
 {
@@ -19,6 +22,9 @@ Polygon3D::Polygon3D(int i1, int i2, int i3)
 	_vertexIndexes[1] = i2;
 	_vertexIndexes[2] = i3;
 	_avgDepth = 0.0f;
+	_backfacing = false;
+	_culled = false;
+	_generated = false;
 }
 
 // Copy constructor.
@@ -71,6 +77,22 @@ bool Polygon3D::GetBackfacing()
 {
 	return _backfacing;
 }
+void Polygon3D::SetCulled(bool value)
+{
+	_culled = value;
+}
+bool Polygon3D::GetCulled()
+{
+	return _culled;
+}
+void Polygon3D::SetGenerated(bool value)
+{
+	_generated = value;
+}
+bool Polygon3D::GetGenerated()
+{
+	return _generated;
+}
 void Polygon3D::SetAvgDepth(float value)
 {
 	_avgDepth = value;
@@ -98,6 +120,8 @@ void Polygon3D::Copy(const Polygon3D& poly)
 	_uvIndexes[1] = poly._uvIndexes[1];
 	_uvIndexes[2] = poly._uvIndexes[2];
 	_backfacing = poly._backfacing;
+	_culled = poly._culled;
+	_generated = poly._generated;
 	_avgDepth = poly._avgDepth;
 	_color = poly._color;
 }
@@ -32,6 +32,12 @@ class Polygon3D
 		void SetBackfacing(bool value);
 		bool GetBackfacing();
 
+		void SetCulled(bool value);
+		bool GetCulled();
+
+		void SetGenerated(bool value);
+		bool GetGenerated();
+
 		void SetAvgDepth(float value);
 		float GetAvgDepth() const;
 		
@@ -42,6 +48,8 @@ class Polygon3D
 		int _vertexIndexes[3];
 		int _uvIndexes[3];
 		bool _backfacing;
+		bool _culled;		// Outside the view frustum, or replaced by the polygons it was clipped into.
+		bool _generated;	// Created by clipping, removed again at the start of the next frame.
 		float _avgDepth;
 		Color _color;
 		
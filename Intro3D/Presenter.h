@@ -0,0 +1,19 @@
+// =========================================================================================
+//	Presenter.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+
+// Our base presenter class. A presenter shows the frames the renderer has completed, it
+// is called on the presenting thread with the latest frame from the swap chain and can 
+// use it until it is next called.
+class Presenter
+{
+	public:
+		virtual ~Presenter(void) {}
+
+		virtual void Present(Gdiplus::Bitmap* frame) = 0;
+};
@@ -0,0 +1,368 @@
+// =========================================================================================
+//	Profiler.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "Profiler.h"
+#include <chrono>
+#include <mutex>
+
+// Name and trace category of each stage, indexed by ProfileStage.
+struct ProfileStageInfo
+{
+	const char* name;
+	const char* category;
+};
+
+static const ProfileStageInfo ProfileStages[PROFILE_STAGE_COUNT] =
+{
+	{ "Frame",					"Frame" },
+	{ "Clear",					"Frame" },
+	{ "Scene",					"Frame" },
+	{ "Submit",					"Frame" },
+	{ "Cull",					"Geometry" },
+	{ "Transform",				"Geometry" },
+	{ "Backfaces",				"Geometry" },
+	{ "Normals",				"Geometry" },
+	{ "LightingAmbient",		"Lighting" },
+	{ "LightingDirectional",	"Lighting" },
+	{ "LightingPoint",			"Lighting" },
+	{ "LightingSpot",			"Lighting" },
+	{ "Viewport",				"Geometry" },
+	{ "Clip",					"Geometry" },
+	{ "Depths",					"Geometry" },
+	{ "Sort",					"Geometry" },
+	{ "Project",				"Geometry" },
+	{ "Draw",					"Raster" },
+	{ "Setup",					"Raster" },
+	{ "Spans",					"Raster" }
+};
+
+// Events and stage totals of a single thread. Only the thread that owns it writes to it,
+// the head is the number of events it has ever written and the totals are the nanoseconds
+// it has spent in each stage and the counts of the counters and allocations in each, all
+// only ever grow.
+struct ProfileThread
+{
+	ProfileEvent* events;
+	std::atomic<unsigned int> head;
+	std::atomic<long long> stageTotals[PROFILE_STAGE_COUNT];
+	std::atomic<unsigned long long> stageCounters[PROFILE_STAGE_COUNT][PERF_COUNTER_COUNT];
+	std::atomic<unsigned long long> stageAllocations[PROFILE_STAGE_COUNT];
+	std::atomic<bool> inUse;
+};
+
+// Gives the threads slot back when the thread exits, so a later thread can take it over.
+struct ProfileThreadHandle
+{
+	ProfileThread* thread;
+
+	ProfileThreadHandle() : thread(NULL) {}
+	~ProfileThreadHandle()
+	{
+		if (thread != NULL)
+			thread->inUse = false;
+	}
+};
+
+std::atomic<bool> Profiler::_enabled(false);
+std::atomic<bool> Profiler::_countersEnabled(false);
+
+// Slots of the threads that have recorded events. Slots are only handed out under the
+// mutex, recording into a slot needs no lock.
+static ProfileThread ProfileThreads[PROFILER_MAX_THREADS];
+static std::atomic<int> ProfileThreadCount(0);
+static std::mutex ProfileThreadMutex;
+static thread_local ProfileThreadHandle CurrentProfileThread;
+
+// Frame state, only used by the thread rendering the frames.
+static std::atomic<unsigned int> ProfileFrame(0);
+static long long ProfileFrameStart = -1;
+static bool ProfileFrameCountersOn = false;
+static PerfCounterValues ProfileFrameCounters;
+static unsigned long long ProfileFrameAllocations = 0;
+static long long ProfileLastTotals[PROFILER_MAX_THREADS][PROFILE_STAGE_COUNT];
+static double ProfileHistory[PROFILER_AVERAGE_FRAMES][PROFILE_STAGE_COUNT];
+static unsigned int ProfileHistoryCount = 0;
+static unsigned int ProfileHistoryIndex = 0;
+
+// Returns the slot of the calling thread, taking a free one the first time the thread
+// records an event. Returns NULL if every slot is taken.
+static ProfileThread* GetProfileThread()
+{
+	if (CurrentProfileThread.thread != NULL)
+		return CurrentProfileThread.thread;
+
+	std::lock_guard<std::mutex> lock(ProfileThreadMutex);
+
+	int count = ProfileThreadCount;
+	int slot = -1;
+	for (int i = 0; i < count && slot < 0; i++)
+	{
+		if (ProfileThreads[i].inUse == false)
+			slot = i;
+	}
+	if (slot < 0)
+	{
+		if (count >= PROFILER_MAX_THREADS)
+			return NULL;
+		slot = count;
+	}
+
+	// A worker can record for the first time in any frame, so making its events is not
+	// held against the steady state allocation check.
+	ProfileThread* thread = &ProfileThreads[slot];
+	if (thread->events == NULL)
+	{
+		AllocationTracker::SetThreadExempt(true);
+		thread->events = new ProfileEvent[PROFILER_EVENTS_PER_THREAD];
+		AllocationTracker::SetThreadExempt(false);
+	}
+	thread->inUse = true;
+	ProfileThreadCount = max(count, slot + 1);
+
+	CurrentProfileThread.thread = thread;
+	return thread;
+}
+
+// Turns recording on or off. Scopes already started when it is turned off still record.
+void Profiler::SetEnabled(bool val)
+{
+	_enabled = val;
+}
+bool Profiler::GetEnabled()
+{
+	return _enabled;
+}
+
+// Turns reading the hardware counters in each scope on or off. Does nothing to the
+// recording if the counters are not supported, see PerfCounters.
+void Profiler::SetCountersEnabled(bool val)
+{
+	_countersEnabled = (val == true && PerfCounters::GetSupported() == true);
+}
+bool Profiler::GetCountersEnabled()
+{
+	return _countersEnabled;
+}
+
+// Returns the current time in nanoseconds.
+long long Profiler::GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns the number of the current frame, the first frame is frame 1.
+unsigned int Profiler::GetFrame()
+{
+	return ProfileFrame;
+}
+
+// Starts a new frame, events recorded from now on belong to it. Also starts the frame of
+// the allocation tracker, which counts frames whether or not the profiler is enabled.
+void Profiler::BeginFrame()
+{
+	AllocationTracker::BeginFrame();
+	if (_enabled == false)
+		return;
+
+	ProfileFrame++;
+	ProfileFrameCountersOn = _countersEnabled;
+	if (ProfileFrameCountersOn == true)
+		PerfCounters::Read(ProfileFrameCounters);
+	ProfileFrameAllocations = AllocationTracker::GetThreadAllocations();
+	ProfileFrameStart = GetTime();
+}
+
+// Finishes the frame, records it as a whole and adds the time each stage took across all
+// threads to the rolling averages.
+void Profiler::EndFrame()
+{
+	AllocationTracker::EndFrame();
+	if (_enabled == false || ProfileFrameStart < 0)
+		return;
+
+	long long end = GetTime();
+	if (ProfileFrameCountersOn == true)
+		RecordCounters(ProfileStageFrame, ProfileFrameCounters);
+	RecordAllocations(ProfileStageFrame, ProfileFrameAllocations);
+	Record(ProfileStageFrame, ProfileFrameStart, end);
+	ProfileFrameStart = -1;
+
+	double* frameTimes = ProfileHistory[ProfileHistoryIndex];
+	for (int i = 0; i < PROFILE_STAGE_COUNT; i++)
+		frameTimes[i] = 0;
+
+	int count = ProfileThreadCount;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < PROFILE_STAGE_COUNT; j++)
+		{
+			long long total = ProfileThreads[i].stageTotals[j].load(std::memory_order_relaxed);
+			frameTimes[j] += (total - ProfileLastTotals[i][j]) / 1000000.0;
+			ProfileLastTotals[i][j] = total;
+		}
+	}
+
+	ProfileHistoryIndex = (ProfileHistoryIndex + 1) % PROFILER_AVERAGE_FRAMES;
+	ProfileHistoryCount = min(ProfileHistoryCount + 1, (unsigned int)PROFILER_AVERAGE_FRAMES);
+}
+
+// Returns the milliseconds spent in the stage each frame, across all threads, averaged
+// over the last PROFILER_AVERAGE_FRAMES frames.
+double Profiler::GetStageAverage(ProfileStage stage)
+{
+	if (ProfileHistoryCount == 0)
+		return 0;
+
+	double total = 0;
+	for (unsigned int i = 0; i < ProfileHistoryCount; i++)
+		total += ProfileHistory[i][stage];
+	return total / ProfileHistoryCount;
+}
+
+// Returns the number of frames the averages are taken over so far.
+unsigned int Profiler::GetAverageFrameCount()
+{
+	return ProfileHistoryCount;
+}
+
+// Returns the name of the stage, as it is shown in traces.
+const char* Profiler::GetStageName(ProfileStage stage)
+{
+	return ProfileStages[stage].name;
+}
+
+// Adds the counts of every thread spent in the stage since the counters were enabled to
+// the given values. The frame stage only counts the thread rendering the frames.
+void Profiler::GetStageCounters(ProfileStage stage, PerfCounterValues& values)
+{
+	int count = ProfileThreadCount;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < PERF_COUNTER_COUNT; j++)
+			values.counts[j] += ProfileThreads[i].stageCounters[stage][j].load(std::memory_order_relaxed);
+	}
+}
+
+// Returns the allocations made in the stage by every thread since the program started.
+// The frame stage only counts the thread rendering the frames.
+unsigned long long Profiler::GetStageAllocations(ProfileStage stage)
+{
+	unsigned long long total = 0;
+	int count = ProfileThreadCount;
+	for (int i = 0; i < count; i++)
+		total += ProfileThreads[i].stageAllocations[stage].load(std::memory_order_relaxed);
+	return total;
+}
+
+// Records that the calling thread spent the given time in the stage.
+void Profiler::Record(ProfileStage stage, long long start, long long end)
+{
+	ProfileThread* thread = GetProfileThread();
+	if (thread == NULL)
+		return;
+
+	unsigned int head = thread->head.load(std::memory_order_relaxed);
+	ProfileEvent& event = thread->events[head % PROFILER_EVENTS_PER_THREAD];
+	event.start = start;
+	event.end = end;
+	event.frame = ProfileFrame.load(std::memory_order_relaxed);
+	event.stage = stage;
+	thread->head.store(head + 1, std::memory_order_release);
+
+	std::atomic<long long>& total = thread->stageTotals[stage];
+	total.store(total.load(std::memory_order_relaxed) + (end - start), std::memory_order_relaxed);
+}
+
+// Records the counts of the calling threads counters since the given read as spent in
+// the stage.
+void Profiler::RecordCounters(ProfileStage stage, const PerfCounterValues& start)
+{
+	PerfCounterValues counters;
+	PerfCounters::Read(counters);
+	counters.Subtract(start);
+
+	ProfileThread* thread = GetProfileThread();
+	if (thread == NULL)
+		return;
+
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+	{
+		std::atomic<unsigned long long>& total = thread->stageCounters[stage][i];
+		total.store(total.load(std::memory_order_relaxed) + counters.counts[i], std::memory_order_relaxed);
+	}
+}
+
+// Records the allocations the calling thread made since the given count as made in the
+// stage.
+void Profiler::RecordAllocations(ProfileStage stage, unsigned long long start)
+{
+	unsigned long long allocations = AllocationTracker::GetThreadAllocations() - start;
+	if (allocations == 0)
+		return;
+
+	ProfileThread* thread = GetProfileThread();
+	if (thread == NULL)
+		return;
+
+	std::atomic<unsigned long long>& total = thread->stageAllocations[stage];
+	total.store(total.load(std::memory_order_relaxed) + allocations, std::memory_order_relaxed);
+}
+
+// Writes the events of the last frameCount frames still held by the threads, in the
+// Chrome trace event format. Returns false if the file could not be written.
+bool Profiler::WriteTrace(const char* filename, unsigned int frameCount)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+		return false;
+
+	unsigned int lastFrame = ProfileFrame;
+	unsigned int firstFrame = (lastFrame >= frameCount) ? lastFrame - frameCount + 1 : 0;
+	int count = ProfileThreadCount;
+
+	// Times are written relative to the first event written.
+	long long origin = -1;
+	for (int i = 0; i < count; i++)
+	{
+		ProfileThread& thread = ProfileThreads[i];
+		unsigned int head = thread.head.load(std::memory_order_acquire);
+		unsigned int held = min(head, (unsigned int)PROFILER_EVENTS_PER_THREAD);
+		for (unsigned int j = head - held; j != head; j++)
+		{
+			ProfileEvent& event = thread.events[j % PROFILER_EVENTS_PER_THREAD];
+			if (event.frame >= firstFrame && event.frame <= lastFrame && (origin < 0 || event.start < origin))
+				origin = event.start;
+		}
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Intro3D\"}}");
+	for (int i = 0; i < count; i++)
+	{
+		ProfileThread& thread = ProfileThreads[i];
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}", i, i);
+
+		unsigned int head = thread.head.load(std::memory_order_acquire);
+		unsigned int held = min(head, (unsigned int)PROFILER_EVENTS_PER_THREAD);
+		for (unsigned int j = head - held; j != head; j++)
+		{
+			ProfileEvent& event = thread.events[j % PROFILER_EVENTS_PER_THREAD];
+			if (event.frame < firstFrame || event.frame > lastFrame)
+				continue;
+
+			const ProfileStageInfo& info = ProfileStages[event.stage];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+					info.name, info.category, i, (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0, event.frame);
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	bool written = (ferror(file) == 0);
+	fclose(file);
+	return written;
+}
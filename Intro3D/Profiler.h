@@ -0,0 +1,161 @@
+// =========================================================================================
+//	Profiler.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+#include <atomic>
+
+// Compiles the profile scopes in. Set to false to remove them entirely, otherwise they
+// only cost a check of the enabled flag while the profiler is disabled.
+#define PROFILER_SCOPES_ON			true
+
+// Number of events each thread keeps, the oldest are overwritten once it is full.
+#define PROFILER_EVENTS_PER_THREAD	65536
+
+// Most threads that can record events at once.
+#define PROFILER_MAX_THREADS		64
+
+// Number of frames the per-stage averages are taken over.
+#define PROFILER_AVERAGE_FRAMES		60
+
+// Stages of a frame that are timed.
+enum ProfileStage
+{
+	ProfileStageFrame,					// Whole frame, from BeginFrame to EndFrame.
+	ProfileStageClear,					// Clearing the framebuffer.
+	ProfileStageScene,					// Updating and querying the scene.
+	ProfileStageSubmit,					// Submitting and sorting the render queue.
+	ProfileStageCull,					// Testing the instances against the view.
+	ProfileStageTransform,				// World transform of the vertexs.
+	ProfileStageBackfaces,				// Backface flags and resetting the lighting.
+	ProfileStageNormals,				// Summing and normalizing the vertex normals.
+	ProfileStageLightingAmbient,		// Ambient lighting pass.
+	ProfileStageLightingDirectional,	// Directional lighting pass.
+	ProfileStageLightingPoint,			// Point lighting pass.
+	ProfileStageLightingSpot,			// Spot lighting pass.
+	ProfileStageViewport,				// Viewport and perspective transforms.
+	ProfileStageClip,					// Clipping against the view.
+	ProfileStageDepths,					// Average depth of each polygon.
+	ProfileStageSort,					// Sorting the polygons by depth.
+	ProfileStageProject,				// Dehomogenizing and the screen transform.
+	ProfileStageDraw,					// Drawing a batch of instances.
+	ProfileStageSetup,					// Setting up the scanlines of a polygon.
+	ProfileStageSpans					// Shading the spans of a polygon.
+};
+
+// Number of stages in the enumeration above.
+#define PROFILE_STAGE_COUNT		20
+
+// A single timed stage, times are in nanoseconds.
+struct ProfileEvent
+{
+	long long start;
+	long long end;
+	unsigned int frame;
+	int stage;
+};
+
+// This class records how long each stage of each frame takes. Each thread writes the
+// stages it runs into a ring buffer of its own, so recording never takes a lock or waits
+// on another thread. The stage totals of every thread are gathered at the end of each
+// frame into rolling averages, and the events of the last few frames can be written out
+// as a trace that loads in chrome://tracing or Perfetto.
+//
+// With the counters enabled each scope also reads the hardware counters of its thread
+// when it starts and ends, and the counts in between are added up for its stage. Each
+// read is a system call, so the counters make the finer stages take noticeably longer.
+//
+// Each scope also counts the allocations its thread makes, see AllocationTracker. These
+// are counted whether or not the counters are enabled, as reading them costs nothing.
+//
+// BeginFrame, EndFrame and WriteTrace should be called from the thread that renders the
+// frames, between frames, while no other thread is recording.
+class Profiler
+{
+	public:
+		static void SetEnabled(bool val);
+		static bool GetEnabled();
+		static void SetCountersEnabled(bool val);
+		static bool GetCountersEnabled();
+
+		static void BeginFrame();
+		static void EndFrame();
+		static unsigned int GetFrame();
+
+		static double GetStageAverage(ProfileStage stage);
+		static unsigned int GetAverageFrameCount();
+		static const char* GetStageName(ProfileStage stage);
+		static void GetStageCounters(ProfileStage stage, PerfCounterValues& values);
+		static unsigned long long GetStageAllocations(ProfileStage stage);
+
+		static bool WriteTrace(const char* filename, unsigned int frameCount);
+
+		static long long GetTime();
+		static void Record(ProfileStage stage, long long start, long long end);
+		static void RecordCounters(ProfileStage stage, const PerfCounterValues& start);
+		static void RecordAllocations(ProfileStage stage, unsigned long long start);
+
+		// Read by every profile scope, so they are kept where the scopes can check them inline.
+		static std::atomic<bool> _enabled;
+		static std::atomic<bool> _countersEnabled;
+};
+
+// Times the rest of the block it is declared in as the given stage, if the profiler was
+// enabled when it was declared.
+class ProfileScope
+{
+	public:
+		ProfileScope(ProfileStage stage);
+		~ProfileScope(void);
+
+	private:
+		ProfileStage _stage;
+		long long _start;
+		unsigned long long _startAllocations;
+		bool _countersOn;
+		PerfCounterValues _startCounters;
+
+		// Private constructor. Should not be used directly.
+		ProfileScope(void);
+};
+
+// The scopes are inline so the check is all that is left while the profiler is disabled.
+inline ProfileScope::ProfileScope(ProfileStage stage)
+{
+	_stage = stage;
+	_start = -1;
+	if (Profiler::_enabled.load(std::memory_order_relaxed) == true)
+	{
+		_countersOn = Profiler::_countersEnabled.load(std::memory_order_relaxed);
+		if (_countersOn == true)
+			PerfCounters::Read(_startCounters);
+		_startAllocations = AllocationTracker::GetThreadAllocations();
+		_start = Profiler::GetTime();
+	}
+}
+
+inline ProfileScope::~ProfileScope(void)
+{
+	if (_start >= 0)
+	{
+		long long end = Profiler::GetTime();
+		if (_countersOn == true)
+			Profiler::RecordCounters(_stage, _startCounters);
+		Profiler::RecordAllocations(_stage, _startAllocations);
+		Profiler::Record(_stage, _start, end);
+	}
+}
+
+// Declares a profile scope for the rest of the block.
+#define PROFILE_SCOPE_NAME(line)	ProfileScope profileScope##line
+#define PROFILE_SCOPE_LINE(line)	PROFILE_SCOPE_NAME(line)
+#if PROFILER_SCOPES_ON
+#define PROFILE_SCOPE(stage)		PROFILE_SCOPE_LINE(__LINE__)(stage)
+#else
+#define PROFILE_SCOPE(stage)
+#endif
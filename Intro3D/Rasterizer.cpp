@@ -7,6 +7,22 @@
 
 #include "StdAfx.h"
 #include "Rasterizer.h"
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CLEAR_STREAM_ON
+#endif
+
+// Shortest run of pixels cleared with non-temporal stores. Shorter runs, like the parts of
+// tiles cleared just before a span is drawn over them, are better off going through the cache.
+#define CLEAR_STREAM_MIN_PIXELS	64
+
+// Makes sure non-temporal stores have reached memory before anything else reads the bitmap.
+static inline void FinishClearStores()
+{
+#ifdef CLEAR_STREAM_ON
+	_mm_sfence();
+#endif
+}
 
 // No-Argument Constructor. Declared private, should not get called.
 Rasterizer::Rasterizer(void)
@@ -14,6 +30,15 @@ Rasterizer::Rasterizer(void)
 	// Declared private so should not be called.
 	_bitmap = NULL;
 	_graphics = NULL;
+	_ownBitmap = NULL;
+	_ownGraphics = NULL;
+	_edgeXStart = NULL;
+	_edgeXEnd = NULL;
+	_varyingsStart = NULL;
+	_varyingsEnd = NULL;
+	_clearTiles = NULL;
+	_overdraw = NULL;
+	_tileCosts = NULL;
 }
 
 // Constructor. Sets up the rendering bitmap and graphics with the given the width and height.
@@ -24,23 +49,86 @@ Rasterizer::Rasterizer(unsigned int width, unsigned int height)
 	// handle that, but we will leave that for now. 
 	_width = width;
 	_height = height;
-	_bitmap = new Bitmap(_width, _height, PixelFormat32bppARGB);
-	_graphics = new Graphics(_bitmap);
+	_ownBitmap = new Bitmap(_width, _height, PixelFormat32bppARGB);
+	_ownGraphics = new Graphics(_ownBitmap);
+	_bitmap = _ownBitmap;
+	_graphics = _ownGraphics;
+	_setupBytesWritten = 0;
+	_clearBytesWritten = 0;
+	_bitsLocked = false;
+
+	// The scanline buffers are shared by every polygon we fill.
+	_edgeXStart = new int[_height];
+	_edgeXEnd = new int[_height];
+	_varyingsStart = new float[_height * MAX_VARYINGS];
+	_varyingsEnd = new float[_height * MAX_VARYINGS];
+
+	// Nothing is waiting to be cleared until the fast clear is used.
+	_fastClearOn = false;
+	_clearColor = 0;
+	_clearTilesPerRow = (_width + CLEAR_TILE_WIDTH - 1) / CLEAR_TILE_WIDTH;
+	_clearTiles = new BYTE[_clearTilesPerRow * _height];
+	memset(_clearTiles, 0, _clearTilesPerRow * _height);
+	_clearTilesPending = 0;
+
+	// The debug view counters are made the first time a debug view is turned on.
+	_debugView = DebugViewNone;
+	_overdraw = NULL;
+	_tileCosts = NULL;
+	_debugTilesPerRow = (_width + DEBUG_TILE_SIZE - 1) / DEBUG_TILE_SIZE;
+	_debugTileRows = (_height + DEBUG_TILE_SIZE - 1) / DEBUG_TILE_SIZE;
 }
 
 // Destructor.
 Rasterizer::~Rasterizer(void)
 {
 	// Clean up all dynamically created objects
-	if (_graphics)
+	_graphics = NULL;
+	_bitmap = NULL;
+	if (_ownGraphics)
 	{
-		delete _graphics;
-		_graphics = NULL;
+		delete _ownGraphics;
+		_ownGraphics = NULL;
 	}
-	if (_bitmap)
+	if (_ownBitmap)
 	{
-		delete _bitmap;
-		_bitmap = NULL;
+		delete _ownBitmap;
+		_ownBitmap = NULL;
+	}
+	if (_edgeXStart)
+	{
+		delete[] _edgeXStart;
+		_edgeXStart = NULL;
+	}
+	if (_edgeXEnd)
+	{
+		delete[] _edgeXEnd;
+		_edgeXEnd = NULL;
+	}
+	if (_varyingsStart)
+	{
+		delete[] _varyingsStart;
+		_varyingsStart = NULL;
+	}
+	if (_varyingsEnd)
+	{
+		delete[] _varyingsEnd;
+		_varyingsEnd = NULL;
+	}
+	if (_clearTiles)
+	{
+		delete[] _clearTiles;
+		_clearTiles = NULL;
+	}
+	if (_overdraw)
+	{
+		delete[] _overdraw;
+		_overdraw = NULL;
+	}
+	if (_tileCosts)
+	{
+		delete[] _tileCosts;
+		_tileCosts = NULL;
 	}
 }
 
@@ -57,23 +145,219 @@ Bitmap * Rasterizer::GetBitmap() const
 {
 	return _bitmap;
 }
-unsigned int Rasterizer::GetPolygonsRendered()
+// Sets the bitmap, and the graphics object drawing to it, that the rasterizer renders
+// into. The bitmap must be the same size as the rasterizer. Passing NULL renders into
+// the rasterizers own bitmap again.
+void Rasterizer::SetRenderTarget(Bitmap* bitmap, Graphics* graphics)
+{
+	bool bitsLocked = _bitsLocked;
+	FinishLockBits();
+
+	if (bitmap == NULL)
+	{
+		_bitmap = _ownBitmap;
+		_graphics = _ownGraphics;
+	}
+	else
+	{
+		_bitmap = bitmap;
+		_graphics = graphics;
+	}
+
+	if (bitsLocked == true)
+		BeginLockBits();
+}
+const RenderStats& Rasterizer::GetStats()
+{
+	return _stats;
+}
+void Rasterizer::ResetStats()
+{
+	_stats.Reset();
+}
+unsigned int Rasterizer::GetSetupBytesWritten()
 {
-	return _polygonsRendered;
+	return _setupBytesWritten;
 }
-void Rasterizer::ResetPolygonsRendered()
+void Rasterizer::ResetSetupBytesWritten()
 {
-	_polygonsRendered = 0;
+	_setupBytesWritten = 0;
+}
+unsigned int Rasterizer::GetClearBytesWritten()
+{
+	return _clearBytesWritten;
+}
+void Rasterizer::ResetClearBytesWritten()
+{
+	_clearBytesWritten = 0;
+}
+void Rasterizer::SetFastClearOn(bool val)
+{
+	_fastClearOn = val;
+}
+bool Rasterizer::GetFastClearOn()
+{
+	return _fastClearOn;
+}
+// Turns a debug view on or off. The counts start from the next clear, so the view should
+// be set before a frame is started. Does nothing if the debug views are compiled out.
+void Rasterizer::SetDebugView(DebugView view)
+{
+	if (DEBUG_VIEWS_ON == false)
+		return;
+
+	if (view != DebugViewNone && _overdraw == NULL)
+	{
+		_overdraw = new unsigned short[_width * _height];
+		memset(_overdraw, 0, _width * _height * sizeof(unsigned short));
+		_tileCosts = new long long[_debugTilesPerRow * _debugTileRows];
+		memset(_tileCosts, 0, _debugTilesPerRow * _debugTileRows * sizeof(long long));
+	}
+	_debugView = view;
+}
+DebugView Rasterizer::GetDebugView()
+{
+	return _debugView;
 }
 
-// Clear the bitmap using the specified colour
+// Clear the bitmap using the specified colour, writing straight into the locked bits. With
+// the fast clear on, the tiles are only flagged here and are filled when they are first
+// drawn to, leaving out the pixels drawn over, or when the bits are unlocked.
 void Rasterizer::Clear(const Color& color)
 {
-	if (_graphics)
+	BeginLockBits();
+	_clearColor = color.GetValue();
+
+	// The debug views count the work of each frame from its clear.
+	if (_debugView != DebugViewNone)
 	{
-		FinishLockBits();
-		_graphics->Clear(color);	
-		BeginLockBits();
+		memset(_overdraw, 0, _width * _height * sizeof(unsigned short));
+		memset(_tileCosts, 0, _debugTilesPerRow * _debugTileRows * sizeof(long long));
+	}
+
+	if (_fastClearOn == true)
+	{
+		memset(_clearTiles, 1, _clearTilesPerRow * _height);
+		_clearTilesPending = _clearTilesPerRow * _height;
+		return;
+	}
+
+	// Anything still waiting on an earlier fast clear is covered by this one.
+	memset(_clearTiles, 0, _clearTilesPerRow * _height);
+	_clearTilesPending = 0;
+
+	for (unsigned int y = 0; y < _height; y++)
+		ClearPixels((INT*)((BYTE*)_bitmapData.Scan0 + (y * _bitmapData.Stride)), _width, _clearColor);
+	FinishClearStores();
+}
+
+// Fills a run of pixels with a colour. Long runs use non-temporal stores, which write
+// straight to memory rather than pulling the whole frame through the cache.
+void Rasterizer::ClearPixels(INT* pixels, int count, ARGB color)
+{
+	int i = 0;
+
+#ifdef CLEAR_STREAM_ON
+	if (count >= CLEAR_STREAM_MIN_PIXELS)
+	{
+		// Store single pixels until the run is 16 byte aligned, then 4 pixels at a time.
+		while (i < count && ((size_t)(pixels + i) & 15) != 0)
+			pixels[i++] = color;
+
+		__m128i wide = _mm_set1_epi32((int)color);
+		for (; i + 4 <= count; i += 4)
+			_mm_stream_si128((__m128i*)(pixels + i), wide);
+	}
+#endif
+
+	for (; i < count; i++)
+		pixels[i] = color;
+
+	_clearBytesWritten += count * sizeof(INT);
+	_stats.pixelsWritten += count;
+}
+
+// Fills the pending tiles a span is about to be drawn over. Only the pixels of the tiles
+// outside the span are filled, the span writes the rest.
+void Rasterizer::ResolveClearSpan(int y, int xStart, int xEnd)
+{
+	if (_clearTilesPending == 0)
+		return;
+
+	BYTE* tiles = _clearTiles + (y * _clearTilesPerRow);
+	INT* pixelRow = (INT*)((BYTE*)_bitmapData.Scan0 + (y * _bitmapData.Stride));
+	int lastTile = xEnd / CLEAR_TILE_WIDTH;
+
+	for (int tile = xStart / CLEAR_TILE_WIDTH; tile <= lastTile; tile++)
+	{
+		if (tiles[tile] == 0)
+			continue;
+		tiles[tile] = 0;
+		_clearTilesPending--;
+
+		int tileStart = tile * CLEAR_TILE_WIDTH;
+		int tileEnd = min(tileStart + CLEAR_TILE_WIDTH, (int)_width) - 1;
+		if (xStart > tileStart)
+			ClearPixels(pixelRow + tileStart, xStart - tileStart, _clearColor);
+		if (xEnd < tileEnd)
+			ClearPixels(pixelRow + xEnd + 1, tileEnd - xEnd, _clearColor);
+	}
+}
+
+// Fills every tile still waiting to be cleared, neighbouring tiles are filled as one run.
+void Rasterizer::ResolveClearTiles()
+{
+	if (_clearTilesPending == 0)
+		return;
+
+	for (unsigned int y = 0; y < _height; y++)
+	{
+		BYTE* tiles = _clearTiles + (y * _clearTilesPerRow);
+		INT* pixelRow = (INT*)((BYTE*)_bitmapData.Scan0 + (y * _bitmapData.Stride));
+
+		int tile = 0;
+		while (tile < _clearTilesPerRow)
+		{
+			if (tiles[tile] == 0)
+			{
+				tile++;
+				continue;
+			}
+
+			int firstTile = tile;
+			while (tile < _clearTilesPerRow && tiles[tile] != 0)
+				tiles[tile++] = 0;
+
+			int start = firstTile * CLEAR_TILE_WIDTH;
+			int end = min(tile * CLEAR_TILE_WIDTH, (int)_width);
+			ClearPixels(pixelRow + start, end - start, _clearColor);
+		}
+	}
+
+	_clearTilesPending = 0;
+	FinishClearStores();
+}
+
+// Counts a span drawn while a debug view is on. Each pixel of the span has been written
+// once more, and the time the span took to shade is shared between the tiles it crosses
+// by the number of its pixels in each.
+void Rasterizer::CountDebugSpan(int y, int xStart, int xEnd, long long nanoseconds)
+{
+	unsigned short* overdraw = _overdraw + (y * _width);
+	for (int x = xStart; x <= xEnd; x++)
+	{
+		if (overdraw[x] < USHRT_MAX)
+			overdraw[x]++;
+	}
+
+	long long* tiles = _tileCosts + ((y / DEBUG_TILE_SIZE) * _debugTilesPerRow);
+	int pixels = xEnd - xStart + 1;
+	int lastTile = xEnd / DEBUG_TILE_SIZE;
+	for (int tile = xStart / DEBUG_TILE_SIZE; tile <= lastTile; tile++)
+	{
+		int start = max(xStart, tile * DEBUG_TILE_SIZE);
+		int end = min(xEnd, ((tile + 1) * DEBUG_TILE_SIZE) - 1);
+		tiles[tile] += (nanoseconds * (end - start + 1)) / pixels;
 	}
 }
 
@@ -107,6 +391,9 @@ void Rasterizer::FinishLockBits()
 	if (_bitsLocked == false)
 		return;
 
+	// Anything drawn or shown from here on needs the whole clear.
+	ResolveClearTiles();
+
 	// Unlock the bitmaps data.
 	_bitmap->UnlockBits(&_bitmapData);
 
@@ -116,6 +403,8 @@ void Rasterizer::FinishLockBits()
 // Writes a pixel colour to the screen via the lockbits method.
 void Rasterizer::WritePixel(int x, int y, Color color)
 {
+	ResolveClearSpan(y, x, x);
+
 	INT* pixelPtr = ((INT*)(_bitmapData.Scan0));
 	int offset = (y * _bitmapData.Stride / 4 + x);
 	INT* pixelOffsetInt = pixelPtr + offset;
@@ -126,658 +415,892 @@ void Rasterizer::WritePixel(int x, int y, Color color)
 // Draws a line from one point to another.
 void Rasterizer::DrawLine(float x1, float y1, float x2, float y2)
 {
-	Gdiplus::Pen* pen = new Gdiplus::Pen(Color(255, 255, 255, 255));
+	Gdiplus::Pen pen(Color(255, 255, 255, 255));
 	FinishLockBits();
-	_graphics->DrawLine(pen, x1, y1, x2, y2);
+	_graphics->DrawLine(&pen, x1, y1, x2, y2);
 	BeginLockBits();
-	delete pen;
 }
 
 // Draws a triangle given 3 points and a color.
 void Rasterizer::DrawTriangle(float x1, float y1, float x2, float y2, float x3, float y3, Gdiplus::Color color)
 {
-	Gdiplus::Brush* brush = new Gdiplus::SolidBrush(color);
+	Gdiplus::SolidBrush brush(color);
 	Gdiplus::PointF points[3];
 	
 	points[0] = Gdiplus::PointF(x1, y1);
 	points[1] = Gdiplus::PointF(x2, y2);
 	points[2] = Gdiplus::PointF(x3, y3);
 	FinishLockBits();
-	_graphics->FillPolygon(brush, points, 3);
+	_graphics->FillPolygon(&brush, points, 3);
 	BeginLockBits();
 
-	_polygonsRendered++;
-	
-	delete brush;
+	_stats.trianglesRasterized++;
 }
 
-// Fills a polygon given 3 points and a color.
-void Rasterizer::FillPolygon(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color)
+// Maps each display mode to the span kernels used to draw it. The colormap and normal map
+// columns replace the standard kernel when the model has them turned on.
+struct DisplayModeKernels
 {
-	ScanLine* _scanlines = new ScanLine[_height];
-
-	// Set the scanlines to very high and very low values so
-	// they will be set on the first set of interpolation.
-	for (unsigned int i = 0; i < _height; i++)
-	{
-		_scanlines[i].xStart = 99999;
-		_scanlines[i].xEnd = -99999;
-	}
+	SpanKernel standard;
+	SpanKernel colormap;
+	SpanKernel normalMapped;
+};
+static const DisplayModeKernels DisplayModeKernelTable[DISPLAY_MODE_COUNT] =
+{
+	{ SpanKernelNone,		SpanKernelNone,				SpanKernelNone },							// WireFrame
+	{ SpanKernelFlat,		SpanKernelNone,				SpanKernelNone },							// FlatShadedUnlit
+	{ SpanKernelFlat,		SpanKernelNone,				SpanKernelNone },							// FlatShadedAmbient
+	{ SpanKernelFlat,		SpanKernelNone,				SpanKernelNone },							// FlatShadedDirectionalAmbient
+	{ SpanKernelFlat,		SpanKernelNone,				SpanKernelNone },							// FlatShadedDirectionalPointAmient
+	{ SpanKernelGouraud,	SpanKernelNone,				SpanKernelNone },							// GouraudShadedUnlit
+	{ SpanKernelGouraud,	SpanKernelNone,				SpanKernelNone },							// GouraudShadedAmbient
+	{ SpanKernelGouraud,	SpanKernelNone,				SpanKernelNone },							// GouraudShadedDirectionalAmbient
+	{ SpanKernelGouraud,	SpanKernelNone,				SpanKernelNone },							// GouraudShadedDirectionalPointAmient
+	{ SpanKernelTextured,	SpanKernelTexturedColormap,	SpanKernelNone },							// TexturedUnlit
+	{ SpanKernelTextured,	SpanKernelTexturedColormap,	SpanKernelNone },							// TexturedAmbient
+	{ SpanKernelTextured,	SpanKernelTexturedColormap,	SpanKernelNone },							// TexturedDirectionalAmbient
+	{ SpanKernelTextured,	SpanKernelTexturedColormap,	SpanKernelNormalMappedDirectional },		// TexturedNormalMappedDirectionalAmbient
+	{ SpanKernelTextured,	SpanKernelTexturedColormap,	SpanKernelNone },							// TexturedDirectionalPointAmbient
+	{ SpanKernelTextured,	SpanKernelTexturedColormap,	SpanKernelNormalMappedDirectionalPoint }	// TexturedNormalMappedDirectionalPointAmbient
+};
+
+// Features each span kernel is built with.
+enum SpanKernelFeatures
+{
+	FlatFeatures							= KernelFlat,
+	GouraudFeatures							= KernelGouraud,
+	TexturedFeatures						= KernelGouraud | KernelTextured | KernelPerspective,
+	TexturedAffineFeatures					= KernelGouraud | KernelTextured,
+	TexturedColormapFeatures				= KernelGouraud | KernelTextured | KernelPerspective | KernelColormap,
+	NormalMappedDirectionalFeatures			= KernelGouraud | KernelTextured | KernelPerspective | KernelNormalMapped | KernelDirectionalLights,
+	NormalMappedDirectionalPointFeatures	= KernelGouraud | KernelTextured | KernelPerspective | KernelNormalMapped | KernelDirectionalLights | KernelPointLights
+};
+
+// Instantiates each of the span kernels, indexed by SpanKernel.
+const Rasterizer::SpanKernelFunction Rasterizer::_spanKernels[SPAN_KERNEL_COUNT] =
+{
+	&Rasterizer::FillPolygonKernel<FlatFeatures>,
+	&Rasterizer::FillPolygonKernel<GouraudFeatures>,
+	&Rasterizer::FillPolygonKernel<TexturedFeatures>,
+	&Rasterizer::FillPolygonKernel<TexturedAffineFeatures>,
+	&Rasterizer::FillPolygonKernel<TexturedColormapFeatures>,
+	&Rasterizer::FillPolygonKernel<NormalMappedDirectionalFeatures>,
+	&Rasterizer::FillPolygonKernel<NormalMappedDirectionalPointFeatures>
+};
+
+#if DEBUG_VIEWS_ON
+// Instantiates each of the span kernels again with the debug view counters, indexed by SpanKernel.
+const Rasterizer::SpanKernelFunction Rasterizer::_debugSpanKernels[SPAN_KERNEL_COUNT] =
+{
+	&Rasterizer::FillPolygonKernel<FlatFeatures | KernelDebugCounters>,
+	&Rasterizer::FillPolygonKernel<GouraudFeatures | KernelDebugCounters>,
+	&Rasterizer::FillPolygonKernel<TexturedFeatures | KernelDebugCounters>,
+	&Rasterizer::FillPolygonKernel<TexturedAffineFeatures | KernelDebugCounters>,
+	&Rasterizer::FillPolygonKernel<TexturedColormapFeatures | KernelDebugCounters>,
+	&Rasterizer::FillPolygonKernel<NormalMappedDirectionalFeatures | KernelDebugCounters>,
+	&Rasterizer::FillPolygonKernel<NormalMappedDirectionalPointFeatures | KernelDebugCounters>
+};
+#endif
+
+// Instantiates the scanline setup of each of the span kernels, indexed by SpanKernel.
+const Rasterizer::SetupKernelFunction Rasterizer::_setupKernels[SPAN_KERNEL_COUNT] =
+{
+	&Rasterizer::SetupPolygonKernel<FlatFeatures>,
+	&Rasterizer::SetupPolygonKernel<GouraudFeatures>,
+	&Rasterizer::SetupPolygonKernel<TexturedFeatures>,
+	&Rasterizer::SetupPolygonKernel<TexturedAffineFeatures>,
+	&Rasterizer::SetupPolygonKernel<TexturedColormapFeatures>,
+	&Rasterizer::SetupPolygonKernel<NormalMappedDirectionalFeatures>,
+	&Rasterizer::SetupPolygonKernel<NormalMappedDirectionalPointFeatures>
+};
+
+// Builds the varyings descriptor of a span kernel from its features.
+template <int Features>
+static VaryingsDescriptor MakeVaryingsDescriptor()
+{
+	typedef KernelVaryings<Features> Varyings;
+
+	VaryingsDescriptor descriptor;
+	descriptor.attributes = Varyings::Attributes;
+	descriptor.count = Varyings::Count;
+	descriptor.colorOffset = (Varyings::Attributes & VaryingColor) ? Varyings::ColorOffset : -1;
+	descriptor.uvOffset = (Varyings::Attributes & VaryingUV) ? Varyings::UVOffset : -1;
+	descriptor.inverseZOffset = (Varyings::Attributes & VaryingInverseZ) ? Varyings::InverseZOffset : -1;
+	descriptor.normalOffset = (Varyings::Attributes & VaryingNormal) ? Varyings::NormalOffset : -1;
+	descriptor.positionOffset = (Varyings::Attributes & VaryingPosition) ? Varyings::PositionOffset : -1;
+	return descriptor;
+}
 
-	// Interpolates between each of the vertexs of the polygon and sets the start
-	// and end values for each of the scanlines it comes in contact with.
-	InterpolateScanline(_scanlines, v1, v2);
-	InterpolateScanline(_scanlines, v2, v3);
-	InterpolateScanline(_scanlines, v3, v1);
-	
-	// Go through each scanline and each pixel in the scanline and 
-	// sets its color.
-	for (unsigned int y = 0; y < _height; y++)
-	{
-		for (int x = (int)_scanlines[y].xStart; x <= (int)_scanlines[y].xEnd; x++)
-		{
-			if (x < 0 || x >= (int)_width)
-				continue;
+// Varyings of each span kernel, indexed by SpanKernel.
+static const VaryingsDescriptor SpanKernelVaryings[SPAN_KERNEL_COUNT] =
+{
+	MakeVaryingsDescriptor<FlatFeatures>(),
+	MakeVaryingsDescriptor<GouraudFeatures>(),
+	MakeVaryingsDescriptor<TexturedFeatures>(),
+	MakeVaryingsDescriptor<TexturedAffineFeatures>(),
+	MakeVaryingsDescriptor<TexturedColormapFeatures>(),
+	MakeVaryingsDescriptor<NormalMappedDirectionalFeatures>(),
+	MakeVaryingsDescriptor<NormalMappedDirectionalPointFeatures>()
+};
+
+// Names of each span kernel, indexed by SpanKernel.
+static const char* SpanKernelNames[SPAN_KERNEL_COUNT] =
+{
+	"Flat",
+	"Gouraud",
+	"Textured",
+	"TexturedAffine",
+	"TexturedColormap",
+	"NormalMappedDirectional",
+	"NormalMappedDirectionalPoint"
+};
+
+// Works out which span kernel to use to draw a model in the given display mode.
+SpanKernel Rasterizer::GetSpanKernel(DisplayMode mode, bool colormapOn, bool normalMapOn)
+{
+	const DisplayModeKernels& kernels = DisplayModeKernelTable[mode];
 
-			WritePixel(x, y, color);
-			//_bitmap->SetPixel(x, y, color);
-		}
-	}
+	if (normalMapOn == true && kernels.normalMapped != SpanKernelNone)
+		return kernels.normalMapped;
+	if (colormapOn == true && kernels.colormap != SpanKernelNone)
+		return kernels.colormap;
 
-	// Dispose of dynamic objects.
-	delete[] _scanlines;
+	return kernels.standard;
+}
 
-	_polygonsRendered++;
+// Returns the name of the given span kernel.
+const char* Rasterizer::GetSpanKernelName(SpanKernel kernel)
+{
+	if (kernel < 0 || kernel >= SPAN_KERNEL_COUNT)
+		return "None";
+	return SpanKernelNames[kernel];
 }
 
-// Fills a polygon using gouraud shading given 3 points and a color.
-void Rasterizer::FillPolygonShaded(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color)
+// Returns the function that fills polygons with the given span kernel, the counting one
+// while a debug view is on.
+Rasterizer::SpanKernelFunction Rasterizer::GetSpanKernelFunction(SpanKernel kernel)
 {
-	ScanLine* _scanlines = new ScanLine[_height];
-	
-	// Set the scanlines to very high and very low values so
-	// they will be set on the first set of interpolation.
-	for (unsigned int i = 0; i < _height; i++)
-	{
-		_scanlines[i].xStart = 99999;
-		_scanlines[i].xEnd = -99999;
-	}
-	
-	// Interpolates between each of the vertexs of the polygon and sets the start
-	// and end values for each of the scanlines it comes in contact with.
-	InterpolateScanline(_scanlines, v1, v2);
-	InterpolateScanline(_scanlines, v2, v3);
-	InterpolateScanline(_scanlines, v3, v1);
+#if DEBUG_VIEWS_ON
+	if (_debugView != DebugViewNone)
+		return _debugSpanKernels[kernel];
+#endif
+	return _spanKernels[kernel];
+}
 
-	// Go through each scanline and each pixel in the scanline and 
-	// sets its color.
-	for (unsigned int y = 0; y < _height; y++)
+// Returns the varyings the given span kernel interpolates.
+VaryingsDescriptor Rasterizer::GetVaryingsDescriptor(SpanKernel kernel)
+{
+	if (kernel < 0 || kernel >= SPAN_KERNEL_COUNT)
 	{
-		// Work out the differences between the start an end colors of the current scanline.
-		float redColorDiff = (_scanlines[y].redEnd - _scanlines[y].redStart);
-		float greenColorDiff = (_scanlines[y].greenEnd - _scanlines[y].greenStart);
-		float blueColorDiff = (_scanlines[y].blueEnd - _scanlines[y].blueStart);
-		float diff = (_scanlines[y].xEnd - _scanlines[y].xStart) + 1;
-
-		for (int x = (int)_scanlines[y].xStart; x <= (int)_scanlines[y].xEnd; x++)
-		{
-			if (x < 0 || x >= (int)_width)
-				continue;
-
-			int offset = (int)(x - _scanlines[y].xStart);
-
-			// Use simple interpolation to work out the current color value of this pixel.
-			Gdiplus::Color pixelColor = Color
-				(
-					(BYTE)(_scanlines[y].redStart + ((redColorDiff / diff) * offset)),
-					(BYTE)(_scanlines[y].greenStart + ((greenColorDiff / diff) * offset)),
-					(BYTE)(_scanlines[y].blueStart + ((blueColorDiff / diff) * offset))	
-				);
-
-			// Set the value of the current pixel.
-			WritePixel(x, y, pixelColor);
-		}
+		VaryingsDescriptor descriptor = { VaryingNone, 0, -1, -1, -1, -1, -1 };
+		return descriptor;
 	}
-	
-	// Dispose of dynamic objects.
-	delete[] _scanlines;
+	return SpanKernelVaryings[kernel];
+}
 
-	_polygonsRendered++;
+// Sets the lights used by the normal mapped kernels. There is room made for the direction
+// of every directional light, so enabling more of them later allocates nothing.
+void Rasterizer::SetLights(const std::vector<DirectionalLight*>& directionalLights, const std::vector<AmbientLight*>& ambientLights, const std::vector<PointLight*>& pointLights)
+{
+	_directionalLights = directionalLights;
+	_ambientLights = ambientLights;
+	_pointLights = pointLights;
 }
 
-// Fills a polygon using a texture and gouraud shading given 3 points and a color.
-void Rasterizer::FillPolygonTextured(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color, Model3D& model)
+// Fetches the texture, colormap and light values of the model ready for the span kernels.
+void Rasterizer::SetKernelState(Model3D& model)
 {
-	ScanLine* _scanlines = new ScanLine[_height];
+	int normalTextureWidth;
+	int lightLevels;
 
-	BYTE* texture;
-	Gdiplus::Color* palette;
-	int textureWidth;
+	model.GetTexture(&_kernelState.texture, &_kernelState.palette, &_kernelState.textureWidth);
+	model.GetNormalMapTexture(&_kernelState.normalTexture, &_kernelState.normalPalette, &normalTextureWidth);
+	model.GetColormap(&_kernelState.colormap, &_kernelState.redColormap, &_kernelState.greenColormap, &_kernelState.blueColormap, &lightLevels);
 
-	// Get the texture properties of the model.
-	model.GetTexture(&texture, &palette, &textureWidth); 
-	
-	// Set the scanlines to very high and very low values so
-	// they will be set on the first set of interpolation.
-	for (unsigned int i = 0; i < _height; i++)
+	// Scale used to convert a light value (0-255) to a light level in the colormap, and the
+	// highest level, brighter lights are clamped to it.
+	_kernelState.colormapLevelScale = (lightLevels - 1) / 255.0f;
+	_kernelState.colormapMaxLevel = lightLevels - 1;
+
+	// Store the positions of the enabled lights.
+	_kernelState.directionalLightCount = 0;
+	for (unsigned int j = 0; j < _directionalLights.size() && _kernelState.directionalLightCount < MAX_KERNEL_LIGHTS; j++)
 	{
-		_scanlines[i].xStart = 99999;
-		_scanlines[i].xEnd = -99999;
-	}
+		DirectionalLight* light = _directionalLights[j];
+		if (light->GetEnabled() == false)
+			continue;
 
-	// Interpolates between each of the vertexs of the polygon and sets the start
-	// and end values for each of the scanlines it comes in contact with.
-	InterpolateScanline(_scanlines, v1, v2);
-	InterpolateScanline(_scanlines, v2, v3);
-	InterpolateScanline(_scanlines, v3, v1);
+		Vertex position = light->GetPosition();
+		_kernelState.directionalLightPositions[_kernelState.directionalLightCount++] = Vector3D(position.GetX(), position.GetY(), position.GetZ());
+	}
 
-	// Go through each scanline and each pixel in the scanline and 
-	// sets its color.
-	for (unsigned int y = 0; y < _height; y++)
+	_kernelState.pointLightCount = 0;
+	for (unsigned int j = 0; j < _pointLights.size() && _kernelState.pointLightCount < MAX_KERNEL_LIGHTS; j++)
 	{
-		// Work out the color and UV differences between the start and end of the scanline.
-		float redColorDiff = (_scanlines[y].redEnd - _scanlines[y].redStart);
-		float greenColorDiff = (_scanlines[y].greenEnd - _scanlines[y].greenStart);
-		float blueColorDiff = (_scanlines[y].blueEnd - _scanlines[y].blueStart);
-		float uCoordDiff = _scanlines[y].uEnd - _scanlines[y].uStart;
-		float vCoordDiff = _scanlines[y].vEnd - _scanlines[y].vStart;
-		float zCoordDiff = _scanlines[y].zEnd - _scanlines[y].zStart;
-		float diff = (_scanlines[y].xEnd - _scanlines[y].xStart) + 1;
+		PointLight* light = _pointLights[j];
+		if (light->GetEnabled() == false)
+			continue;
 
-		for (int x = (int)_scanlines[y].xStart; x <= (int)_scanlines[y].xEnd; x++)
-		{
-			if (x < 0 || x >= (int)_width)
-				continue;
+		Vertex position = light->GetPosition();
+		_kernelState.pointLightPositions[_kernelState.pointLightCount++] = Vector3D(position.GetX(), position.GetY(), position.GetZ());
+	}
+}
 
-			int offset = (int)(x - _scanlines[y].xStart);
-			
-			// Work out the UV coordinate of the current pixel.
-			float uCoord = _scanlines[y].uStart + ((uCoordDiff / diff) * offset);
-			float vCoord = _scanlines[y].vStart + ((vCoordDiff / diff) * offset);
-			float zCoord = _scanlines[y].zStart + ((zCoordDiff / diff) * offset);
+// Fills a polygon with the given span kernel. This sets up the kernel state for the model
+// on every call, DrawModel should be used to draw whole models.
+void Rasterizer::FillPolygon(SpanKernel kernel, Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color, Model3D& model)
+{
+	if (kernel < 0 || kernel >= SPAN_KERNEL_COUNT)
+		return;
 
-			uCoord /= zCoord;
-			vCoord /= zCoord;
+	SetKernelState(model);
+	(this->*GetSpanKernelFunction(kernel))(v1, v2, v3, color);
+}
 
-			// Work out the lighting colour of the current pixel.
-			float lightR = (_scanlines[y].redStart + ((redColorDiff / diff) * offset)) / 180.0f;
-			float lightG = (_scanlines[y].greenStart + ((greenColorDiff / diff) * offset)) / 180.0f;
-			float lightB = (_scanlines[y].blueStart + ((blueColorDiff / diff) * offset)) / 180.0f;	
+// Sets up the scanlines of a polygon for the given span kernel, without filling them.
+// Used to time polygon setup on its own.
+void Rasterizer::SetupPolygon(SpanKernel kernel, Vertex v1, Vertex v2, Vertex v3)
+{
+	if (kernel < 0 || kernel >= SPAN_KERNEL_COUNT)
+		return;
 
-			// Using the UV coordinate work out which pixel in the texture to use to draw this pixel.
-			int pixelIndex = (int)vCoord * textureWidth + (int)uCoord;
-			if (pixelIndex >= textureWidth * textureWidth || pixelIndex < 0)
-			{
-				pixelIndex = (textureWidth * textureWidth) - 1;
-			}
+	(this->*_setupKernels[kernel])(v1, v2, v3);
+}
 
-			int paletteOffset = texture[pixelIndex]; 
-			if (paletteOffset >= 255)
-				paletteOffset = 255;
+// Snaps a screen position to the 28.4 fixed point sub-pixel grid.
+static inline int ToSubPixel(float value)
+{
+	// Clamp positions that are too far away (or not a number) to be represented.
+	if (!(value > -SUBPIXEL_LIMIT))
+		value = -SUBPIXEL_LIMIT;
+	else if (!(value < SUBPIXEL_LIMIT))
+		value = SUBPIXEL_LIMIT;
 
-			Gdiplus::Color textureColor = palette[paletteOffset];
+	return (int)floor((value * SUBPIXEL_STEPS) + 0.5f);
+}
 
-			// Apply the lighting value to the texture colour and use the result to set the colour of the current pixel.
-			int finalR = (int)max(0, min(255, textureColor.GetR() * lightR));
-			int finalG = (int)max(0, min(255, textureColor.GetG() * lightG));
-			int finalB = (int)max(0, min(255, textureColor.GetB() * lightB));
+// Returns the first pixel whose centre is at or after the given fixed point position. A 
+// pixel is only covered if its centre lies on or after the left (or top) edge of a polygon 
+// and before the right (or bottom) edge, so pixels on a shared edge are only filled once.
+static inline int FirstPixelCentre(int value, int fractionBits)
+{
+	return (value - (1 << (fractionBits - 1)) + (1 << fractionBits) - 1) >> fractionBits;
+}
 
-			WritePixel(x, y, Gdiplus::Color(finalR, finalG, finalB));
-		}
-	}
-	
-	// Dispose of dynamic objects.
-	delete[] _scanlines;
+// Converts a light value to the nearest level of the colormap, clamped to the levels it has.
+static inline int ToColormapLevel(float light, const KernelState& state)
+{
+	int level = (int)((light * state.colormapLevelScale) + 0.5f);
+	return max(0, min(state.colormapMaxLevel, level));
+}
 
-	_polygonsRendered++;
+// Divides rounding towards negative infinity, returning the remainder (always positive).
+static inline long long FloorDivide(long long numerator, long long denominator, long long& remainder)
+{
+	long long quotient = numerator / denominator;
+	remainder = numerator % denominator;
+	if (remainder < 0)
+	{
+		quotient--;
+		remainder += denominator;
+	}
+	return quotient;
 }
 
-// Fills a polygon using a texture, gouraud shading and a normal map given 3 points and a color.
-void Rasterizer::FillPolygonTexturedNormalMapped(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color, Model3D& model, std::vector<DirectionalLight*> directionalLights, std::vector<AmbientLight*> ambientLights, std::vector<PointLight*> pointLights)
+// Resets the scanlines covered by the polygon so they will be set on the first 
+// set of interpolation. Returns false if the polygon covers no scanlines on screen.
+bool Rasterizer::BeginScanlines(Vertex& v1, Vertex& v2, Vertex& v3, int& yStart, int& yEnd)
 {
-	ScanLine* _scanlines = new ScanLine[_height];
+	int y1 = ToSubPixel(v1.GetY());
+	int y2 = ToSubPixel(v2.GetY());
+	int y3 = ToSubPixel(v3.GetY());
+	int minY = min(y1, min(y2, y3));
+	int maxY = max(y1, max(y2, y3));
+
+	// Only the scanlines whose centres are covered by the polygon need resetting.
+	yStart = max(0, FirstPixelCentre(minY, SUBPIXEL_BITS));
+	yEnd = min((int)_height - 1, FirstPixelCentre(maxY, SUBPIXEL_BITS) - 1);
+	if (yStart > yEnd)
+		return false;
+
+	for (int i = yStart; i <= yEnd; i++)
+	{
+		_edgeXStart[i] = INT_MAX;
+		_edgeXEnd[i] = INT_MIN;
+	}
+	_setupBytesWritten += (yEnd - yStart + 1) * 2 * sizeof(int);
 
-	BYTE* texture;
-	Gdiplus::Color* palette;
-	BYTE* normalTexture;
-	Gdiplus::Color* normalPalette;
-	int textureWidth;
+	return true;
+}
 
-	// Get the texture properties of the model.
-	model.GetTexture(&texture, &palette, &textureWidth); 
-	model.GetNormalMapTexture(&normalTexture, &normalPalette, &textureWidth); 
-	
-	// Set the scanlines to very high and very low values so
-	// they will be set on the first set of interpolation.
-	for (unsigned int i = 0; i < _height; i++)
+// Fills a polygon given 3 points and a color. This is the single rasterization core,
+// Features is a combination of KernelFeatures that decides at compile time which values
+// are interpolated and how each pixel is shaded.
+template <int Features>
+void Rasterizer::FillPolygonKernel(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color)
+{
+	const bool gouraud = (Features & KernelGouraud) != 0;
+	const bool textured = (Features & KernelTextured) != 0;
+	const bool perspective = (Features & KernelPerspective) != 0;
+	const bool normalMapped = (Features & KernelNormalMapped) != 0;
+	const bool colormapped = (Features & KernelColormap) != 0;
+	const bool debugCounters = (Features & KernelDebugCounters) != 0;
+
+	// Offsets of each of the kernels varyings.
+	typedef KernelVaryings<Features> Varyings;
+	const int R = Varyings::ColorOffset, G = R + 1, B = R + 2;
+	const int U = Varyings::UVOffset, V = U + 1;
+	const int Z = Varyings::InverseZOffset;
+	const int NX = Varyings::NormalOffset, NY = NX + 1, NZ = NX + 2;
+	const int PX = Varyings::PositionOffset, PY = PX + 1, PZ = PX + 2;
+
+	int yStart, yEnd;
 	{
-		_scanlines[i].xStart = 99999;
-		_scanlines[i].xEnd = -99999;
+		PROFILE_SCOPE(ProfileStageSetup);
+		if (SetupScanlines<Features>(v1, v2, v3, yStart, yEnd) == false)
+		{
+			_stats.trianglesZeroArea++;
+			return;
+		}
+	}
+	_stats.trianglesRasterized++;
+
+	PROFILE_SCOPE(ProfileStageSpans);
+	const KernelState& state = _kernelState;
+	int textureSize = state.textureWidth * state.textureWidth;
+	ARGB flatColor = color.GetValue();
+
+	// Texels read and lights worked out for each pixel, the colormap is looked up in
+	// place of the normal map.
+	const int texelsPerPixel = textured ? ((normalMapped && !colormapped) ? 2 : 1) : 0;
+	int lightsPerPixel = 0;
+	if (normalMapped && !colormapped)
+	{
+		if (Features & KernelPointLights)
+			lightsPerPixel += state.pointLightCount;
+		if (Features & KernelDirectionalLights)
+			lightsPerPixel += state.directionalLightCount;
 	}
-
-	// Interpolates between each of the vertexs of the polygon and sets the start
-	// and end values for each of the scanlines it comes in contact with.
-	InterpolateScanline(_scanlines, v1, v2);
-	InterpolateScanline(_scanlines, v2, v3);
-	InterpolateScanline(_scanlines, v3, v1);
 
 	// Go through each scanline and each pixel in the scanline and 
 	// sets its color.
-	for (unsigned int y = 0; y < _height; y++)
+	for (int y = yStart; y <= yEnd; y++)
 	{
-		// Work out the color and UV differences between the start and end of the scanline.
-		float redColorDiff = (_scanlines[y].redEnd - _scanlines[y].redStart);
-		float greenColorDiff = (_scanlines[y].greenEnd - _scanlines[y].greenStart);
-		float blueColorDiff = (_scanlines[y].blueEnd - _scanlines[y].blueStart);
-		float uCoordDiff = _scanlines[y].uEnd - _scanlines[y].uStart;
-		float vCoordDiff = _scanlines[y].vEnd - _scanlines[y].vStart;
-		float zCoordDiff = _scanlines[y].zEnd - _scanlines[y].zStart;
+		int scanlineXStart = _edgeXStart[y];
+		int scanlineXEnd = _edgeXEnd[y];
 
-		float xNormalDiff = (_scanlines[y].xNormalEnd - _scanlines[y].xNormalStart);
-		float yNormalDiff = (_scanlines[y].yNormalEnd - _scanlines[y].yNormalStart);
-		float zNormalDiff = (_scanlines[y].zNormalEnd - _scanlines[y].zNormalStart);
+		// Work out the pixels whose centres lie between the edges, clipped to the screen.
+		int edgeStart = FirstPixelCentre(scanlineXStart, EDGE_FRACTION_BITS);
+		int edgeEnd = FirstPixelCentre(scanlineXEnd, EDGE_FRACTION_BITS) - 1;
+		if (edgeStart > edgeEnd)
+			continue;
+		_stats.pixelsTested += edgeEnd - edgeStart + 1;
 
-		float xDiff = (_scanlines[y].pixelXEnd - _scanlines[y].pixelXStart);
-		float yDiff = (_scanlines[y].pixelYEnd - _scanlines[y].pixelYStart);
-		float zDiff = (_scanlines[y].pixelZEnd - _scanlines[y].pixelZStart);
+		int xStart = max(0, edgeStart);
+		int xEnd = min((int)_width - 1, edgeEnd);
+		if (xStart > xEnd)
+			continue;
 
-		float diff = (_scanlines[y].xEnd - _scanlines[y].xStart) + 1;
+		ResolveClearSpan(y, xStart, xEnd);
+		long long spanStart = debugCounters ? Profiler::GetTime() : 0;
+		unsigned int spanPixels = xEnd - xStart + 1;
+		_stats.pixelsShaded += spanPixels;
+		_stats.pixelsWritten += spanPixels;
+		_stats.texelsFetched += spanPixels * texelsPerPixel;
+		_stats.lightsEvaluated += spanPixels * lightsPerPixel;
+		INT* pixelRow = (INT*)((BYTE*)_bitmapData.Scan0 + (y * _bitmapData.Stride));
+		float left = scanlineXStart / (float)(1 << EDGE_FRACTION_BITS);
+		float diff = (scanlineXEnd - scanlineXStart) / (float)(1 << EDGE_FRACTION_BITS);
+
+		// Work out how much each varying changes per pixel along the scanline, and
+		// step the start of each varying to the centre of the first pixel.
+		float start[MAX_VARYINGS];
+		float step[MAX_VARYINGS];
+		float prestep = (xStart + 0.5f) - left;
+		for (int i = 0; i < Varyings::Count; i++)
+		{
+			float startValue = _varyingsStart[(i * _height) + y];
+			step[i] = (_varyingsEnd[(i * _height) + y] - startValue) / diff;
+			start[i] = startValue + (step[i] * prestep);
+		}
 
-		for (int x = (int)_scanlines[y].xStart; x <= (int)_scanlines[y].xEnd; x++)
+		for (int x = xStart; x <= xEnd; x++)
 		{
-			if (x < 0 || x >= (int)_width)
+			int offset = x - xStart;
+
+			if (!textured)
+			{
+				if (gouraud)
+				{
+					// Use simple interpolation to work out the current color value of this pixel.
+					pixelRow[x] = Gdiplus::Color::MakeARGB(255,
+						(BYTE)(start[R] + (step[R] * offset)),
+						(BYTE)(start[G] + (step[G] * offset)),
+						(BYTE)(start[B] + (step[B] * offset)));
+				}
+				else
+					pixelRow[x] = flatColor;
 				continue;
+			}
 
-			int offset = (int)(x - _scanlines[y].xStart);
-			
 			// Work out the UV coordinate of the current pixel.
-			float uCoord = _scanlines[y].uStart + ((uCoordDiff / diff) * offset);
-			float vCoord = _scanlines[y].vStart + ((vCoordDiff / diff) * offset);
-			float zCoord = _scanlines[y].zStart + ((zCoordDiff / diff) * offset);
-
-			uCoord /= zCoord;
-			vCoord /= zCoord;
-
-			// Work out the normal of the pixel.
-			float xNormal = _scanlines[y].xNormalStart + ((xNormalDiff / diff) * offset);
-			float yNormal = _scanlines[y].yNormalStart + ((yNormalDiff / diff) * offset);
-			float zNormal = _scanlines[y].zNormalStart + ((zNormalDiff / diff) * offset);
-
-			// Work out the position of the pixel.
-			float pixelX = _scanlines[y].pixelXStart + ((xDiff / diff) * offset);
-			float pixelY = _scanlines[y].pixelYStart + ((yDiff / diff) * offset);
-			float pixelZ = _scanlines[y].pixelZStart + ((zDiff / diff) * offset);
-
-			// Work out the lighting colour of the current pixel.
-			//float lightR = (_scanlines[y].redStart + ((redColorDiff / diff) * offset)) / 180.0f;
-			//float lightG = (_scanlines[y].greenStart + ((greenColorDiff / diff) * offset)) / 180.0f;
-			//float lightB = (_scanlines[y].blueStart + ((blueColorDiff / diff) * offset)) / 180.0f;	
+			float uCoord = start[U] + (step[U] * offset);
+			float vCoord = start[V] + (step[V] * offset);
+			if (perspective)
+			{
+				float zCoord = start[Z] + (step[Z] * offset);
+				uCoord /= zCoord;
+				vCoord /= zCoord;
+			}
 
 			// Using the UV coordinate work out which pixel in the texture to use to draw this pixel.
-			int pixelIndex = (int)vCoord * textureWidth + (int)uCoord;
-			if (pixelIndex >= textureWidth * textureWidth || pixelIndex < 0)
+			int pixelIndex = (int)vCoord * state.textureWidth + (int)uCoord;
+			if (pixelIndex >= textureSize || pixelIndex < 0)
 			{
-				pixelIndex = (textureWidth * textureWidth) - 1;
+				pixelIndex = textureSize - 1;
 			}
+			int paletteOffset = state.texture[pixelIndex];
 
-			int paletteOffset = texture[pixelIndex]; 
-			if (paletteOffset >= 255)
-				paletteOffset = 255;
-
-			Gdiplus::Color textureColor = palette[paletteOffset];
+			// Work out the lighting colour of the current pixel.
+			float lightR = gouraud ? start[R] + (step[R] * offset) : color.GetR();
+			float lightG = gouraud ? start[G] + (step[G] * offset) : color.GetG();
+			float lightB = gouraud ? start[B] + (step[B] * offset) : color.GetB();
 
-			// Work out the pixel colour of the normalmap.
-			pixelIndex = (int)vCoord * textureWidth + (int)uCoord;
-			if (pixelIndex >= textureWidth * textureWidth || pixelIndex < 0)
+			if (colormapped)
 			{
-				pixelIndex = (textureWidth * textureWidth) - 1;
+				// Look up the lit texture colour in the colormap.
+				if (state.colormap != NULL)
+				{
+					int level = ToColormapLevel((lightR + lightG + lightB) / 3.0f, state);
+					pixelRow[x] = state.colormap[(level * 256) + paletteOffset];
+				}
+				else
+				{
+					pixelRow[x] = Gdiplus::Color::MakeARGB(255,
+						state.redColormap[(ToColormapLevel(lightR, state) * 256) + paletteOffset],
+						state.greenColormap[(ToColormapLevel(lightG, state) * 256) + paletteOffset],
+						state.blueColormap[(ToColormapLevel(lightB, state) * 256) + paletteOffset]);
+				}
+				continue;
 			}
 
-			paletteOffset = normalTexture[pixelIndex]; 
-			if (paletteOffset >= 255)
-				paletteOffset = 255;
-
-			Gdiplus::Color normalTextureColor = normalPalette[paletteOffset];
-
-			// Calculate normal lighting for the pixel.
-			Vector3D heightMapVector = Vector3D(normalTextureColor.GetR() / 180.0f, normalTextureColor.GetG() / 180.0f, normalTextureColor.GetB() / 180.0f); 
-			heightMapVector = Vector3D((heightMapVector.GetX() - 0.5f) * 2.0f, (heightMapVector.GetY() - 0.5f) * 2.0f, (heightMapVector.GetZ() - 0.5f) * 2.0f);
+			Gdiplus::Color textureColor = state.palette[paletteOffset];
+			lightR /= 180.0f;
+			lightG /= 180.0f;
+			lightB /= 180.0f;
 
-			// Work out he pixels normal and position.
-			Vector3D pixelNormal = Vector3D(xNormal, yNormal, zNormal);//;Vector3D(heightMapVector.GetX(), heightMapVector.GetY(), heightMapVector.GetZ());
-			Vertex pixelPosition = Vertex(pixelX, pixelY, pixelZ, 1, Gdiplus::Color::White, Vector3D(0, 0, 0), 0);
-
-			heightMapVector = Vector3D((pixelNormal.GetX() * heightMapVector.GetX()) , 
-										(pixelNormal.GetY() * heightMapVector.GetY()) , 
-										(pixelNormal.GetZ() * heightMapVector.GetZ()) );
-
-			// Calculate the sum dot product of all lighting vectors for this pixel and divide by the number
-			// of lights.
-			float lightDot = 0.0f;
-			int count = 0;
-			for (unsigned int j = 0; j < pointLights.size(); j++)
+			if (normalMapped)
 			{
-				PointLight* light = pointLights[j];
-				if (light->GetEnabled() == false)
-					continue;
-			
-				// Work out vector to light source.
-				Vector3D lightVector = Vertex::GetVector(pixelPosition, light->GetPosition());
-				float distance = lightVector.GetLength();
-				lightVector.Normalize();
-
-				// Work out dot product.
-				lightDot += Vector3D::DotProduct(heightMapVector, lightVector);
-				count++;
+				Gdiplus::Color normalTextureColor = state.normalPalette[state.normalTexture[pixelIndex]];
+
+				// Calculate normal lighting for the pixel.
+				float heightMapX = ((normalTextureColor.GetR() / 180.0f) - 0.5f) * 2.0f;
+				float heightMapY = ((normalTextureColor.GetG() / 180.0f) - 0.5f) * 2.0f;
+				float heightMapZ = ((normalTextureColor.GetB() / 180.0f) - 0.5f) * 2.0f;
+
+				// Work out he pixels normal and position.
+				Vector3D heightMapVector = Vector3D((start[NX] + (step[NX] * offset)) * heightMapX, 
+													(start[NY] + (step[NY] * offset)) * heightMapY, 
+													(start[NZ] + (step[NZ] * offset)) * heightMapZ);
+				float pixelX = start[PX] + (step[PX] * offset);
+				float pixelY = start[PY] + (step[PY] * offset);
+				float pixelZ = start[PZ] + (step[PZ] * offset);
+
+				// Calculate the sum dot product of all lighting vectors for this pixel and divide by the number
+				// of lights.
+				float lightDot = 0.0f;
+				int count = 0;
+				if (Features & KernelPointLights)
+				{
+					for (int j = 0; j < state.pointLightCount; j++)
+					{
+						const Vector3D& position = state.pointLightPositions[j];
+						Vector3D lightVector = Vector3D(position.GetX() - pixelX, position.GetY() - pixelY, position.GetZ() - pixelZ);
+						lightVector.Normalize();
+						lightDot += Vector3D::DotProduct(heightMapVector, lightVector);
+						count++;
+					}
+				}
+				if (Features & KernelDirectionalLights)
+				{
+					for (int j = 0; j < state.directionalLightCount; j++)
+					{
+						const Vector3D& position = state.directionalLightPositions[j];
+						Vector3D lightVector = Vector3D(position.GetX() - pixelX, position.GetY() - pixelY, position.GetZ() - pixelZ);
+						lightVector.Normalize();
+						lightDot += Vector3D::DotProduct(heightMapVector, lightVector);
+						count++;
+					}
+				}
+				if (count > 0)
+					lightDot /= count;
+
+				// Adjust the light colour based on the lighting dot product.
+				lightR -= lightR * lightDot;
+				lightG -= lightG * lightDot;
+				lightB -= lightB * lightDot;
 			}
-			for (unsigned int j = 0; j < directionalLights.size(); j++)
-			{
-				DirectionalLight* light = directionalLights[j];
-				if (light->GetEnabled() == false)
-					continue;
-			
-				// Work out vector to light source.
-				Vector3D lightVector = Vertex::GetVector(pixelPosition, light->GetPosition());
-				float distance = lightVector.GetLength();
-				lightVector.Normalize();
-
-				// Work out dot product.
-				lightDot += Vector3D::DotProduct(heightMapVector, lightVector);
-				count++;
-			}
-			lightDot /= count;
-
-			// Adjust texture colour based on the lighting dot product.
-			Gdiplus::Color pixelColor = textureColor;
-			//pixelColor = model.CalculateLightingAmbientPerPixel(ambientLights, pixelPosition, pixelNormal, pixelColor);
-			//pixelColor = model.CalculateLightingDirectionalPerPixel(directionalLights, pixelPosition, pixelNormal, pixelColor);
-			//pixelColor = model.CalculateLightingPointPerPixel(pointLights, pixelPosition, pixelNormal, pixelColor);
-
-			float lightR = (_scanlines[y].redStart + ((redColorDiff / diff) * offset)) / 180.0f;
-			float lightG = (_scanlines[y].greenStart + ((greenColorDiff / diff) * offset)) / 180.0f;
-			float lightB = (_scanlines[y].blueStart + ((blueColorDiff / diff) * offset)) / 180.0f;	
 
 			// Apply the lighting value to the texture colour and use the result to set the colour of the current pixel.
-			int finalR = (int)max(0, min(255, (lightR * textureColor.GetR()) - ((lightR * textureColor.GetR()) * lightDot) ));
-			int finalG = (int)max(0, min(255, (lightG * textureColor.GetG()) - ((lightG * textureColor.GetG()) * lightDot) ));
-			int finalB = (int)max(0, min(255, (lightB * textureColor.GetB()) - ((lightB * textureColor.GetB()) * lightDot) ));
+			int finalR = (int)max(0, min(255, textureColor.GetR() * lightR));
+			int finalG = (int)max(0, min(255, textureColor.GetG() * lightG));
+			int finalB = (int)max(0, min(255, textureColor.GetB() * lightB));
 
-			WritePixel(x, y, Gdiplus::Color(finalR, finalG, finalB));
+			pixelRow[x] = Gdiplus::Color::MakeARGB(255, (BYTE)finalR, (BYTE)finalG, (BYTE)finalB);
 		}
+
+		if (debugCounters)
+			CountDebugSpan(y, xStart, xEnd, Profiler::GetTime() - spanStart);
 	}
-	
-	// Dispose of dynamic objects.
-	delete[] _scanlines;
+}
+
+// Resets the scanlines covered by a polygon, then interpolates between each of its vertexs
+// and sets the start and end values for each of the scanlines it comes in contact with.
+// Returns false if the polygon covers no scanlines.
+template <int Features>
+bool Rasterizer::SetupScanlines(Vertex& v1, Vertex& v2, Vertex& v3, int& yStart, int& yEnd)
+{
+	if (BeginScanlines(v1, v2, v3, yStart, yEnd) == false)
+		return false;
+
+	InterpolateScanline<Features>(v1, v2);
+	InterpolateScanline<Features>(v2, v3);
+	InterpolateScanline<Features>(v3, v1);
+	return true;
+}
 
-	_polygonsRendered++;
+// Sets up the scanlines of a polygon for a span kernel without filling them.
+template <int Features>
+void Rasterizer::SetupPolygonKernel(Vertex v1, Vertex v2, Vertex v3)
+{
+	int yStart, yEnd;
+	SetupScanlines<Features>(v1, v2, v3, yStart, yEnd);
 }
 
 // Interpolates between the given vertexs and sets the start and end values of each
-// scanline it encounters on the way.
-void Rasterizer::InterpolateScanline(ScanLine* scanlines, Vertex v1, Vertex v2)
+// scanline it encounters on the way. Only the kernels varyings are interpolated.
+template <int Features>
+void Rasterizer::InterpolateScanline(Vertex v1, Vertex v2)
 {
-	// Swap the vertexs round if we need to, to make sure
-	// the first vertex is the one at the top of the screen.
-	if (v2.GetY() < v1.GetY())
+	typedef KernelVaryings<Features> Varyings;
+
+	// Snap both vertexs to the sub-pixel grid.
+	int x1 = ToSubPixel(v1.GetX());
+	int y1 = ToSubPixel(v1.GetY());
+	int x2 = ToSubPixel(v2.GetX());
+	int y2 = ToSubPixel(v2.GetY());
+
+	// Swap the vertexs round if we need to, to make sure the first vertex is the one
+	// at the top of the screen. Polygons sharing this edge then step it identically.
+	if (y2 < y1)
 	{
 		Vertex v3 = v2;
 		v2 = v1;
 		v1 = v3;
+		std::swap(x1, x2);
+		std::swap(y1, y2);
 	}
-	
-	// Work out the difference between each vertex and the number of steps
-	// we need to take to interpolate between each of the vertexs.
-	float yDiff = (v2.GetY() - v1.GetY());
-	float xDiff = (v2.GetX() - v1.GetX());
-	float zDiff = (v2.GetPreTransformZ() - v1.GetPreTransformZ());
-	float numOfPoints = v2.GetY() - v1.GetY();
-
-	// Work out the difference in colour between each vertex.
-	float redColorDiff = (float)(v2.GetColor().GetR() - v1.GetColor().GetR());
-	float greenColorDiff = (float)(v2.GetColor().GetG() - v1.GetColor().GetG());
-	float blueColorDiff = (float)(v2.GetColor().GetB() - v1.GetColor().GetB());
-
-	// WOrk out the difference between the normals.
-	float xNormalDiff = (float)(v2.GetNormal().GetX() - v1.GetNormal().GetX());
-	float yNormalDiff = (float)(v2.GetNormal().GetY() - v1.GetNormal().GetY());
-	float zNormalDiff = (float)(v2.GetNormal().GetZ() - v1.GetNormal().GetZ());
-	
-	// Work out the difference in uv coordinate between each vertex.
-	UVCoordinate uvCoord1 = v1.GetUVCoordinate();
-	UVCoordinate uvCoord2 = v2.GetUVCoordinate();
 
-	uvCoord1.U = uvCoord1.U / v1.GetPreTransformZ();
-	uvCoord1.V = uvCoord1.V / v1.GetPreTransformZ();
-	uvCoord1.Z = 1.0f / v1.GetPreTransformZ();
-	
-	uvCoord2.U = uvCoord2.U / v2.GetPreTransformZ();
-	uvCoord2.V = uvCoord2.V / v2.GetPreTransformZ();
-	uvCoord2.Z = 1.0f / v2.GetPreTransformZ();
+	// Horizontal edges do not cross any scanline centres.
+	int yDiff = y2 - y1;
+	int xDiff = x2 - x1;
+	if (yDiff == 0)
+		return;
 
-	float uCoordDiff = (uvCoord2.U - uvCoord1.U);
-	float vCoordDiff = (uvCoord2.V - uvCoord1.V);
-	float zCoordDiff = (uvCoord2.Z - uvCoord1.Z);
+	// Work out the scanlines whose centres lie between the top (inclusive) 
+	// and the bottom (exclusive) of the edge.
+	int yFirst = max(0, FirstPixelCentre(y1, SUBPIXEL_BITS));
+	int yLast = min((int)_height - 1, FirstPixelCentre(y2, SUBPIXEL_BITS) - 1);
+	if (yFirst > yLast)
+		return;
 
-	// Go through each point in the interpolation and work out the 
-	// colour and uv values for pixel along the way.
-	for (int i = 0; i < numOfPoints; i++)
+	// Work out the value of each varying at both vertexs.
+	float start[MAX_VARYINGS];
+	float end[MAX_VARYINGS];
+	if (Varyings::Attributes & VaryingColor)
 	{
-		unsigned int scanline = (int)(v1.GetY() + i);
-		if (scanline < 0 || scanline >= _height)
-			continue;
+		Gdiplus::Color color1 = v1.GetColor();
+		Gdiplus::Color color2 = v2.GetColor();
+		start[Varyings::ColorOffset + 0] = color1.GetR();
+		start[Varyings::ColorOffset + 1] = color1.GetG();
+		start[Varyings::ColorOffset + 2] = color1.GetB();
+		end[Varyings::ColorOffset + 0] = color2.GetR();
+		end[Varyings::ColorOffset + 1] = color2.GetG();
+		end[Varyings::ColorOffset + 2] = color2.GetB();
+	}
+	if (Varyings::Attributes & VaryingUV)
+	{
+		// Perspective correct kernels interpolate u/z, v/z and 1/z.
+		UVCoordinate uvCoord1 = v1.GetUVCoordinate();
+		UVCoordinate uvCoord2 = v2.GetUVCoordinate();
+		if (Varyings::Attributes & VaryingInverseZ)
+		{
+			uvCoord1.U = uvCoord1.U / v1.GetPreTransformZ();
+			uvCoord1.V = uvCoord1.V / v1.GetPreTransformZ();
+			uvCoord2.U = uvCoord2.U / v2.GetPreTransformZ();
+			uvCoord2.V = uvCoord2.V / v2.GetPreTransformZ();
+		}
+		start[Varyings::UVOffset + 0] = uvCoord1.U;
+		start[Varyings::UVOffset + 1] = uvCoord1.V;
+		end[Varyings::UVOffset + 0] = uvCoord2.U;
+		end[Varyings::UVOffset + 1] = uvCoord2.V;
+	}
+	if (Varyings::Attributes & VaryingInverseZ)
+	{
+		start[Varyings::InverseZOffset] = 1.0f / v1.GetPreTransformZ();
+		end[Varyings::InverseZOffset] = 1.0f / v2.GetPreTransformZ();
+	}
+	if (Varyings::Attributes & VaryingNormal)
+	{
+		Vector3D normal1 = v1.GetNormal();
+		Vector3D normal2 = v2.GetNormal();
+		start[Varyings::NormalOffset + 0] = normal1.GetX();
+		start[Varyings::NormalOffset + 1] = normal1.GetY();
+		start[Varyings::NormalOffset + 2] = normal1.GetZ();
+		end[Varyings::NormalOffset + 0] = normal2.GetX();
+		end[Varyings::NormalOffset + 1] = normal2.GetY();
+		end[Varyings::NormalOffset + 2] = normal2.GetZ();
+	}
+	if (Varyings::Attributes & VaryingPosition)
+	{
+		start[Varyings::PositionOffset + 0] = v1.GetX();
+		start[Varyings::PositionOffset + 1] = v1.GetY();
+		start[Varyings::PositionOffset + 2] = v1.GetPreTransformZ();
+		end[Varyings::PositionOffset + 0] = v2.GetX();
+		end[Varyings::PositionOffset + 1] = v2.GetY();
+		end[Varyings::PositionOffset + 2] = v2.GetPreTransformZ();
+	}
 
-		// Get the x axis value in our interpolation.
-		float x = v1.GetX() + i * (xDiff / yDiff);
-
-		// Work out the colour value of the current pixel.
-		float red	= v1.GetColor().GetR() + ((redColorDiff		/ numOfPoints) * i);
-		float green = v1.GetColor().GetG() + ((greenColorDiff	/ numOfPoints) * i);
-		float blue	= v1.GetColor().GetB() + ((blueColorDiff	/ numOfPoints) * i);
-		
-		// Work out the normal value of the current pixel.
-		float normalX = v1.GetNormal().GetX() + ((xNormalDiff	/ numOfPoints) * i);
-		float normalY = v1.GetNormal().GetY() + ((yNormalDiff	/ numOfPoints) * i);
-		float normalZ = v1.GetNormal().GetZ() + ((zNormalDiff	/ numOfPoints) * i);
-
-		// Work out the normal value of the current pixel.
-		float pixelX = v1.GetX() + ((xDiff	/ numOfPoints) * i);
-		float pixelY = v1.GetY() + ((yDiff	/ numOfPoints) * i);
-		float pixelZ = v1.GetPreTransformZ() + ((zDiff	/ numOfPoints) * i);
-
-		// Work out the UV value of the current pixel.
-		float u	= uvCoord1.U + ((uCoordDiff / numOfPoints) * i);
-		float v	= uvCoord1.V + ((vCoordDiff / numOfPoints) * i); 
-		float z	= uvCoord1.Z + ((zCoordDiff / numOfPoints) * i); 
-		
-		// If the x-value is below the scanline's start x-value, then 
-		// set the scanlines start value to the current values.
-		if (x < scanlines[scanline].xStart)
+	// Work out how much each varying changes along the edge.
+	float step[MAX_VARYINGS];
+	for (int j = 0; j < Varyings::Count; j++)
+		step[j] = end[j] - start[j];
+
+	// Work out the x value (16.16) where the edge crosses the first scanline centre. The
+	// x value is stepped as a whole part plus a remainder so it stays exact along the edge.
+	const int fractionShift = EDGE_FRACTION_BITS - SUBPIXEL_BITS;
+	long long yCentre = ((long long)yFirst << SUBPIXEL_BITS) + (SUBPIXEL_STEPS / 2);
+	long long xRemainder, xStepRemainder;
+	long long x = FloorDivide((((long long)x1 * yDiff) + ((yCentre - y1) * xDiff)) << fractionShift, yDiff, xRemainder);
+	long long xStep = FloorDivide(((long long)xDiff * SUBPIXEL_STEPS) << fractionShift, yDiff, xStepRemainder);
+
+	// Position along the edge of the first scanline centre and how far each scanline moves it.
+	float t = (yCentre - y1) / (float)yDiff;
+	float tStep = SUBPIXEL_STEPS / (float)yDiff;
+
+	// Go through each scanline the edge crosses and work out the
+	// varyings for pixel along the way.
+	int writes = 0;
+	for (int scanline = yFirst; scanline <= yLast; scanline++)
+	{
+		// If the x-value is below the scanline's start x-value, then set the scanlines
+		// start values to the current values. Likewise for the end x-value.
+		if (x < _edgeXStart[scanline])
 		{
-			scanlines[scanline].xStart = x;
-			scanlines[scanline].redStart = red;
-			scanlines[scanline].greenStart = green;
-			scanlines[scanline].blueStart = blue;
-			scanlines[scanline].uStart = u;
-			scanlines[scanline].vStart = v;
-			scanlines[scanline].zStart = z;
-			scanlines[scanline].xNormalStart = normalX;
-			scanlines[scanline].yNormalStart = normalY;
-			scanlines[scanline].zNormalStart = normalZ;
-			scanlines[scanline].pixelXStart = pixelX;
-			scanlines[scanline].pixelYStart = pixelY;
-			scanlines[scanline].pixelZStart = pixelZ;
+			_edgeXStart[scanline] = (int)x;
+			for (int j = 0; j < Varyings::Count; j++)
+				_varyingsStart[(j * _height) + scanline] = start[j] + (step[j] * t);
+			writes++;
+		}
+		if (x > _edgeXEnd[scanline])
+		{
+			_edgeXEnd[scanline] = (int)x;
+			for (int j = 0; j < Varyings::Count; j++)
+				_varyingsEnd[(j * _height) + scanline] = start[j] + (step[j] * t);
+			writes++;
 		}
 
-		// If the x-value is above the scanline's end x-value, then 
-		// set the scanlines end value to the current values.
-		if (x > scanlines[scanline].xEnd)
+		// Step to the next scanline.
+		x += xStep;
+		xRemainder += xStepRemainder;
+		if (xRemainder >= yDiff)
 		{
-			scanlines[scanline].xEnd = x;
-			scanlines[scanline].redEnd = red;
-			scanlines[scanline].greenEnd = green;
-			scanlines[scanline].blueEnd = blue;
-			scanlines[scanline].uEnd = u;
-			scanlines[scanline].vEnd = v;
-			scanlines[scanline].zEnd = z;
-			scanlines[scanline].xNormalEnd = normalX;
-			scanlines[scanline].yNormalEnd = normalY;
-			scanlines[scanline].zNormalEnd = normalZ;
-			scanlines[scanline].pixelXEnd = pixelX;
-			scanlines[scanline].pixelYEnd = pixelY;
-			scanlines[scanline].pixelZEnd = pixelZ;
+			x++;
+			xRemainder -= yDiff;
 		}
+		t += tStep;
 	}
+
+	_setupBytesWritten += writes * (Varyings::Count + 1) * sizeof(float);
 }
 
-// Draws the given model in wireframe mode.
-void Rasterizer::DrawWireFrame(Model3D& model)
+// Draws the given model instance in wireframe mode.
+void Rasterizer::DrawWireFrame(ModelInstance& instance)
 {
-	std::vector<Polygon3D> _polygonList = model.GetPolygonList();
-	std::vector<Vertex> _vertexList = model.GetTransformedVertexList();
+	std::vector<Polygon3D>& _polygonList = instance.GetPolygonList();
+	std::vector<Vertex>& _vertexList = instance.GetTransformedVertexList();
 	
 	// Iterate over and render each of the polygons in the list.
 	for (unsigned int i = 0; i < _polygonList.size(); i++)
 	{
-		Polygon3D poly = _polygonList[i];
-		if (poly.GetBackfacing() == true)
+		Polygon3D& poly = _polygonList[i];
+		if (poly.GetBackfacing() == true || poly.GetCulled() == true)
 			continue;
 
-		Vertex v1 = _vertexList[poly.GetVertexIndex(0)];
-		Vertex v2 = _vertexList[poly.GetVertexIndex(1)];
-		Vertex v3 = _vertexList[poly.GetVertexIndex(2)];
+		Vertex& v1 = _vertexList[poly.GetVertexIndex(0)];
+		Vertex& v2 = _vertexList[poly.GetVertexIndex(1)];
+		Vertex& v3 = _vertexList[poly.GetVertexIndex(2)];
 	
 		// Draw a line between each of the vertexs in the polygon.
 		DrawLine(v1.GetX(), v1.GetY(), v2.GetX(), v2.GetY());
 		DrawLine(v2.GetX(), v2.GetY(), v3.GetX(), v3.GetY());
 		DrawLine(v1.GetX(), v1.GetY(), v3.GetX(), v3.GetY());
 
-		_polygonsRendered++;
+		_stats.trianglesRasterized++;
 	}
 }
 
-// Draws the given model with solid shading.
-void Rasterizer::DrawSolidFlat(Model3D& model)
+// Draws the given model instance in the given display mode.
+void Rasterizer::DrawModel(ModelInstance& instance, DisplayMode mode)
 {
-	std::vector<Polygon3D> _polygonList = model.GetPolygonList();
-	std::vector<Vertex> _vertexList = model.GetTransformedVertexList();
-	
-	// Iterate over and render each of the polygons in the list.
-	for (unsigned int i = 0; i < _polygonList.size(); i++)
-	{
-		Polygon3D poly = _polygonList[i];
-		if (poly.GetBackfacing() == true)
-			continue;
-
-		Vertex v1 = _vertexList[poly.GetVertexIndex(0)];
-		Vertex v2 = _vertexList[poly.GetVertexIndex(1)];
-		Vertex v3 = _vertexList[poly.GetVertexIndex(2)];
-
-		// Fill the polygon using the polygons colour.
-		FillPolygon(v1, v2, v3, v1.GetColor());
-	}
-}
-
-// Draws the given model with gouraud shading.
-void Rasterizer::DrawSolidShaded(Model3D& model)
-{
-	std::vector<Polygon3D> _polygonList = model.GetPolygonList();
-	std::vector<Vertex> _vertexList = model.GetTransformedVertexList();
-	
-	// Iterate over and render each of the polygons in the list.
-	for (unsigned int i = 0; i < _polygonList.size(); i++)
-	{
-		Polygon3D poly = _polygonList[i];
-		if (poly.GetBackfacing() == true)
-			continue;
-
-		Vertex v1 = _vertexList[poly.GetVertexIndex(0)];
-		Vertex v2 = _vertexList[poly.GetVertexIndex(1)];
-		Vertex v3 = _vertexList[poly.GetVertexIndex(2)];
-		
-		// Fill the polygon using the polygons colour.
-		FillPolygonShaded(v1, v2, v3, poly.GetColor());
-	}
+	ModelInstance* instances = &instance;
+	DrawInstances(&instances, 1, mode);
 }
 
-// Draws the given model with texturing and shading.
-void Rasterizer::DrawSolidTextured(Model3D& model)
+// Draws a list of instances of the same model in the given display mode, using the span 
+// kernel the display mode maps to. The kernel and its state are set up once from the shared
+// model for the whole list. The instances are drawn in the order given.
+void Rasterizer::DrawInstances(ModelInstance** instances, int count, DisplayMode mode)
 {
-	std::vector<Polygon3D> _polygonList = model.GetPolygonList();
-	std::vector<Vertex> _vertexList = model.GetTransformedVertexList();
-	std::vector<UVCoordinate> _uvCoordList = model.GetUVCoordinateList();
+	if (count <= 0)
+		return;
 
-	for (unsigned int i = 0; i < _polygonList.size(); i++)
+	if (mode == WireFrame)
 	{
-		Polygon3D poly = _polygonList[i];
-		if (poly.GetBackfacing() == true)
-			continue;
+		for (int i = 0; i < count; i++)
+			DrawWireFrame(*instances[i]);
+		return;
+	}
 
-		Vertex v1 = _vertexList[poly.GetVertexIndex(0)];
-		Vertex v2 = _vertexList[poly.GetVertexIndex(1)];
-		Vertex v3 = _vertexList[poly.GetVertexIndex(2)];
+	Model3D& model = *instances[0]->GetModel();
 
-		// Set the uv coordinates of each vertex temporarily to the coordinates in the 
-		// uv coordinate list.
-		v1.SetUVCoordinate(_uvCoordList[poly.GetUVIndex(0)]);
-		v2.SetUVCoordinate(_uvCoordList[poly.GetUVIndex(1)]);
-		v3.SetUVCoordinate(_uvCoordList[poly.GetUVIndex(2)]);
+	SpanKernel kernel = GetSpanKernel(mode, model.GetColormapOn(), model.GetNormalMapOn());
+	if (kernel == SpanKernelNone)
+		return;
 
-		// Fill the polygon using the models texture.
-		FillPolygonTextured(v1, v2, v3, v1.GetColor(), model);
-	}
-}
+	SpanKernelFunction fillPolygon = GetSpanKernelFunction(kernel);
+	SetKernelState(model);
 
-// Draws the given model with texturing, shading and a normal map.
-void Rasterizer::DrawSolidTexturedNormalMapped(Model3D& model, std::vector<DirectionalLight*> directionalLights, std::vector<AmbientLight*> ambientLights, std::vector<PointLight*> pointLights)
-{
-	std::vector<Polygon3D> _polygonList = model.GetPolygonList();
-	std::vector<Vertex> _vertexList = model.GetTransformedVertexList();
-	std::vector<UVCoordinate> _uvCoordList = model.GetUVCoordinateList();
+	bool textured = (_kernelState.texture != NULL && model.GetUVCoordinateList().size() > 0);
 
-	for (unsigned int i = 0; i < _polygonList.size(); i++)
+	for (int i = 0; i < count; i++)
 	{
-		Polygon3D poly = _polygonList[i];
-		if (poly.GetBackfacing() == true)
-			continue;
+		ModelInstance& instance = *instances[i];
+		std::vector<Polygon3D>& _polygonList = instance.GetPolygonList();
+		std::vector<Vertex>& _vertexList = instance.GetTransformedVertexList();
+
+		// Iterate over and render each of the polygons in the list.
+		for (unsigned int j = 0; j < _polygonList.size(); j++)
+		{
+			Polygon3D& poly = _polygonList[j];
+			if (poly.GetBackfacing() == true || poly.GetCulled() == true)
+				continue;
 
-		Vertex v1 = _vertexList[poly.GetVertexIndex(0)];
-		Vertex v2 = _vertexList[poly.GetVertexIndex(1)];
-		Vertex v3 = _vertexList[poly.GetVertexIndex(2)];
+			Vertex v1 = _vertexList[poly.GetVertexIndex(0)];
+			Vertex v2 = _vertexList[poly.GetVertexIndex(1)];
+			Vertex v3 = _vertexList[poly.GetVertexIndex(2)];
 
-		// Set the uv coordinates of each vertex temporarily to the coordinates in the 
-		// uv coordinate list.
-		v1.SetUVCoordinate(_uvCoordList[poly.GetUVIndex(0)]);
-		v2.SetUVCoordinate(_uvCoordList[poly.GetUVIndex(1)]);
-		v3.SetUVCoordinate(_uvCoordList[poly.GetUVIndex(2)]);
+			// Set the uv coordinates of each vertex temporarily to the coordinates in the 
+			// uv coordinate list.
+			if (textured == true)
+			{
+				v1.SetUVCoordinate(instance.GetUVCoordinate(poly.GetUVIndex(0)));
+				v2.SetUVCoordinate(instance.GetUVCoordinate(poly.GetUVIndex(1)));
+				v3.SetUVCoordinate(instance.GetUVCoordinate(poly.GetUVIndex(2)));
+			}
 
-		// Fill the polygon using the models texture.
-		if (model.GetNormalMapOn() == true)
-			FillPolygonTexturedNormalMapped(v1, v2, v3, v1.GetColor(), model, directionalLights, ambientLights, pointLights);
-		else
-			FillPolygonTextured(v1, v2, v3, v1.GetColor(), model);
+			// Fill the polygon using the models colour.
+			(this->*fillPolygon)(v1, v2, v3, v1.GetColor());
+		}
 	}
 }
 
 // Renders the given text on screen at the given position.
 void Rasterizer::DrawText(float x, float y, const WCHAR* string)
 {
-	// Create all the objects we need to render the string.
-	Gdiplus::FontFamily* fontFamily = new FontFamily(L"Courier New");
-	Gdiplus::Font* font = new Font(fontFamily, 13, Gdiplus::FontStyleRegular, Gdiplus::UnitPixel);
+	// Create all the objects we need to render the string, on the stack so they are
+	// disposed of when we return.
+	Gdiplus::FontFamily fontFamily(L"Courier New");
+	Gdiplus::Font font(&fontFamily, 13, Gdiplus::FontStyleRegular, Gdiplus::UnitPixel);
 	Gdiplus::PointF origin = PointF(x, y);
 	Gdiplus::PointF shadowOrigin = PointF(x + 1, y + 1);
-	Gdiplus::Brush* brush = new SolidBrush(Gdiplus::Color::White);
-	Gdiplus::Brush* shadowBrush = new SolidBrush(Gdiplus::Color::Black);
+	Gdiplus::SolidBrush brush(Gdiplus::Color::White);
+	Gdiplus::SolidBrush shadowBrush(Gdiplus::Color::Black);
 
 	// Draw the text to string.
 	FinishLockBits();
-	_graphics->DrawString(string, -1, font, shadowOrigin, shadowBrush); 
-	_graphics->DrawString(string, -1, font, origin, brush); 	
+	_graphics->DrawString(string, -1, &font, shadowOrigin, &shadowBrush); 
+	_graphics->DrawString(string, -1, &font, origin, &brush); 	
+	BeginLockBits();
+}
+
+// Works out the colour of the given heat (0-1) in the debug views, running from blue
+// through cyan, green and yellow to red.
+static void GetHeatColor(float heat, int& red, int& green, int& blue)
+{
+	static const int stops[5][3] = { { 0, 0, 255 }, { 0, 255, 255 }, { 0, 255, 0 }, { 255, 255, 0 }, { 255, 0, 0 } };
+
+	float position = max(0.0f, min(1.0f, heat)) * 4.0f;
+	int stop = min((int)position, 3);
+	float t = position - stop;
+	red = (int)(stops[stop][0] + ((stops[stop + 1][0] - stops[stop][0]) * t));
+	green = (int)(stops[stop][1] + ((stops[stop + 1][1] - stops[stop][1]) * t));
+	blue = (int)(stops[stop][2] + ((stops[stop + 1][2] - stops[stop][2]) * t));
+}
+
+// Draws the debug view over the finished frame, before anything else like text is drawn
+// over it. The frame is turned grey and the heat of each pixel is blended over it. In the
+// overdraw view a pixel written once is blue and one written OVERDRAW_HEAT_MAX times or
+// more is red, in the tile cost view the costliest tile of the frame is red. Pixels that
+// nothing was drawn to are left grey. Only polygons filled by the span kernels are counted.
+void Rasterizer::DrawDebugView()
+{
+	if (_debugView == DebugViewNone)
+		return;
+
 	BeginLockBits();
+	ResolveClearTiles();
+
+	long long maxTileCost = 0;
+	for (int i = 0; i < _debugTilesPerRow * _debugTileRows; i++)
+		maxTileCost = max(maxTileCost, _tileCosts[i]);
+
+	for (unsigned int y = 0; y < _height; y++)
+	{
+		INT* pixelRow = (INT*)((BYTE*)_bitmapData.Scan0 + (y * _bitmapData.Stride));
+		unsigned short* overdraw = _overdraw + (y * _width);
+		long long* tileCosts = _tileCosts + ((y / DEBUG_TILE_SIZE) * _debugTilesPerRow);
+
+		for (unsigned int x = 0; x < _width; x++)
+		{
+			// Work out the heat of the pixel, or leave it at -1 if nothing was drawn to it.
+			float heat = -1.0f;
+			if (_debugView == DebugViewOverdraw)
+			{
+				if (overdraw[x] > 0)
+					heat = (min((int)overdraw[x], OVERDRAW_HEAT_MAX) - 1) / (float)(OVERDRAW_HEAT_MAX - 1);
+			}
+			else
+			{
+				long long cost = tileCosts[x / DEBUG_TILE_SIZE];
+				if (cost > 0)
+					heat = cost / (float)maxTileCost;
+			}
+
+			ARGB pixel = (ARGB)pixelRow[x];
+			int grey = ((((pixel >> 16) & 255) * 77) + (((pixel >> 8) & 255) * 150) + ((pixel & 255) * 29)) >> 8;
+			if (heat < 0)
+			{
+				pixelRow[x] = Gdiplus::Color::MakeARGB(255, (BYTE)grey, (BYTE)grey, (BYTE)grey);
+				continue;
+			}
 
-	// Dispose of all objects we created.
-	delete fontFamily;
-	delete font;
-	delete brush;
-	delete shadowBrush;
+			int red, green, blue;
+			GetHeatColor(heat, red, green, blue);
+			pixelRow[x] = Gdiplus::Color::MakeARGB(255,
+				(BYTE)((grey * (1.0f - DEBUG_VIEW_OPACITY)) + (red * DEBUG_VIEW_OPACITY)),
+				(BYTE)((grey * (1.0f - DEBUG_VIEW_OPACITY)) + (green * DEBUG_VIEW_OPACITY)),
+				(BYTE)((grey * (1.0f - DEBUG_VIEW_OPACITY)) + (blue * DEBUG_VIEW_OPACITY)));
+		}
+	}
 }
@@ -8,47 +8,145 @@
 #pragma once
 #include "Vertex.h"
 #include "Model3D.h"
+#include "ModelInstance.h"
+#include "DisplayMode.h"
+#include "RenderStats.h"
 
 using namespace Gdiplus;
 
-// This struct is used to store the values
-// needed to render a polygons scanline.
-struct ScanLine
+// Compile time features used to build each span kernel. Each kernel
+// only interpolates and shades with the features it is built with.
+enum KernelFeatures
 {
-	float xStart;
-	float xEnd;
+	KernelFlat					= 0,	// Flat colour.
+	KernelGouraud				= 1,	// Interpolated vertex colours.
+	KernelTextured				= 2,	// Sample the models texture.
+	KernelPerspective			= 4,	// Perspective correct the texture coordinates.
+	KernelNormalMapped			= 8,	// Per-pixel normal map lighting.
+	KernelDirectionalLights		= 16,	// Normal map lighting from directional lights.
+	KernelPointLights			= 32,	// Normal map lighting from point lights.
+	KernelColormap				= 64,	// Lit texture colour from the models colormap.
+	KernelDebugCounters			= 128	// Count the writes and time of each span for the debug views.
+};
+
+// Enumeration of every span kernel that is instantiated.
+enum SpanKernel
+{
+	SpanKernelNone = -1,
+	SpanKernelFlat,
+	SpanKernelGouraud,
+	SpanKernelTextured,
+	SpanKernelTexturedAffine,
+	SpanKernelTexturedColormap,
+	SpanKernelNormalMappedDirectional,
+	SpanKernelNormalMappedDirectionalPoint
+};
+
+// Attributes that can be interpolated across a polygon. A varyings descriptor
+// is a combination of these and decides how wide the varyings arrays are.
+enum VaryingAttributes
+{
+	VaryingNone					= 0,
+	VaryingColor				= 1,	// Red, green and blue vertex colour.
+	VaryingUV					= 2,	// Texture coordinates.
+	VaryingInverseZ				= 4,	// 1/z used for perspective correction.
+	VaryingNormal				= 8,	// Vertex normal.
+	VaryingPosition				= 16	// Pixel position and depth.
+};
+
+// Maximum number of floats a set of varyings can contain.
+#define MAX_VARYINGS			12
+
+// This struct describes which attributes a draw interpolates and where each one 
+// lives in the packed varyings. Offsets of unused attributes are -1.
+struct VaryingsDescriptor
+{
+	int attributes;
+	int count;
 
-	float redStart;
-	float greenStart;
-	float blueStart;
+	int colorOffset;
+	int uvOffset;
+	int inverseZOffset;
+	int normalOffset;
+	int positionOffset;
+};
 
-	float redEnd;
-	float greenEnd;
-	float blueEnd;
+// Works out the varyings of a span kernel at compile time from its features, 
+// so the kernels can index their varyings with constants.
+template <int Features>
+struct KernelVaryings
+{
+	enum
+	{
+		Attributes		= ((Features & KernelGouraud) ? VaryingColor : 0) |
+						  ((Features & KernelTextured) ? VaryingUV : 0) |
+						  ((Features & KernelPerspective) ? VaryingInverseZ : 0) |
+						  ((Features & KernelNormalMapped) ? VaryingNormal | VaryingPosition : 0),
+
+		ColorOffset		= 0,
+		UVOffset		= ColorOffset + ((Attributes & VaryingColor) ? 3 : 0),
+		InverseZOffset	= UVOffset + ((Attributes & VaryingUV) ? 2 : 0),
+		NormalOffset	= InverseZOffset + ((Attributes & VaryingInverseZ) ? 1 : 0),
+		PositionOffset	= NormalOffset + ((Attributes & VaryingNormal) ? 3 : 0),
+		Count			= PositionOffset + ((Attributes & VaryingPosition) ? 3 : 0)
+	};
+};
 
-	float uStart;
-	float vStart;
-	float zStart;
+// Number of span kernels in the enumeration above.
+#define SPAN_KERNEL_COUNT		7
 
-	float uEnd;
-	float vEnd;
-	float zEnd;
+// Screen positions are snapped to 28.4 fixed point before a polygon is set up, and
+// edges are stepped in 16.16 fixed point.
+#define SUBPIXEL_BITS			4
+#define SUBPIXEL_STEPS			(1 << SUBPIXEL_BITS)
+#define EDGE_FRACTION_BITS		16
 
-	float xNormalStart;
-	float yNormalStart;
-	float zNormalStart;
+// Furthest a vertex can be from the origin (in pixels) before it is clamped,
+// keeps 16.16 edge positions within the range of an int.
+#define SUBPIXEL_LIMIT			16384.0f
 
-	float xNormalEnd;
-	float yNormalEnd;
-	float zNormalEnd;
+// Width in pixels of the tiles the fast clear keeps a cleared flag for. Each tile is one
+// scanline high, so a span that covers a whole tile never has to clear it.
+#define CLEAR_TILE_WIDTH		32
 
-	float pixelXStart;
-	float pixelYStart;
-	float pixelZStart;
+// Builds a second set of span kernels that count the writes and time of each span, used
+// while a debug view is on. The standard kernels never count anything, set to false to
+// leave the counting kernels and the debug views out entirely.
+#define DEBUG_VIEWS_ON			true
+
+// Size in pixels of the square tiles the tile cost view times, the number of writes the
+// overdraw view shows at full heat, and how much of the heat colour is blended over the
+// frame in both views.
+#define DEBUG_TILE_SIZE			16
+#define OVERDRAW_HEAT_MAX		8
+#define DEBUG_VIEW_OPACITY		0.75f
+
+// Maximum number of lights of each type the normal mapped kernels will use.
+#define MAX_KERNEL_LIGHTS		8
+
+// This struct holds the per-model values used by the span kernels, so they
+// are fetched once per model rather than once per polygon.
+struct KernelState
+{
+	BYTE* texture;
+	Gdiplus::Color* palette;
+	int textureWidth;
 
-	float pixelXEnd;
-	float pixelYEnd;
-	float pixelZEnd;
+	BYTE* normalTexture;
+	Gdiplus::Color* normalPalette;
+
+	unsigned int* colormap;
+	BYTE* redColormap;
+	BYTE* greenColormap;
+	BYTE* blueColormap;
+	float colormapLevelScale;
+	int colormapMaxLevel;
+
+	// Positions of the enabled lights used by the normal mapped kernels.
+	Vector3D directionalLightPositions[MAX_KERNEL_LIGHTS];
+	int directionalLightCount;
+	Vector3D pointLightPositions[MAX_KERNEL_LIGHTS];
+	int pointLightCount;
 };
 
 // This is the rasterizer class, it is responsible for rendering 
@@ -62,8 +160,21 @@ class Rasterizer
 		unsigned int GetWidth() const;
 		unsigned int GetHeight() const;
 		Bitmap * GetBitmap() const;
-		unsigned int GetPolygonsRendered();
-		void ResetPolygonsRendered();
+		void SetRenderTarget(Bitmap* bitmap, Graphics* graphics);
+		const RenderStats& GetStats();
+		void ResetStats();
+		unsigned int GetSetupBytesWritten();
+		void ResetSetupBytesWritten();
+		unsigned int GetClearBytesWritten();
+		void ResetClearBytesWritten();
+
+		void SetFastClearOn(bool val);
+		bool GetFastClearOn();
+
+		void SetDebugView(DebugView view);
+		DebugView GetDebugView();
+
+		void SetLights(const std::vector<DirectionalLight*>& directionalLights, const std::vector<AmbientLight*>& ambientLights, const std::vector<PointLight*>& pointLights);
 
 		void BeginLockBits();
 		void FinishLockBits();
@@ -74,31 +185,87 @@ class Rasterizer
 		void DrawLine(float x1, float y1, float x2, float y2);
 		void DrawTriangle(float x1, float y1, float x2, float y2, float x3, float y3, Gdiplus::Color color);
 		
-		void FillPolygon(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color);
-		void FillPolygonShaded(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color);
-		void FillPolygonTextured(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color, Model3D& model);
-		void FillPolygonTexturedNormalMapped(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color, Model3D& model, std::vector<DirectionalLight*> directionalLights, std::vector<AmbientLight*> ambientLights, std::vector<PointLight*> pointLights);
-		void InterpolateScanline(ScanLine* scanlines, Vertex v1, Vertex v2);
-
-		void DrawWireFrame(Model3D& model);
-		void DrawSolidFlat(Model3D& model);
-		void DrawSolidShaded(Model3D& model);
-		void DrawSolidTextured(Model3D& model);
-		void DrawSolidTexturedNormalMapped(Model3D& model, std::vector<DirectionalLight*> directionalLights, std::vector<AmbientLight*> ambientLights, std::vector<PointLight*> pointLights);
+		void FillPolygon(SpanKernel kernel, Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color, Model3D& model);
+		void SetupPolygon(SpanKernel kernel, Vertex v1, Vertex v2, Vertex v3);
+
+		void DrawWireFrame(ModelInstance& instance);
+		void DrawModel(ModelInstance& instance, DisplayMode mode);
+		void DrawInstances(ModelInstance** instances, int count, DisplayMode mode);
 
 		void DrawText(float x, float y, const WCHAR* string);
+		void DrawDebugView();
+
+		static SpanKernel GetSpanKernel(DisplayMode mode, bool colormapOn, bool normalMapOn);
+		static const char* GetSpanKernelName(SpanKernel kernel);
+		static VaryingsDescriptor GetVaryingsDescriptor(SpanKernel kernel);
 
 	private:
 		unsigned int _width;
 		unsigned int _height;
-		unsigned int _polygonsRendered;
+		RenderStats _stats;
+		unsigned int _setupBytesWritten;
+		unsigned int _clearBytesWritten;
 		Bitmap * _bitmap;
 		Graphics * _graphics; 
+		Bitmap * _ownBitmap;
+		Graphics * _ownGraphics;
 		BitmapData _bitmapData;
 
 		bool _bitsLocked;
 
+		// Lights used by the normal mapped kernels.
+		std::vector<DirectionalLight*> _directionalLights;
+		std::vector<AmbientLight*> _ambientLights;
+		std::vector<PointLight*> _pointLights;
+
+		// Edge x values (16.16 fixed point) and varyings of each scanline, shared by every polygon. The varyings
+		// are packed structure of arrays, one row of _height floats per varying, so a draw
+		// only touches as many rows as its varyings descriptor declares.
+		int* _edgeXStart;
+		int* _edgeXEnd;
+		float* _varyingsStart;
+		float* _varyingsEnd;
+
+		// Fast clear state. Each flag is set when its tile still has to be filled with
+		// the clear colour, the tiles are filled when first drawn to or when unlocked.
+		bool _fastClearOn;
+		ARGB _clearColor;
+		BYTE* _clearTiles;
+		int _clearTilesPerRow;
+		unsigned int _clearTilesPending;
+
+		// Debug view state. The writes to each pixel and the nanoseconds spent shading each
+		// tile since the last clear, only counted while a debug view is on.
+		DebugView _debugView;
+		unsigned short* _overdraw;
+		long long* _tileCosts;
+		int _debugTilesPerRow;
+		int _debugTileRows;
+
+		// State of the model being drawn.
+		KernelState _kernelState;
+
+		// Tables of span kernels and their scanline setup, indexed by SpanKernel.
+		typedef void (Rasterizer::*SpanKernelFunction)(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color);
+		static const SpanKernelFunction _spanKernels[SPAN_KERNEL_COUNT];
+		static const SpanKernelFunction _debugSpanKernels[SPAN_KERNEL_COUNT];
+		typedef void (Rasterizer::*SetupKernelFunction)(Vertex v1, Vertex v2, Vertex v3);
+		static const SetupKernelFunction _setupKernels[SPAN_KERNEL_COUNT];
+
+		void ClearPixels(INT* pixels, int count, ARGB color);
+		void ResolveClearSpan(int y, int xStart, int xEnd);
+		void ResolveClearTiles();
+		void CountDebugSpan(int y, int xStart, int xEnd, long long nanoseconds);
+		SpanKernelFunction GetSpanKernelFunction(SpanKernel kernel);
+
+		void SetKernelState(Model3D& model);
+		bool BeginScanlines(Vertex& v1, Vertex& v2, Vertex& v3, int& yStart, int& yEnd);
+
+		template <int Features> void FillPolygonKernel(Vertex v1, Vertex v2, Vertex v3, Gdiplus::Color color);
+		template <int Features> void SetupPolygonKernel(Vertex v1, Vertex v2, Vertex v3);
+		template <int Features> bool SetupScanlines(Vertex& v1, Vertex& v2, Vertex& v3, int& yStart, int& yEnd);
+		template <int Features> void InterpolateScanline(Vertex v1, Vertex v2);
+
 		// Private constructor. Should not be used directly.
 		Rasterizer(void);
 };
-
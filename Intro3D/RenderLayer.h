@@ -0,0 +1,20 @@
+// =========================================================================================
+//	RenderLayer.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+
+// Enumeration of the layers the render queue draws, in the order they are drawn.
+// Each layer is drawn entirely before the next, so instances in a later layer always
+// paint over those in an earlier one.
+enum RenderLayer
+{
+	RenderLayerBackground,		// Instances nothing else is behind, eg. the floor. Sorted by shading state.
+	RenderLayerScene			// Everything else. Sorted back to front.
+};
+
+// Number of render layers in the enumeration above.
+#define RENDER_LAYER_COUNT		2
@@ -0,0 +1,541 @@
+// =========================================================================================
+//	RenderQueue.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "RenderQueue.h"
+#include <algorithm>
+
+// Layout of the sort key. The layer is always the top bits, the rest depends on whether
+// the layer is sorted by state (kernel and texture, then depth) or by depth first.
+#define SORT_KEY_LAYER_SHIFT	60
+#define SORT_KEY_STATE_BITS		24
+
+// Whether each layer has to be drawn back to front, indexed by RenderLayer.
+static const bool RenderLayerSortByDepth[RENDER_LAYER_COUNT] =
+{
+	false,	// RenderLayerBackground
+	true	// RenderLayerScene
+};
+
+// Data passed to the jobs of a geometry pass.
+struct GeometryPassData
+{
+	RenderQueue* queue;
+	ModelInstance* instance;
+	GeometryPass pass;
+};
+
+// This struct is used to sort draw items by their sort key, and items with equal keys in
+// the order they were submitted.
+struct SortDrawItems
+{
+	bool operator() (const DrawItem& lhs, const DrawItem& rhs) const
+	{
+		if (lhs.sortKey != rhs.sortKey)
+			return lhs.sortKey < rhs.sortKey;
+		return lhs.order < rhs.order;
+	}
+};
+
+// Builds the sort key of a draw item.
+static unsigned long long MakeSortKey(RenderLayer layer, SpanKernel kernel, unsigned int texture, float depth)
+{
+	// Positive floats sort the same as their bit patterns, invert them so the furthest is first.
+	unsigned int depthBits;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+	unsigned long long farToNear = 0xFFFFFFFF - depthBits;
+
+	unsigned long long state = ((unsigned long long)(kernel + 1) << 16) | (texture & 0xFFFF);
+	unsigned long long key = (unsigned long long)layer << SORT_KEY_LAYER_SHIFT;
+
+	if (RenderLayerSortByDepth[layer] == true)
+		key |= (farToNear << SORT_KEY_STATE_BITS) | state;
+	else
+		key |= (state << 32) | farToNear;
+
+	return key;
+}
+
+// Constructor.
+RenderQueue::RenderQueue(void)
+{
+	_camera = NULL;
+	_rasterizer = NULL;
+	_jobSystem = NULL;
+	_maxBatchSize = MAX_INSTANCES_PER_DRAW;
+	_pipelineOn = false;
+	_pipelineFrame = 0;
+	_geometryFrame = NULL;
+	_culledCount = 0;
+	_batchCount = 0;
+}
+
+// Destructor.
+RenderQueue::~RenderQueue(void)
+{
+}
+
+// Sets the lights the instances are lit by.
+void RenderQueue::SetLights(const std::vector<DirectionalLight*>& directionalLights, const std::vector<AmbientLight*>& ambientLights, const std::vector<PointLight*>& pointLights, const std::vector<SpotLight*>& spotLights)
+{
+	_directionalLights = directionalLights;
+	_ambientLights = ambientLights;
+	_pointLights = pointLights;
+	_spotLights = spotLights;
+}
+
+// Accessor methods. Simple get/set code.
+void RenderQueue::SetJobSystem(JobSystem* val)
+{
+	_jobSystem = val;
+}
+JobSystem* RenderQueue::GetJobSystem()
+{
+	return _jobSystem;
+}
+void RenderQueue::SetMaxBatchSize(int val)
+{
+	_maxBatchSize = max(val, 1);
+}
+int RenderQueue::GetMaxBatchSize()
+{
+	return _maxBatchSize;
+}
+bool RenderQueue::GetPipelineOn()
+{
+	return _pipelineOn;
+}
+unsigned int RenderQueue::GetItemCount()
+{
+	return _items.size();
+}
+unsigned int RenderQueue::GetCulledCount()
+{
+	return _culledCount;
+}
+unsigned int RenderQueue::GetBatchCount()
+{
+	return _batchCount;
+}
+const RenderStats& RenderQueue::GetStats()
+{
+	return _stats;
+}
+InstanceBufferPool* RenderQueue::GetBufferPool()
+{
+	return &_bufferPool;
+}
+
+// Turns pipelining on or off. Turning it off drops the frame still held, call Flush 
+// first to draw it.
+void RenderQueue::SetPipelineOn(bool val)
+{
+	if (val == false)
+	{
+		for (int i = 0; i < PIPELINE_FRAME_COUNT; i++)
+			ReleasePipelineFrame(_pipelineFrames[i]);
+	}
+	_pipelineOn = val;
+}
+
+// Starts a new frame, drawn from the given camera with the given rasterizer.
+void RenderQueue::Begin(Camera* camera, Rasterizer* rasterizer)
+{
+	_camera = camera;
+	_rasterizer = rasterizer;
+	_items.clear();
+	_culledCount = 0;
+	_batchCount = 0;
+
+	_stats.Reset();
+	_workerStats.resize(_jobSystem != NULL ? _jobSystem->GetWorkerCount() : 1);
+}
+
+// Adds an instance to be drawn this frame in the given display mode.
+void RenderQueue::Submit(ModelInstance* instance, DisplayMode mode)
+{
+	Model3D* model = instance->GetModel();
+
+	DrawItem item;
+	item.instance = instance;
+	item.model = model;
+	item.mode = mode;
+
+	item.kernel = Rasterizer::GetSpanKernel(mode, model->GetColormapOn(), model->GetNormalMapOn());
+
+	Gdiplus::Color* palette;
+	int textureWidth;
+	model->GetTexture(&item.texture, &palette, &textureWidth);
+
+	Vector3D center;
+	float radius;
+	Vertex cameraPosition = _camera->GetPosition();
+	instance->GetWorldBoundingSphere(center, radius);
+	item.depth = Vector3D(center.GetX() - cameraPosition.GetX(),
+						  center.GetY() - cameraPosition.GetY(),
+						  center.GetZ() - cameraPosition.GetZ()).GetLength();
+
+	item.sortKey = MakeSortKey(instance->GetRenderLayer(), item.kernel, GetTextureIndex(item.texture), item.depth);
+	item.order = _items.size();
+	_items.push_back(item);
+	_stats.trianglesSubmitted += model->GetPolygonList().size();
+}
+
+// Sorts the items submitted this frame and draws them. When pipelined this draws the
+// frame executed before, and processes this frames geometry at the same time.
+void RenderQueue::Execute()
+{
+	// Items with equal keys are kept in the order they were submitted. The order is part
+	// of the comparison rather than using a stable sort, which allocates a buffer each time.
+	{
+		PROFILE_SCOPE(ProfileStageSubmit);
+		std::sort(_items.begin(), _items.end(), SortDrawItems());
+	}
+
+	if (_pipelineOn == true)
+	{
+		ExecutePipelined();
+		MergeWorkerStats();
+		return;
+	}
+
+	// Batch neighbouring items that are drawn the same way.
+	unsigned int first = 0;
+	while (first < _items.size())
+	{
+		unsigned int last = GetBatchEnd(first);
+		DrawBatch(first, last - first);
+		first = last;
+	}
+	MergeWorkerStats();
+}
+
+// Returns the stats the calling worker counts the geometry it processes into.
+RenderStats& RenderQueue::GetWorkerStats()
+{
+	if (_jobSystem == NULL)
+		return _workerStats[0];
+	return _workerStats[_jobSystem->GetCurrentWorker()];
+}
+
+// Adds the stats each worker counted this frame to the frames stats.
+void RenderQueue::MergeWorkerStats()
+{
+	for (unsigned int i = 0; i < _workerStats.size(); i++)
+	{
+		_stats.Add(_workerStats[i]);
+		_workerStats[i].Reset();
+	}
+}
+
+// Draws the frame still held when pipelined. The rasterizer given to Begin must still 
+// be ready to draw into.
+void RenderQueue::Flush()
+{
+	if (_pipelineOn == false)
+		return;
+
+	DrawPipelineFrame(_pipelineFrames[(_pipelineFrame + 1) % PIPELINE_FRAME_COUNT]);
+}
+
+// Returns the end of the batch starting at the given item, neighbouring items 
+// that are drawn the same way are batched together.
+unsigned int RenderQueue::GetBatchEnd(unsigned int first)
+{
+	unsigned int last = first + 1;
+	while (last < _items.size() && (int)(last - first) < _maxBatchSize &&
+		   _items[last].model == _items[first].model && _items[last].mode == _items[first].mode)
+		last++;
+	return last;
+}
+
+// Returns a small index for the given texture, used in place of its address in the sort key.
+unsigned int RenderQueue::GetTextureIndex(BYTE* texture)
+{
+	for (unsigned int i = 0; i < _textures.size(); i++)
+	{
+		if (_textures[i] == texture)
+			return i;
+	}
+
+	_textures.push_back(texture);
+	return _textures.size() - 1;
+}
+
+// Culls, transforms and draws a run of items that share the same model and display mode.
+void RenderQueue::DrawBatch(unsigned int first, unsigned int count)
+{
+	_batch.clear();
+	_batchVisibility.clear();
+	{
+		PROFILE_SCOPE(ProfileStageCull);
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			// Skip the instance entirely if its bounds are outside the view.
+			ModelInstance* instance = _items[i].instance;
+			FrustumTest visibility = instance->TestFrustum(_camera);
+			if (visibility == FrustumOutside)
+			{
+				_culledCount++;
+				_stats.trianglesFrustumCulled += instance->GetModel()->GetPolygonList().size();
+				continue;
+			}
+
+			instance->AcquireBuffers(&_bufferPool);
+			_batch.push_back(instance);
+			_batchVisibility.push_back(visibility);
+		}
+	}
+	if (_batch.size() == 0)
+		return;
+
+	// Each instance has its own buffers, so they can all be transformed at once.
+	if (_jobSystem != NULL && _batch.size() > 1)
+		_jobSystem->ParallelFor(_batch.size(), 1, TransformBatchJob, this);
+	else
+		TransformBatchJob(this, 0, _batch.size());
+
+	// Render using the span kernel of the items display mode.
+	{
+		PROFILE_SCOPE(ProfileStageDraw);
+		_rasterizer->DrawInstances(&_batch[0], _batch.size(), _items[first].mode);
+	}
+	_batchCount++;
+
+	for (unsigned int i = 0; i < _batch.size(); i++)
+		_batch[i]->ReleaseBuffers(&_bufferPool);
+}
+
+// Culls and copies the instances of this frame and starts processing their geometry, then
+// draws the frame before while it runs. Returns once this frames geometry is finished.
+void RenderQueue::ExecutePipelined()
+{
+	PipelineFrame& frame = _pipelineFrames[_pipelineFrame];
+	PipelineFrame& previous = _pipelineFrames[(_pipelineFrame + 1) % PIPELINE_FRAME_COUNT];
+
+	unsigned int first = 0;
+	while (first < _items.size())
+	{
+		unsigned int last = GetBatchEnd(first);
+
+		GeometryBatch batch;
+		batch.mode = _items[first].mode;
+		batch.first = frame.instances.size();
+		PROFILE_SCOPE(ProfileStageCull);
+		for (unsigned int i = first; i < last; i++)
+		{
+			// Skip the instance entirely if its bounds are outside the view.
+			ModelInstance* instance = _items[i].instance;
+			FrustumTest visibility = instance->TestFrustum(_camera);
+			if (visibility == FrustumOutside)
+			{
+				_culledCount++;
+				_stats.trianglesFrustumCulled += instance->GetModel()->GetPolygonList().size();
+				continue;
+			}
+
+			frame.instances.push_back(*instance);
+			frame.visibility.push_back(visibility);
+		}
+		batch.count = frame.instances.size() - batch.first;
+
+		if (batch.count > 0)
+		{
+			frame.batches.push_back(batch);
+			_batchCount++;
+		}
+		first = last;
+	}
+
+	// The copies are all made, so they stay where they are until the frame is released.
+	for (unsigned int i = 0; i < frame.instances.size(); i++)
+	{
+		frame.instances[i].AcquireBuffers(&_bufferPool);
+		frame.drawList.push_back(&frame.instances[i]);
+	}
+
+	// Process this frames geometry on the workers while the frame before is drawn here.
+	_geometryFrame = &frame;
+	if (_jobSystem != NULL)
+	{
+		for (unsigned int i = 0; i < frame.instances.size(); i++)
+			_jobSystem->Run(PipelineGeometryJob, this, i, i + 1, &frame.counter);
+	}
+
+	DrawPipelineFrame(previous);
+
+	if (_jobSystem != NULL)
+		_jobSystem->Wait(&frame.counter);
+	else
+		PipelineGeometryJob(this, 0, frame.instances.size());
+
+	_geometryFrame = NULL;
+	_pipelineFrame = (_pipelineFrame + 1) % PIPELINE_FRAME_COUNT;
+}
+
+// Draws a frame whose geometry has been processed, then releases it.
+void RenderQueue::DrawPipelineFrame(PipelineFrame& frame)
+{
+	for (unsigned int i = 0; i < frame.batches.size(); i++)
+	{
+		GeometryBatch& batch = frame.batches[i];
+		PROFILE_SCOPE(ProfileStageDraw);
+		_rasterizer->DrawInstances(&frame.drawList[batch.first], batch.count, batch.mode);
+	}
+	ReleasePipelineFrame(frame);
+}
+
+// Gives the buffers of a frame back to the pool and empties it, ready to be reused.
+void RenderQueue::ReleasePipelineFrame(PipelineFrame& frame)
+{
+	for (unsigned int i = 0; i < frame.instances.size(); i++)
+		frame.instances[i].ReleaseBuffers(&_bufferPool);
+
+	frame.instances.clear();
+	frame.drawList.clear();
+	frame.visibility.clear();
+	frame.batches.clear();
+}
+
+// Processes the geometry of the instances of the pipelined frame in the range [begin, end).
+void RenderQueue::PipelineGeometryJob(void* data, int begin, int end)
+{
+	RenderQueue* queue = (RenderQueue*)data;
+	PipelineFrame* frame = queue->_geometryFrame;
+	for (int i = begin; i < end; i++)
+		queue->TransformInstance(&frame->instances[i], frame->visibility[i]);
+}
+
+// Transforms, lights and clips the instances of the batch in the range [begin, end).
+void RenderQueue::TransformBatchJob(void* data, int begin, int end)
+{
+	RenderQueue* queue = (RenderQueue*)data;
+	for (int i = begin; i < end; i++)
+		queue->TransformInstance(queue->_batch[i], queue->_batchVisibility[i]);
+}
+
+// Transforms, lights and clips a model instance into its buffers ready to be drawn. Each 
+// pass over the vertexs or polygons finishes before the next starts, the steps that
+// add to or reorder the lists are run between them on this thread.
+void RenderQueue::TransformInstance(ModelInstance* instance, FrustumTest visibility)
+{
+	instance->ResetBuffers();
+	RunGeometryPass(instance, GeometryPassTransform, instance->GetTransformedVertexList().size());
+	RunGeometryPass(instance, GeometryPassBackfaces, instance->GetPolygonList().size());
+	{
+		PROFILE_SCOPE(ProfileStageNormals);
+		instance->SumVertexNormals();
+	}
+	RunGeometryPass(instance, GeometryPassLighting, instance->GetTransformedVertexList().size());
+
+	// Clip against the near plane and cull polygons outside the view, then sort
+	// what is left (including any polygons clipping added) before the divide.
+	// Instances entirely inside the view have nothing to clip.
+	if (visibility != FrustumInside)
+	{
+		PROFILE_SCOPE(ProfileStageClip);
+		instance->ClipPolygons(_camera, GetWorkerStats());
+	}
+	RunGeometryPass(instance, GeometryPassDepths, instance->GetPolygonList().size());
+	{
+		PROFILE_SCOPE(ProfileStageSort);
+		instance->DepthSort();
+	}
+	RunGeometryPass(instance, GeometryPassProject, instance->GetTransformedVertexList().size());
+}
+
+// Runs a pass over the given number of vertexs or polygons of an instance, split 
+// into chunks across the workers if there are enough of them.
+void RenderQueue::RunGeometryPass(ModelInstance* instance, GeometryPass pass, int count)
+{
+	if (_jobSystem == NULL || count <= GEOMETRY_CHUNK_SIZE)
+	{
+		RunGeometryRange(instance, pass, 0, count);
+		return;
+	}
+
+	GeometryPassData data;
+	data.queue = this;
+	data.instance = instance;
+	data.pass = pass;
+	_jobSystem->ParallelFor(count, GEOMETRY_CHUNK_SIZE, GeometryPassJob, &data);
+}
+
+// Runs a chunk of a geometry pass.
+void RenderQueue::GeometryPassJob(void* data, int begin, int end)
+{
+	GeometryPassData* passData = (GeometryPassData*)data;
+	passData->queue->RunGeometryRange(passData->instance, passData->pass, begin, end);
+}
+
+// Runs a geometry pass over the vertexs or polygons in the range [begin, end).
+void RenderQueue::RunGeometryRange(ModelInstance* instance, GeometryPass pass, int begin, int end)
+{
+	switch (pass)
+	{
+		case GeometryPassTransform:
+		{
+			PROFILE_SCOPE(ProfileStageTransform);
+			instance->ApplyTransformToLocalVertices(begin, end);
+			break;
+		}
+
+		case GeometryPassBackfaces:
+		{
+			PROFILE_SCOPE(ProfileStageBackfaces);
+			instance->CalculateBackfaces(_camera, begin, end, GetWorkerStats());
+			instance->ResetLighting(begin, end);
+			break;
+		}
+
+		case GeometryPassLighting:
+		{
+			{
+				PROFILE_SCOPE(ProfileStageNormals);
+				instance->NormalizeVertexNormals(begin, end);
+			}
+			{
+				PROFILE_SCOPE(ProfileStageLightingAmbient);
+				instance->CalculateLightingAmbient(_ambientLights, begin, end);
+			}
+			{
+				PROFILE_SCOPE(ProfileStageLightingDirectional);
+				instance->CalculateLightingDirectional(_directionalLights, begin, end);
+			}
+			{
+				PROFILE_SCOPE(ProfileStageLightingPoint);
+				instance->CalculateLightingPoint(_pointLights, begin, end);
+			}
+			{
+				PROFILE_SCOPE(ProfileStageLightingSpot);
+				instance->CalculateLightingSpot(_spotLights, begin, end);
+			}
+
+			// Apply the viewport and perspective matrices.
+			PROFILE_SCOPE(ProfileStageViewport);
+			instance->ApplyTransformToTransformedVertices(_camera->GetViewportMatrix(), begin, end);
+			instance->ApplyTransformToTransformedVertices(_camera->GetPerspectiveMatrix(), begin, end);
+			break;
+		}
+
+		case GeometryPassDepths:
+		{
+			PROFILE_SCOPE(ProfileStageDepths);
+			instance->CalculatePolygonDepths(begin, end);
+			break;
+		}
+
+		case GeometryPassProject:
+		{
+			// Convert the vertexs to screen space.
+			PROFILE_SCOPE(ProfileStageProject);
+			instance->DehomogenizeTransformedVertices(begin, end);
+			instance->ApplyTransformToTransformedVertices(_camera->GetScreenMatrix(), begin, end);
+			break;
+		}
+	}
+}
@@ -0,0 +1,158 @@
+// =========================================================================================
+//	RenderQueue.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "ModelInstance.h"
+#include "InstanceBufferPool.h"
+#include "Rasterizer.h"
+#include "Camera.h"
+#include "RenderLayer.h"
+#include "DisplayMode.h"
+#include "JobSystem.h"
+#include <vector>
+
+// Most instances of a model transformed and drawn together by default. Each holds its own
+// buffers until the draw is done, so this bounds the buffers in use at once.
+#define MAX_INSTANCES_PER_DRAW	16
+
+// Number of vertexs or polygons in each job when a model is split across workers. 
+// Models smaller than this are worked on by a single worker.
+#define GEOMETRY_CHUNK_SIZE		256
+
+// Number of frames the render queue holds when pipelined, the one being drawn and the
+// one whose geometry is being processed.
+#define PIPELINE_FRAME_COUNT	2
+
+// Passes over the vertexs or polygons of an instance that can be split into chunks.
+enum GeometryPass
+{
+	GeometryPassTransform,		// Vertexs, world transform.
+	GeometryPassBackfaces,		// Polygons, backface flags and reset lighting.
+	GeometryPassLighting,		// Vertexs, normals, lighting, viewport and perspective.
+	GeometryPassDepths,			// Polygons, average depths.
+	GeometryPassProject			// Vertexs, dehomogenize and screen transform.
+};
+
+// Something submitted to the render queue to be drawn this frame.
+struct DrawItem
+{
+	unsigned long long sortKey;
+	unsigned int order;		// Order it was submitted in this frame, breaks ties between keys.
+	ModelInstance* instance;
+	Model3D* model;
+	DisplayMode mode;
+	SpanKernel kernel;
+	BYTE* texture;
+	float depth;			// Distance from the camera to the centre of the instances bounds.
+};
+
+// A run of instances in a pipelined frame that share the same model and display mode.
+struct GeometryBatch
+{
+	DisplayMode mode;
+	unsigned int first;
+	unsigned int count;
+};
+
+// The geometry of a frame processed by the pipelined render queue. The instances are copies
+// taken when the frame was executed, so they can hold their buffers until the frame is drawn
+// while the scenes own instances are used for the next frame.
+struct PipelineFrame
+{
+	std::vector<ModelInstance> instances;
+	std::vector<ModelInstance*> drawList;
+	std::vector<FrustumTest> visibility;
+	std::vector<GeometryBatch> batches;
+	JobCounter counter;
+};
+
+// This class collects the instances to be drawn this frame and draws them in batches.
+// Items are sorted by a key made of their layer, span kernel, texture and depth, so
+// neighbouring items share as much state as possible. Layers drawn back to front put the
+// depth before the kernel and texture, as the rasterizer has no depth buffer. Neighbouring
+// items with the same model and kernel are culled, transformed and drawn together. With
+// a job system set the instances of a batch are transformed at the same time, and large
+// models are split into chunks. The results are the same as transforming them serially.
+//
+// When pipelined, executing a frame processes its geometry while the frame before it is
+// drawn, so each frame is drawn one frame late. Only two frames are held at once, the
+// geometry of a frame is always finished before Execute returns, and Flush draws the
+// frame still held. The stats are of the geometry processed by the last Execute.
+class RenderQueue
+{
+	public:
+		RenderQueue(void);
+		~RenderQueue(void);
+
+		void SetLights(const std::vector<DirectionalLight*>& directionalLights, const std::vector<AmbientLight*>& ambientLights, const std::vector<PointLight*>& pointLights, const std::vector<SpotLight*>& spotLights);
+
+		void SetJobSystem(JobSystem* val);
+		JobSystem* GetJobSystem();
+
+		void SetMaxBatchSize(int val);
+		int GetMaxBatchSize();
+
+		void SetPipelineOn(bool val);
+		bool GetPipelineOn();
+
+		void Begin(Camera* camera, Rasterizer* rasterizer);
+		void Submit(ModelInstance* instance, DisplayMode mode);
+		void Execute();
+		void Flush();
+
+		unsigned int GetItemCount();
+		unsigned int GetCulledCount();
+		unsigned int GetBatchCount();
+		const RenderStats& GetStats();
+		InstanceBufferPool* GetBufferPool();
+
+	private:
+		Camera* _camera;
+		Rasterizer* _rasterizer;
+		JobSystem* _jobSystem;
+
+		std::vector<DirectionalLight*> _directionalLights;
+		std::vector<AmbientLight*> _ambientLights;
+		std::vector<PointLight*> _pointLights;
+		std::vector<SpotLight*> _spotLights;
+
+		std::vector<DrawItem> _items;
+		std::vector<BYTE*> _textures;
+		std::vector<ModelInstance*> _batch;
+		std::vector<FrustumTest> _batchVisibility;
+		InstanceBufferPool _bufferPool;
+		int _maxBatchSize;
+
+		// Frames held when pipelined, and the one the next frames geometry goes into.
+		bool _pipelineOn;
+		PipelineFrame _pipelineFrames[PIPELINE_FRAME_COUNT];
+		int _pipelineFrame;
+		PipelineFrame* _geometryFrame;
+
+		// Statistics of the last frame. Each worker counts the geometry it processes into
+		// its own stats, they are added to the frames once its geometry is finished.
+		unsigned int _culledCount;
+		unsigned int _batchCount;
+		RenderStats _stats;
+		std::vector<RenderStats> _workerStats;
+
+		RenderStats& GetWorkerStats();
+		void MergeWorkerStats();
+		unsigned int GetTextureIndex(BYTE* texture);
+		unsigned int GetBatchEnd(unsigned int first);
+		void DrawBatch(unsigned int first, unsigned int count);
+		void ExecutePipelined();
+		void DrawPipelineFrame(PipelineFrame& frame);
+		void ReleasePipelineFrame(PipelineFrame& frame);
+		void TransformInstance(ModelInstance* instance, FrustumTest visibility);
+		void RunGeometryPass(ModelInstance* instance, GeometryPass pass, int count);
+		void RunGeometryRange(ModelInstance* instance, GeometryPass pass, int begin, int end);
+
+		static void TransformBatchJob(void* data, int begin, int end);
+		static void GeometryPassJob(void* data, int begin, int end);
+		static void PipelineGeometryJob(void* data, int begin, int end);
+};
@@ -0,0 +1,49 @@
+// =========================================================================================
+//	RenderStats.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "RenderStats.h"
+
+// Constructor. Starts with every count at zero.
+RenderStats::RenderStats()
+{
+	Reset();
+}
+
+// Sets every count back to zero.
+void RenderStats::Reset()
+{
+	trianglesSubmitted = 0;
+	trianglesBackfaceCulled = 0;
+	trianglesFrustumCulled = 0;
+	trianglesClipped = 0;
+	trianglesZeroArea = 0;
+	trianglesRasterized = 0;
+
+	pixelsTested = 0;
+	pixelsShaded = 0;
+	pixelsWritten = 0;
+	texelsFetched = 0;
+	lightsEvaluated = 0;
+}
+
+// Adds the counts of another set of stats to these, used to merge the stats of each thread.
+void RenderStats::Add(const RenderStats& other)
+{
+	trianglesSubmitted += other.trianglesSubmitted;
+	trianglesBackfaceCulled += other.trianglesBackfaceCulled;
+	trianglesFrustumCulled += other.trianglesFrustumCulled;
+	trianglesClipped += other.trianglesClipped;
+	trianglesZeroArea += other.trianglesZeroArea;
+	trianglesRasterized += other.trianglesRasterized;
+
+	pixelsTested += other.pixelsTested;
+	pixelsShaded += other.pixelsShaded;
+	pixelsWritten += other.pixelsWritten;
+	texelsFetched += other.texelsFetched;
+	lightsEvaluated += other.lightsEvaluated;
+}
@@ -0,0 +1,36 @@
+// =========================================================================================
+//	RenderStats.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+
+// Counts of the work done drawing a frame. Each triangle submitted ends up in exactly one
+// of the culled, clipped, zero area or rasterized counts, except that the triangles
+// clipping generates are counted again as they are rasterized or rejected. The geometry is
+// counted by whichever thread processes it, into stats of its own that are added together
+// once the frame is done.
+struct RenderStats
+{
+	// Triangles.
+	unsigned int trianglesSubmitted;		// In the instances submitted to be drawn.
+	unsigned int trianglesBackfaceCulled;	// Facing away from the camera.
+	unsigned int trianglesFrustumCulled;	// Outside the view, alone or in an instance outside it.
+	unsigned int trianglesClipped;			// Crossing the near plane or guard band, replaced by their clipped parts.
+	unsigned int trianglesZeroArea;			// Covering no pixel centres on the screen, rejected by setup.
+	unsigned int trianglesRasterized;		// Drawn, filled or as a wireframe.
+
+	// Pixels.
+	unsigned long long pixelsTested;		// Pixel centres between the edges of each scanline, before clipping to the screen.
+	unsigned long long pixelsShaded;		// Pixels on the screen the span kernels worked out a colour for.
+	unsigned long long pixelsWritten;		// Pixels stored to the framebuffer, the shaded pixels and those cleared.
+	unsigned long long texelsFetched;		// Texture and normal map texels read.
+	unsigned long long lightsEvaluated;		// Lights worked out for each pixel by the normal mapped kernels.
+
+	RenderStats();
+
+	void Reset();
+	void Add(const RenderStats& other);
+};
@@ -0,0 +1,342 @@
+// =========================================================================================
+//	Scene.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "Scene.h"
+#include <algorithm>
+
+// This struct is used to order instances by the centre of their bounds along an axis.
+struct SortInstancesByCentre
+{
+	const std::vector<BVHBounds>* bounds;
+	int axis;
+
+	bool operator() (int lhs, int rhs) const
+	{
+		const BVHBounds& l = (*bounds)[lhs];
+		const BVHBounds& r = (*bounds)[rhs];
+		return (l.min[axis] + l.max[axis]) < (r.min[axis] + r.max[axis]);
+	}
+};
+
+// Grows a box so it contains another.
+static void ExpandBounds(BVHBounds& bounds, const BVHBounds& other)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		bounds.min[i] = min(bounds.min[i], other.min[i]);
+		bounds.max[i] = max(bounds.max[i], other.max[i]);
+	}
+}
+
+// Tests a box against a set of planes (normal x, y, z and distance).
+static FrustumTest TestBounds(const BVHBounds& bounds, const float planes[FRUSTUM_PLANE_COUNT][4])
+{
+	FrustumTest result = FrustumInside;
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		const float* plane = planes[i];
+
+		// Work out the distance of the corners furthest inside and furthest outside the plane.
+		float inside = plane[3];
+		float outside = plane[3];
+		for (int j = 0; j < 3; j++)
+		{
+			if (plane[j] >= 0)
+			{
+				inside += plane[j] * bounds.max[j];
+				outside += plane[j] * bounds.min[j];
+			}
+			else
+			{
+				inside += plane[j] * bounds.min[j];
+				outside += plane[j] * bounds.max[j];
+			}
+		}
+
+		if (inside < 0)
+			return FrustumOutside;
+		if (outside < 0)
+			result = FrustumIntersecting;
+	}
+	return result;
+}
+
+// Constructor.
+Scene::Scene(void)
+{
+	_movedInstanceCount = 0;
+	_rebuildNeeded = false;
+}
+
+// Destructor.
+Scene::~Scene(void)
+{
+	Clear();
+}
+
+// Adds an instance of a model to the scene and returns its index. The 
+// hierarchy is rebuilt on the next update.
+int Scene::AddInstance(Model3D* model, const Matrix3D& transform)
+{
+	_instances.push_back(new ModelInstance(model, transform));
+	_instanceBounds.push_back(BVHBounds());
+	_instanceLeaves.push_back(-1);
+
+	int index = _instances.size() - 1;
+	UpdateInstanceBounds(index);
+	_rebuildNeeded = true;
+
+	return index;
+}
+
+// Accessor methods.
+ModelInstance* Scene::GetInstance(int index)
+{
+	return _instances[index];
+}
+unsigned int Scene::GetInstanceCount()
+{
+	return _instances.size();
+}
+unsigned int Scene::GetNodeCount()
+{
+	return _nodes.size();
+}
+
+// Moves an instance. The hierarchy is refitted (or rebuilt) on the next update.
+void Scene::SetInstanceTransform(int index, const Matrix3D& transform)
+{
+	_instances[index]->SetTransform(transform);
+	UpdateInstanceBounds(index);
+
+	_movedInstanceCount++;
+
+	int leaf = _instanceLeaves[index];
+	if (leaf >= 0 && _nodes[leaf].dirty == false)
+	{
+		_nodes[leaf].dirty = true;
+		_dirtyLeaves.push_back(leaf);
+	}
+}
+
+// Removes and deletes every instance in the scene.
+void Scene::Clear()
+{
+	for (unsigned int i = 0; i < _instances.size(); i++)
+		delete _instances[i];
+
+	_instances.clear();
+	_instanceBounds.clear();
+	_instanceLeaves.clear();
+	_dirtyLeaves.clear();
+	_movedInstanceCount = 0;
+	_nodes.clear();
+	_instanceOrder.clear();
+	_rebuildNeeded = false;
+}
+
+// Brings the hierarchy up to date with any instances that have been added or moved. If 
+// only a few instances have moved the boxes on their path to the root are refitted, 
+// otherwise the whole hierarchy is rebuilt.
+void Scene::Update()
+{
+	if (_rebuildNeeded == true || _movedInstanceCount > _instances.size() * BVH_REBUILD_FRACTION)
+		Rebuild();
+	else if (_dirtyLeaves.size() > 0)
+		Refit();
+}
+
+// Rebuilds the hierarchy from scratch, splitting each node at the median instance
+// along the longest axis of the node.
+void Scene::Rebuild()
+{
+	_nodes.clear();
+	_dirtyLeaves.clear();
+	_movedInstanceCount = 0;
+	_rebuildNeeded = false;
+
+	_instanceOrder.resize(_instances.size());
+	for (unsigned int i = 0; i < _instances.size(); i++)
+		_instanceOrder[i] = i;
+
+	if (_instances.size() == 0)
+		return;
+
+	// A binary tree with leaves of at least half the maximum size never needs more than this.
+	_nodes.reserve((_instances.size() / (BVH_MAX_LEAF_INSTANCES / 2) + 1) * 2);
+
+	BVHNode root;
+	root.parent = -1;
+	_nodes.push_back(root);
+	BuildNode(0, 0, _instances.size());
+}
+
+// Builds a node of the hierarchy that contains the given range of the instance order.
+void Scene::BuildNode(int nodeIndex, int first, int count)
+{
+	// Work out the box that contains every instance in the node.
+	BVHBounds bounds = _instanceBounds[_instanceOrder[first]];
+	for (int i = first + 1; i < first + count; i++)
+		ExpandBounds(bounds, _instanceBounds[_instanceOrder[i]]);
+
+	_nodes[nodeIndex].bounds = bounds;
+	_nodes[nodeIndex].dirty = false;
+
+	if (count <= BVH_MAX_LEAF_INSTANCES)
+	{
+		_nodes[nodeIndex].left = -1;
+		_nodes[nodeIndex].first = first;
+		_nodes[nodeIndex].count = count;
+		for (int i = first; i < first + count; i++)
+			_instanceLeaves[_instanceOrder[i]] = nodeIndex;
+		return;
+	}
+
+	// Split the instances in half along the longest axis of the node.
+	int axis = 0;
+	float longest = bounds.max[0] - bounds.min[0];
+	for (int i = 1; i < 3; i++)
+	{
+		if (bounds.max[i] - bounds.min[i] > longest)
+		{
+			longest = bounds.max[i] - bounds.min[i];
+			axis = i;
+		}
+	}
+
+	SortInstancesByCentre sorter;
+	sorter.bounds = &_instanceBounds;
+	sorter.axis = axis;
+	int half = count / 2;
+	std::nth_element(_instanceOrder.begin() + first, _instanceOrder.begin() + first + half, _instanceOrder.begin() + first + count, sorter);
+
+	// Children are stored next to each other, after their parent.
+	int left = _nodes.size();
+	BVHNode child;
+	child.parent = nodeIndex;
+	_nodes.push_back(child);
+	_nodes.push_back(child);
+
+	_nodes[nodeIndex].left = left;
+	_nodes[nodeIndex].first = 0;
+	_nodes[nodeIndex].count = 0;
+
+	BuildNode(left, first, half);
+	BuildNode(left + 1, first + half, count - half);
+}
+
+// Refits the boxes of the leaves holding the instances that have moved, and each of their
+// parents. Children are always stored after their parents, so walking the nodes backwards
+// refits every child before its parent.
+void Scene::Refit()
+{
+	// Mark the path from each leaf holding a moved instance up to the root.
+	for (unsigned int i = 0; i < _dirtyLeaves.size(); i++)
+	{
+		int node = _nodes[_dirtyLeaves[i]].parent;
+		while (node >= 0 && _nodes[node].dirty == false)
+		{
+			_nodes[node].dirty = true;
+			node = _nodes[node].parent;
+		}
+	}
+	_dirtyLeaves.clear();
+	_movedInstanceCount = 0;
+
+	for (int i = _nodes.size() - 1; i >= 0; i--)
+	{
+		BVHNode& node = _nodes[i];
+		if (node.dirty == false)
+			continue;
+
+		if (node.count > 0)
+		{
+			node.bounds = _instanceBounds[_instanceOrder[node.first]];
+			for (int j = node.first + 1; j < node.first + node.count; j++)
+				ExpandBounds(node.bounds, _instanceBounds[_instanceOrder[j]]);
+		}
+		else
+		{
+			node.bounds = _nodes[node.left].bounds;
+			ExpandBounds(node.bounds, _nodes[node.left + 1].bounds);
+		}
+		node.dirty = false;
+	}
+}
+
+// Finds every instance whose bounds are at least partly inside the view of the given camera.
+// Once a node is found to be entirely inside the view nothing below it is tested again.
+void Scene::QueryFrustum(Camera* camera, std::vector<ModelInstance*>& visible)
+{
+	visible.clear();
+	if (_nodes.size() == 0)
+		return;
+
+	float planes[FRUSTUM_PLANE_COUNT][4];
+	for (int i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+	{
+		const FrustumPlane& plane = camera->GetFrustumPlane(i);
+		planes[i][0] = plane.normal.GetX();
+		planes[i][1] = plane.normal.GetY();
+		planes[i][2] = plane.normal.GetZ();
+		planes[i][3] = plane.distance;
+	}
+
+	// Walk the tree with a stack of nodes, and whether they are known to be inside the view.
+	int stack[64];
+	bool stackInside[64];
+	int stackSize = 0;
+	stack[stackSize] = 0;
+	stackInside[stackSize++] = false;
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		const BVHNode& node = _nodes[stack[stackSize]];
+		bool inside = stackInside[stackSize];
+
+		if (inside == false)
+		{
+			FrustumTest result = TestBounds(node.bounds, planes);
+			if (result == FrustumOutside)
+				continue;
+			inside = (result == FrustumInside);
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int instance = _instanceOrder[i];
+				if (inside == true || TestBounds(_instanceBounds[instance], planes) != FrustumOutside)
+					visible.push_back(_instances[instance]);
+			}
+			continue;
+		}
+
+		stack[stackSize] = node.left;
+		stackInside[stackSize++] = inside;
+		stack[stackSize] = node.left + 1;
+		stackInside[stackSize++] = inside;
+	}
+}
+
+// Copies the world bounds of an instance into the flat bounds list used by the hierarchy.
+void Scene::UpdateInstanceBounds(int index)
+{
+	Vector3D worldMin, worldMax;
+	_instances[index]->GetWorldAABB(worldMin, worldMax);
+
+	BVHBounds& bounds = _instanceBounds[index];
+	bounds.min[0] = worldMin.GetX();
+	bounds.min[1] = worldMin.GetY();
+	bounds.min[2] = worldMin.GetZ();
+	bounds.max[0] = worldMax.GetX();
+	bounds.max[1] = worldMax.GetY();
+	bounds.max[2] = worldMax.GetZ();
+}
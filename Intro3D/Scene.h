@@ -0,0 +1,75 @@
+// =========================================================================================
+//	Scene.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "ModelInstance.h"
+#include "Camera.h"
+#include <vector>
+
+// Most instances stored in a single leaf of the bounding volume hierarchy.
+#define BVH_MAX_LEAF_INSTANCES	4
+
+// Fraction of the instances that can move in one update before the hierarchy is
+// rebuilt rather than refitted. Refitting keeps the tree shape, so it gets looser
+// the more instances move.
+#define BVH_REBUILD_FRACTION	0.25f
+
+// An axis aligned box stored as plain floats, so the hierarchy is quick to walk.
+struct BVHBounds
+{
+	float min[3];
+	float max[3];
+};
+
+// A node of the bounding volume hierarchy. Internal nodes have two children stored
+// next to each other, leaves reference a range of the scenes instance order.
+struct BVHNode
+{
+	BVHBounds bounds;
+	int parent;
+	int left;		// Index of the first child, the second follows it. -1 for leaves.
+	int first;		// Index of the first instance in the instance order, for leaves.
+	int count;		// Number of instances in the leaf, 0 for internal nodes.
+	bool dirty;		// Needs refitting.
+};
+
+// This class holds every model instance in the scene, and a bounding volume hierarchy 
+// over them used to quickly find the instances inside the view of a camera.
+class Scene
+{
+	public:
+		Scene(void);
+		~Scene(void);
+
+		int AddInstance(Model3D* model, const Matrix3D& transform);
+		ModelInstance* GetInstance(int index);
+		unsigned int GetInstanceCount();
+		void SetInstanceTransform(int index, const Matrix3D& transform);
+		void Clear();
+
+		void Update();
+		void Rebuild();
+		void Refit();
+
+		void QueryFrustum(Camera* camera, std::vector<ModelInstance*>& visible);
+
+		unsigned int GetNodeCount();
+
+	private:
+		std::vector<ModelInstance*> _instances;
+		std::vector<BVHBounds> _instanceBounds;
+		std::vector<int> _instanceLeaves;
+		std::vector<int> _dirtyLeaves;
+		unsigned int _movedInstanceCount;
+		bool _rebuildNeeded;
+
+		std::vector<BVHNode> _nodes;
+		std::vector<int> _instanceOrder;
+
+		void UpdateInstanceBounds(int index);
+		void BuildNode(int nodeIndex, int first, int count);
+};
@@ -0,0 +1,87 @@
+// =========================================================================================
+//	SwapChain.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "SwapChain.h"
+
+// No-Argument Constructor. Declared private, should not get called.
+SwapChain::SwapChain(void)
+{
+}
+
+// Constructor. Creates the frame buffers with the given width and height.
+SwapChain::SwapChain(unsigned int width, unsigned int height)
+{
+	for (int i = 0; i < SWAP_CHAIN_BUFFER_COUNT; i++)
+	{
+		_bitmaps[i] = new Gdiplus::Bitmap(width, height, PixelFormat32bppARGB);
+		_graphics[i] = new Gdiplus::Graphics(_bitmaps[i]);
+		_graphics[i]->Clear(Gdiplus::Color::Black);
+	}
+
+	_renderIndex = 0;
+	_readyIndex = 1;
+	_presentIndex = 2;
+	_framesCompleted = 0;
+	_framesPresented = 0;
+}
+
+// Destructor. Neither side can be using the buffers once this is called.
+SwapChain::~SwapChain(void)
+{
+	for (int i = 0; i < SWAP_CHAIN_BUFFER_COUNT; i++)
+	{
+		delete _graphics[i];
+		delete _bitmaps[i];
+	}
+}
+
+// Accessor methods. The render buffer must only be used by the renderer, and the present
+// buffer only by the presenter.
+Gdiplus::Bitmap* SwapChain::GetRenderBitmap()
+{
+	return _bitmaps[_renderIndex];
+}
+Gdiplus::Graphics* SwapChain::GetRenderGraphics()
+{
+	return _graphics[_renderIndex];
+}
+Gdiplus::Bitmap* SwapChain::GetPresentBitmap()
+{
+	return _bitmaps[_presentIndex];
+}
+unsigned int SwapChain::GetFramesCompleted()
+{
+	return _framesCompleted;
+}
+unsigned int SwapChain::GetFramesPresented()
+{
+	return _framesPresented;
+}
+
+// Called by the renderer once it has finished drawing into the render buffer. The buffer
+// becomes the ready buffer, and the renderer carries on with the one it replaced.
+void SwapChain::CompleteFrame()
+{
+	int previous = _readyIndex.exchange(_renderIndex | SWAP_CHAIN_NEW_FRAME);
+	_renderIndex = previous & SWAP_CHAIN_INDEX_MASK;
+	_framesCompleted++;
+}
+
+// Called by the presenter to take the latest completed frame as the present buffer. 
+// Returns false, keeping the present buffer as it is, if no new frame has completed.
+bool SwapChain::AcquireFrame()
+{
+	if ((_readyIndex & SWAP_CHAIN_NEW_FRAME) == 0)
+		return false;
+
+	// Only the presenter clears the flag, so the ready buffer is still new here.
+	int previous = _readyIndex.exchange(_presentIndex);
+	_presentIndex = previous & SWAP_CHAIN_INDEX_MASK;
+	_framesPresented++;
+	return true;
+}
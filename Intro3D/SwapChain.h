@@ -0,0 +1,55 @@
+// =========================================================================================
+//	SwapChain.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include <atomic>
+
+// Number of frame buffers in the swap chain, one being rendered, one being presented
+// and one holding the latest completed frame.
+#define SWAP_CHAIN_BUFFER_COUNT		3
+
+// Set in the ready index when the frame it holds has not been presented yet.
+#define SWAP_CHAIN_NEW_FRAME		4
+#define SWAP_CHAIN_INDEX_MASK		3
+
+// This class holds the triple buffered frames passed from the renderer to the presenter.
+// The renderer draws into its buffer then swaps it with the ready buffer, the presenter
+// swaps its buffer with the ready one whenever a new frame is there. Both swaps are a
+// single atomic exchange, so neither side ever waits on the other. Frames completed
+// faster than they are presented are dropped, the presenter always gets the latest.
+class SwapChain
+{
+	public:
+		SwapChain(unsigned int width, unsigned int height);
+		~SwapChain(void);
+
+		Gdiplus::Bitmap* GetRenderBitmap();
+		Gdiplus::Graphics* GetRenderGraphics();
+		Gdiplus::Bitmap* GetPresentBitmap();
+
+		unsigned int GetFramesCompleted();
+		unsigned int GetFramesPresented();
+
+		void CompleteFrame();
+		bool AcquireFrame();
+
+	private:
+		Gdiplus::Bitmap* _bitmaps[SWAP_CHAIN_BUFFER_COUNT];
+		Gdiplus::Graphics* _graphics[SWAP_CHAIN_BUFFER_COUNT];
+
+		// Buffer only the renderer uses, buffer only the presenter uses, and the buffer 
+		// passed between them.
+		int _renderIndex;
+		int _presentIndex;
+		std::atomic<int> _readyIndex;
+
+		std::atomic<unsigned int> _framesCompleted;
+		std::atomic<unsigned int> _framesPresented;
+
+		// Private constructor. Should not be used directly.
+		SwapChain(void);
+};
@@ -75,6 +75,38 @@ Vector3D Vertex::GetVector(Vertex v1, Vertex v2)
 					v2.GetZ() - v1.GetZ());
 }
 
+// Linearly interpolates every value of 2 vertexs, t is the distance from v1 (0) to v2 (1).
+Vertex Vertex::Interpolate(Vertex v1, Vertex v2, float t)
+{
+	Gdiplus::Color color1 = v1.GetColor();
+	Gdiplus::Color color2 = v2.GetColor();
+	Vector3D normal1 = v1.GetNormal();
+	Vector3D normal2 = v2.GetNormal();
+	UVCoordinate uvCoord1 = v1.GetUVCoordinate();
+	UVCoordinate uvCoord2 = v2.GetUVCoordinate();
+
+	Vertex result = Vertex(v1.GetX() + ((v2.GetX() - v1.GetX()) * t),
+						   v1.GetY() + ((v2.GetY() - v1.GetY()) * t),
+						   v1.GetZ() + ((v2.GetZ() - v1.GetZ()) * t),
+						   v1.GetW() + ((v2.GetW() - v1.GetW()) * t),
+						   Gdiplus::Color((BYTE)(color1.GetR() + ((color2.GetR() - color1.GetR()) * t)),
+										  (BYTE)(color1.GetG() + ((color2.GetG() - color1.GetG()) * t)),
+										  (BYTE)(color1.GetB() + ((color2.GetB() - color1.GetB()) * t))),
+						   Vector3D(normal1.GetX() + ((normal2.GetX() - normal1.GetX()) * t),
+									normal1.GetY() + ((normal2.GetY() - normal1.GetY()) * t),
+									normal1.GetZ() + ((normal2.GetZ() - normal1.GetZ()) * t)),
+						   v1.GetNormalCount());
+	result.SetPreTransformZ(v1.GetPreTransformZ() + ((v2.GetPreTransformZ() - v1.GetPreTransformZ()) * t));
+
+	UVCoordinate uvCoord;
+	uvCoord.U = uvCoord1.U + ((uvCoord2.U - uvCoord1.U) * t);
+	uvCoord.V = uvCoord1.V + ((uvCoord2.V - uvCoord1.V) * t);
+	uvCoord.Z = uvCoord1.Z + ((uvCoord2.Z - uvCoord1.Z) * t);
+	result.SetUVCoordinate(uvCoord);
+
+	return result;
+}
+
 // Copys the value of this vertex to another.
 void Vertex::Copy(const Vertex& v)
 {	
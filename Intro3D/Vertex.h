@@ -40,6 +40,7 @@ class Vertex : public Point3D
 		const int GetNormalCount();
 
 		static Vector3D GetVector(Vertex v1, Vertex v2);
+		static Vertex Interpolate(Vertex v1, Vertex v2, float t);
 
 	private:
 
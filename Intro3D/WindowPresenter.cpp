@@ -0,0 +1,32 @@
+// =========================================================================================
+//	WindowPresenter.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "StdAfx.h"
+#include "WindowPresenter.h"
+
+// No-Argument Constructor. Declared private, should not get called.
+WindowPresenter::WindowPresenter(void)
+{
+	_hWnd = NULL;
+}
+
+// Constructor. Presents frames to the given window.
+WindowPresenter::WindowPresenter(HWND hWnd)
+{
+	_hWnd = hWnd;
+}
+
+// Destructor.
+WindowPresenter::~WindowPresenter(void)
+{
+}
+
+// Tells Windows the window needs painting with the new frame.
+void WindowPresenter::Present(Gdiplus::Bitmap*)
+{
+	InvalidateRect(_hWnd, NULL, FALSE);
+}
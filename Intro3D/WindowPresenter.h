@@ -0,0 +1,26 @@
+// =========================================================================================
+//	WindowPresenter.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include "Presenter.h"
+
+// This presenter shows each frame in a window. Presenting only tells Windows the window
+// needs painting, the app engine copies the frame to it when it handles WM_PAINT.
+class WindowPresenter : public Presenter
+{
+	public:
+		WindowPresenter(HWND hWnd);
+		~WindowPresenter(void);
+
+		void Present(Gdiplus::Bitmap* frame);
+
+	private:
+		HWND _hWnd;
+
+		// Private constructor. Should not be used directly.
+		WindowPresenter(void);
+};
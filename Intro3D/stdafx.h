@@ -24,6 +24,7 @@
 
 #include <malloc.h>
 #include <memory.h>
+#include <limits.h>
 #include <tchar.h>
 
 #include <GdiPlus.h>
@@ -36,6 +37,22 @@
 #include "Matrix3D.h"
 #include "Polygon3D.h"
 #include "Model3D.h"
+#include "RenderStats.h"
+#include "InstanceBufferPool.h"
+#include "ModelInstance.h"
+#include "Scene.h"
+#include "RenderQueue.h"
+#include "JobSystem.h"
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "SwapChain.h"
+#include "Presenter.h"
+#include "NullPresenter.h"
+#include "FilePresenter.h"
+#include "WindowPresenter.h"
+#include "FrameCapture.h"
+#include "OfflineRenderer.h"
 #include "MD2Loader.h"
 #include "Camera.h"
 #include "Light.h"
@@ -0,0 +1,209 @@
+// =========================================================================================
+//	Benchmark.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// Only benchmarks whose names contain this are run, if it is not empty.
+static std::string BenchmarkFilter;
+
+// Whether the timers read the hardware counters, and the counts of the timers read since
+// the counts were last taken.
+static bool BenchmarkCountersOn = false;
+static PerfCounterValues BenchmarkCounters;
+
+// Starts timing.
+void BenchmarkTimer::Start()
+{
+	if (BenchmarkCountersOn == true)
+		PerfCounters::Read(_startCounters);
+	_start = std::chrono::high_resolution_clock::now();
+}
+
+// Returns the number of milliseconds since Start was called.
+double BenchmarkTimer::GetElapsedMilliseconds()
+{
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - _start;
+
+	if (BenchmarkCountersOn == true)
+	{
+		PerfCounterValues counters;
+		PerfCounters::Read(counters);
+		counters.Subtract(_startCounters);
+		BenchmarkCounters.Add(counters);
+	}
+	return elapsed.count();
+}
+
+// Turns the counters on or off, they stay off if they are not supported.
+void SetBenchmarkCountersOn(bool val)
+{
+	BenchmarkCountersOn = (val == true && PerfCounters::GetSupported() == true);
+	BenchmarkCounters.Reset();
+}
+bool GetBenchmarkCountersOn()
+{
+	return BenchmarkCountersOn;
+}
+
+// Returns the counts since they were last taken.
+void TakeBenchmarkCounters(PerfCounterValues& values)
+{
+	values = BenchmarkCounters;
+	BenchmarkCounters.Reset();
+}
+
+// Prints the counts per 1000 units of work, counters that are not available are left out.
+void PrintBenchmarkCounters(const PerfCounterValues& values, double units, const char* unitName)
+{
+	if (units <= 0)
+		return;
+
+	std::string line = "   ";
+	char text[64];
+	if (PerfCounters::GetCounterAvailable(PerfCounterCycles) == true && PerfCounters::GetCounterAvailable(PerfCounterInstructions) == true)
+	{
+		sprintf(text, " %.2f IPC,", values.GetInstructionsPerCycle());
+		line += text;
+	}
+	sprintf(text, " per 1000 %s:", unitName);
+	line += text;
+
+	const char* names[PERF_COUNTER_COUNT] = { "cycles", "instructions", "L1D misses", "LLC misses", "branch misses" };
+	bool first = true;
+	for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+	{
+		if (PerfCounters::GetCounterAvailable((PerfCounter)i) == false)
+			continue;
+		sprintf(text, "%s %.1f %s", first ? "" : ",", values.counts[i] * 1000.0 / units, names[i]);
+		line += text;
+		first = false;
+	}
+	printf("%s\n", line.c_str());
+}
+
+// Constructor. Sets the lights up as the demo does.
+BenchmarkLights::BenchmarkLights() : pointLight(Color(0, 0, 255), 0, 0.1f, 0)
+{
+	directionalLight.SetPosition(Vertex(500, 150, 50, 1, Gdiplus::Color::Red, Vector3D(0,0,0), 0));
+	directionalLight.SetIntensity(Color(255, 0, 0));
+	directionalLight.SetEnabled(true);
+
+	ambientLight.SetIntensity(Color(100, 100, 100));
+	ambientLight.SetEnabled(true);
+
+	pointLight.SetPosition(Vertex(-500, 150, 10, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0));
+	pointLight.SetEnabled(false);
+
+	directionalLights.push_back(&directionalLight);
+	ambientLights.push_back(&ambientLight);
+	pointLights.push_back(&pointLight);
+}
+
+// Builds a screen space vertex with a texture coordinate.
+Vertex MakeBenchmarkVertex(float x, float y, float z, Gdiplus::Color color, float u, float v)
+{
+	Vertex vert = Vertex(x, y, z, 1, color, Vector3D(0.3f, 0.5f, -0.8f), 1);
+
+	UVCoordinate uvCoord;
+	uvCoord.U = u;
+	uvCoord.V = v;
+	uvCoord.Z = 0;
+	vert.SetUVCoordinate(uvCoord);
+
+	return vert;
+}
+
+// Returns true if the benchmark should be run.
+bool IsBenchmarkSelected(const char* name)
+{
+	return BenchmarkFilter.empty() == true || strstr(name, BenchmarkFilter.c_str()) != NULL;
+}
+
+// Prints the result of a benchmark.
+void ReportBenchmark(const char* name, int iterations, double milliseconds, double units, const char* unitName)
+{
+	double perIteration = milliseconds / iterations;
+	double perSecond = (milliseconds > 0) ? (units / (milliseconds / 1000.0)) : 0;
+
+	printf("%-40s %10d iterations %12.4f ms/iteration %14.2f M%s/s\n", name, iterations, perIteration, perSecond / 1000000.0, unitName);
+
+	if (BenchmarkCountersOn == true)
+	{
+		PerfCounterValues counters;
+		TakeBenchmarkCounters(counters);
+		PrintBenchmarkCounters(counters, units, unitName);
+	}
+}
+
+// Prints how the benchmarks are run.
+static void PrintUsage()
+{
+	printf("Usage: Intro3DBench [--filter <text>] [--report <file.csv>] [--counters] [group ...]\n");
+	printf("\n");
+	printf("  Groups: kernel, micro, scene, instance, job, displaymode. Every group is run if\n");
+	printf("  none are given. Only benchmarks whose names contain the filter are run, for\n");
+	printf("  example --filter Micro/Fill/Flat. The display mode results are also written to\n");
+	printf("  the report file. --counters reads the hardware performance counters around each\n");
+	printf("  benchmark and reports the instructions per cycle and misses per unit of work.\n");
+}
+
+// Entry point, runs the benchmark groups named on the command line, or every group.
+int main(int argc, char* argv[])
+{
+	const char* reportFilename = NULL;
+	bool countersOn = false;
+	std::vector<std::string> groups;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+			reportFilename = argv[++i];
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			BenchmarkFilter = argv[++i];
+		else if (strcmp(argv[i], "--counters") == 0)
+			countersOn = true;
+		else if (argv[i][0] != '-')
+			groups.push_back(argv[i]);
+		else
+		{
+			PrintUsage();
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+	bool runAll = groups.size() == 0;
+
+	// Benchmarks still run without the counters when they cannot be read.
+	if (countersOn == true)
+	{
+		SetBenchmarkCountersOn(true);
+		if (GetBenchmarkCountersOn() == false)
+			printf("Hardware counters unavailable, %s.\n\n", PerfCounters::GetUnsupportedReason());
+	}
+
+	Gdiplus::GdiplusStartupInput gdiStartupInput;
+	ULONG_PTR gdiToken;
+	Gdiplus::GdiplusStartup(&gdiToken, &gdiStartupInput, NULL);
+
+	if (runAll == true || std::find(groups.begin(), groups.end(), "kernel") != groups.end())
+		RunKernelBenchmarks();
+	if (runAll == true || std::find(groups.begin(), groups.end(), "micro") != groups.end())
+		RunMicroBenchmarks();
+	if (runAll == true || std::find(groups.begin(), groups.end(), "scene") != groups.end())
+		RunSceneBenchmarks();
+	if (runAll == true || std::find(groups.begin(), groups.end(), "instance") != groups.end())
+		RunInstanceBenchmarks();
+	if (runAll == true || std::find(groups.begin(), groups.end(), "job") != groups.end())
+		RunJobBenchmarks();
+	if (runAll == true || std::find(groups.begin(), groups.end(), "displaymode") != groups.end())
+		RunDisplayModeBenchmarks(reportFilename);
+
+	Gdiplus::GdiplusShutdown(gdiToken);
+	return 0;
+}
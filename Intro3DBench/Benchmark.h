@@ -0,0 +1,71 @@
+// =========================================================================================
+//	Benchmark.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include <chrono>
+#include <vector>
+
+// This is a simple high resolution timer used to time each benchmark. With the counters
+// on it also reads the hardware counters of the calling thread, and each read of the
+// elapsed time adds the counts since Start to the counts taken by the next report.
+class BenchmarkTimer
+{
+	public:
+		void Start();
+		double GetElapsedMilliseconds();
+
+	private:
+		std::chrono::high_resolution_clock::time_point _start;
+		PerfCounterValues _startCounters;
+};
+
+// Lights set up the same as the demo lights, see OfflineRenderer::AddDemoLights, and the
+// lists the lighting and the rasterizer take them in. The point light starts disabled, the
+// benchmarks that use it turn it on.
+struct BenchmarkLights
+{
+	BenchmarkLights();
+
+	DirectionalLight directionalLight;
+	AmbientLight ambientLight;
+	PointLight pointLight;
+
+	std::vector<DirectionalLight*> directionalLights;
+	std::vector<AmbientLight*> ambientLights;
+	std::vector<PointLight*> pointLights;
+};
+
+// Builds a screen space vertex ready to be passed to the span kernels.
+Vertex MakeBenchmarkVertex(float x, float y, float z, Gdiplus::Color color, float u, float v);
+
+// Returns true if the benchmark with the given name should be run, that is if no filter
+// was given on the command line or the name contains the filter.
+bool IsBenchmarkSelected(const char* name);
+
+// Prints the result of a benchmark. Units is the number of units of work
+// done (pixels, triangles, etc) and is reported per second. With the counters on, the
+// counts of the timers read since the last report are also printed per unit of work.
+void ReportBenchmark(const char* name, int iterations, double milliseconds, double units, const char* unitName);
+
+// Turns reading the hardware counters in the benchmark timers on or off, see PerfCounters.
+// Only the thread running the benchmarks is counted, not the workers of a job system.
+void SetBenchmarkCountersOn(bool val);
+bool GetBenchmarkCountersOn();
+
+// Returns the counts of the timers read since they were last taken, and starts again.
+void TakeBenchmarkCounters(PerfCounterValues& values);
+
+// Prints the instructions per cycle and the counts per 1000 units of work.
+void PrintBenchmarkCounters(const PerfCounterValues& values, double units, const char* unitName);
+
+// Benchmark groups.
+void RunKernelBenchmarks();
+void RunSceneBenchmarks();
+void RunInstanceBenchmarks();
+void RunMicroBenchmarks();
+void RunJobBenchmarks();
+void RunDisplayModeBenchmarks(const char* reportFilename);
@@ -0,0 +1,157 @@
+// =========================================================================================
+//	DisplayModeBenchmarks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include <vector>
+#include <algorithm>
+
+// Frames rendered before timing starts, so the caches and buffer pool are warm, and the
+// frames timed after them.
+#define DISPLAY_MODE_BENCHMARK_WARMUP		10
+#define DISPLAY_MODE_BENCHMARK_FRAMES		100
+
+// Returns the time taken by the frame at the given percentile of the sorted frame times,
+// by the nearest rank.
+static double GetPercentile(const std::vector<double>& sortedTimes, double percentile)
+{
+	int rank = (int)ceil((percentile / 100.0) * sortedTimes.size());
+	rank = min(max(rank, 1), (int)sortedTimes.size());
+	return sortedTimes[rank - 1];
+}
+
+// Writes the counter columns of a row of the report, the columns of counters that were
+// not read are left empty.
+static void WriteCounterColumns(FILE* report, const PerfCounterValues& counters, double pixels)
+{
+	bool counted = (GetBenchmarkCountersOn() == true && pixels > 0);
+
+	if (counted == true && PerfCounters::GetCounterAvailable(PerfCounterCycles) == true &&
+		PerfCounters::GetCounterAvailable(PerfCounterInstructions) == true)
+		fprintf(report, ",%.4f", counters.GetInstructionsPerCycle());
+	else
+		fprintf(report, ",");
+
+	PerfCounter perPixel[] = { PerfCounterCycles, PerfCounterL1DMisses, PerfCounterLLCMisses, PerfCounterBranchMisses };
+	for (unsigned int i = 0; i < sizeof(perPixel) / sizeof(perPixel[0]); i++)
+	{
+		if (counted == true && PerfCounters::GetCounterAvailable(perPixel[i]) == true)
+			fprintf(report, ",%.4f", counters.counts[perPixel[i]] / pixels);
+		else
+			fprintf(report, ",");
+	}
+	fprintf(report, "\n");
+}
+
+// Renders the demonstration scene end to end in every display mode, at several resolutions,
+// without a window. Each frame is timed on its own, including the clear, so the report has
+// the mean, median and 99th percentile frame times of each mode. The camera orbits the
+// scene so the timed frames cover it from every side. The render stats of each mode are
+// reported per frame, and with the counters on so are the instructions per cycle and the
+// counts per pixel shaded. If a report filename is given, the results are also written to
+// it as comma separated values.
+void RunDisplayModeBenchmarks(const char* reportFilename)
+{
+	int resolutions[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+
+	FILE* report = NULL;
+	if (reportFilename != NULL)
+	{
+		report = fopen(reportFilename, "w");
+		if (report == NULL)
+			printf("Could not open %s, the display mode report will not be written.\n", reportFilename);
+		else
+			fprintf(report, "width,height,mode,frames,mean_ms,p50_ms,p99_ms,triangles_per_s,pixels_per_s,"
+							"triangles_submitted,triangles_backface_culled,triangles_frustum_culled,triangles_clipped,"
+							"triangles_zero_area,triangles_rasterized,pixels_tested,pixels_shaded,pixels_written,"
+							"texels_fetched,lights_evaluated,ipc,cycles_per_pixel,l1d_misses_per_pixel,"
+							"llc_misses_per_pixel,branch_misses_per_pixel\n");
+	}
+
+	for (unsigned int i = 0; i < sizeof(resolutions) / sizeof(resolutions[0]); i++)
+	{
+		int width = resolutions[i][0];
+		int height = resolutions[i][1];
+
+		OfflineRenderer renderer(width, height);
+		if (renderer.LoadDemoModels() == false)
+		{
+			printf("Display mode benchmarks skipped, could not load the demonstration models.\n");
+			break;
+		}
+		renderer.AddDemoLights();
+		renderer.SetCameraPath(CameraPathOrbit);
+
+		for (int mode = 0; mode < DISPLAY_MODE_COUNT; mode++)
+		{
+			char name[128];
+			sprintf(name, "Frame/%dx%d/%s", width, height, OfflineRenderer::GetDisplayModeName((DisplayMode)mode));
+			if (IsBenchmarkSelected(name) == false)
+				continue;
+
+			renderer.SetDisplayMode((DisplayMode)mode);
+			for (int frame = 0; frame < DISPLAY_MODE_BENCHMARK_WARMUP; frame++)
+				renderer.RenderFrame(frame);
+
+			// Leave out anything counted before the timed frames.
+			PerfCounterValues counters;
+			TakeBenchmarkCounters(counters);
+
+			std::vector<double> times;
+			double totalMilliseconds = 0;
+			RenderStats totals;
+			BenchmarkTimer timer;
+			for (int frame = 0; frame < DISPLAY_MODE_BENCHMARK_FRAMES; frame++)
+			{
+				timer.Start();
+				renderer.RenderFrame(frame);
+				double milliseconds = timer.GetElapsedMilliseconds();
+
+				times.push_back(milliseconds);
+				totalMilliseconds += milliseconds;
+				totals.Add(renderer.GetStats());
+			}
+			std::sort(times.begin(), times.end());
+			TakeBenchmarkCounters(counters);
+
+			double mean = totalMilliseconds / DISPLAY_MODE_BENCHMARK_FRAMES;
+			double p50 = GetPercentile(times, 50.0);
+			double p99 = GetPercentile(times, 99.0);
+			double seconds = totalMilliseconds / 1000.0;
+			double trianglesPerSecond = (seconds > 0) ? totals.trianglesRasterized / seconds : 0;
+			double pixelsPerSecond = (seconds > 0) ? totals.pixelsShaded / seconds : 0;
+
+			printf("%-64s %8.3f ms mean %8.3f ms p50 %8.3f ms p99 %8.2f Mtriangles/s %8.2f Mpixels/s\n",
+				   name, mean, p50, p99, trianglesPerSecond / 1000000.0, pixelsPerSecond / 1000000.0);
+
+			// Per frame stats, the same for every run as the frames are the same.
+			int frames = DISPLAY_MODE_BENCHMARK_FRAMES;
+			printf("    %u submitted, %u backface, %u frustum, %u clipped, %u zero area, %u rasterized triangles/frame\n",
+				   totals.trianglesSubmitted / frames, totals.trianglesBackfaceCulled / frames, totals.trianglesFrustumCulled / frames,
+				   totals.trianglesClipped / frames, totals.trianglesZeroArea / frames, totals.trianglesRasterized / frames);
+			printf("    %llu tested, %llu shaded, %llu written pixels/frame, %llu texels/frame, %llu lights/frame\n",
+				   totals.pixelsTested / frames, totals.pixelsShaded / frames, totals.pixelsWritten / frames,
+				   totals.texelsFetched / frames, totals.lightsEvaluated / frames);
+			if (GetBenchmarkCountersOn() == true)
+				PrintBenchmarkCounters(counters, (double)totals.pixelsShaded, "pixels");
+
+			if (report != NULL)
+			{
+				fprintf(report, "%d,%d,%s,%d,%.4f,%.4f,%.4f,%.0f,%.0f,%u,%u,%u,%u,%u,%u,%llu,%llu,%llu,%llu,%llu", width, height,
+						OfflineRenderer::GetDisplayModeName((DisplayMode)mode), frames, mean, p50, p99, trianglesPerSecond, pixelsPerSecond,
+						totals.trianglesSubmitted / frames, totals.trianglesBackfaceCulled / frames, totals.trianglesFrustumCulled / frames,
+						totals.trianglesClipped / frames, totals.trianglesZeroArea / frames, totals.trianglesRasterized / frames,
+						totals.pixelsTested / frames, totals.pixelsShaded / frames, totals.pixelsWritten / frames,
+						totals.texelsFetched / frames, totals.lightsEvaluated / frames);
+				WriteCounterColumns(report, counters, (double)totals.pixelsShaded);
+			}
+		}
+	}
+
+	if (report != NULL)
+		fclose(report);
+}
@@ -0,0 +1,113 @@
+// =========================================================================================
+//	InstanceBenchmarks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+
+// Number of frames drawn for each forest size.
+#define INSTANCE_BENCHMARK_FRAMES	10
+
+// Distance between neighbouring trees in the forest.
+#define INSTANCE_BENCHMARK_SPACING	60.0f
+
+// Works out the memory used by the shared mesh data of a model.
+static unsigned int GetMeshBytes(Model3D& model)
+{
+	return model.GetVertexList().size() * sizeof(Vertex) +
+		   model.GetPolygonList().size() * sizeof(Polygon3D) +
+		   model.GetUVCoordinateList().size() * sizeof(UVCoordinate);
+}
+
+// Benchmarks drawing a forest of instances sharing one tree model, both batched into
+// draw calls of up to MAX_INSTANCES_PER_DRAW trees and as one draw call for each tree,
+// then batched again with the geometry processed on a worker for each hardware thread,
+// and last pipelined so each frames geometry is processed while the last is drawn.
+void RunInstanceBenchmarks()
+{
+	Model3D model;
+	if (MD2Loader::LoadModel("trees.md2", model) == false)
+	{
+		printf("Instance benchmarks skipped, could not load trees.md2.\n");
+		return;
+	}
+
+	Rasterizer rasterizer(640, 480);
+	Camera camera(0, 0, 0, Vertex(0, 50, -100, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0), 640, 480);
+	JobSystem jobSystem(0);
+
+	int treeCounts[] = { 100, 1000 };
+	for (unsigned int i = 0; i < sizeof(treeCounts) / sizeof(treeCounts[0]); i++)
+	{
+		int treeCount = treeCounts[i];
+		int gridSize = (int)ceil(sqrt((float)treeCount));
+		char name[128];
+
+		// Plant the forest in rows moving away from the camera.
+		Scene scene;
+		for (int j = 0; j < treeCount; j++)
+		{
+			float x = ((j % gridSize) - (gridSize * 0.5f)) * INSTANCE_BENCHMARK_SPACING;
+			float z = (j / gridSize) * INSTANCE_BENCHMARK_SPACING;
+			scene.AddInstance(&model, Matrix3D::RotateMatrix(0, (float)j, 0) * Matrix3D::TranslateMatrix(x, 0, z));
+		}
+		scene.Update();
+
+		std::vector<ModelInstance*> visible;
+		scene.QueryFrustum(&camera, visible);
+
+		// Draw the forest through the render queue in batches, then one tree per draw call,
+		// then in batches using the job system, with and without pipelining.
+		int batchSizes[] = { MAX_INSTANCES_PER_DRAW, 1, MAX_INSTANCES_PER_DRAW, MAX_INSTANCES_PER_DRAW };
+		JobSystem* jobSystems[] = { NULL, NULL, &jobSystem, &jobSystem };
+		bool pipelineOn[] = { false, false, false, true };
+		const char* batchNames[] = { "Batched", "Single", "Jobs", "Pipelined" };
+		unsigned int bufferCounts[4] = { 0, 0, 0, 0 };
+		unsigned int bufferBytes[4] = { 0, 0, 0, 0 };
+		unsigned int drawnCount = 0;
+
+		for (int j = 0; j < 4; j++)
+		{
+			sprintf(name, "Instance/%s/%d", batchNames[j], treeCount);
+			if (IsBenchmarkSelected(name) == false)
+				continue;
+
+			RenderQueue queue;
+			queue.SetMaxBatchSize(batchSizes[j]);
+			queue.SetJobSystem(jobSystems[j]);
+			queue.SetPipelineOn(pipelineOn[j]);
+
+			BenchmarkTimer timer;
+			rasterizer.BeginLockBits();
+			rasterizer.ResetStats();
+			timer.Start();
+			for (int frame = 0; frame < INSTANCE_BENCHMARK_FRAMES; frame++)
+			{
+				queue.Begin(&camera, &rasterizer);
+				for (unsigned int k = 0; k < visible.size(); k++)
+					queue.Submit(visible[k], FlatShadedUnlit);
+				queue.Execute();
+			}
+			queue.Flush();
+			double milliseconds = timer.GetElapsedMilliseconds();
+			rasterizer.FinishLockBits();
+
+			ReportBenchmark(name, INSTANCE_BENCHMARK_FRAMES, milliseconds, rasterizer.GetStats().trianglesRasterized, "triangles");
+			if (jobSystems[j] != NULL)
+				printf("    %u batches per frame, %d workers\n", queue.GetBatchCount(), jobSystems[j]->GetWorkerCount());
+			else
+				printf("    %u batches per frame\n", queue.GetBatchCount());
+
+			drawnCount = queue.GetItemCount() - queue.GetCulledCount();
+			bufferCounts[j] = queue.GetBufferPool()->GetBufferCount();
+			bufferBytes[j] = queue.GetBufferPool()->GetBytesAllocated();
+		}
+
+		printf("    %u visible, mesh %u bytes shared by %d trees, buffers %u (%u bytes) batched, %u (%u bytes) single, %u (%u bytes) pipelined\n",
+			drawnCount, GetMeshBytes(model), treeCount,
+			bufferCounts[0], bufferBytes[0], bufferCounts[1], bufferBytes[1], bufferCounts[3], bufferBytes[3]);
+	}
+}
@@ -0,0 +1,97 @@
+// =========================================================================================
+//	JobBenchmarks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+
+// Number of empty jobs run to measure the scheduling overhead of each job.
+#define JOB_BENCHMARK_JOBS			100000
+
+// Number of indexs in each parallel for, and the grain size it is split by.
+#define JOB_BENCHMARK_RANGE			(1 << 20)
+#define JOB_BENCHMARK_GRAIN			1024
+
+// Number of stages in the dependency chain, and the jobs run in each stage.
+#define JOB_BENCHMARK_STAGES		1000
+#define JOB_BENCHMARK_STAGE_JOBS	16
+
+// A job that does nothing, so only the cost of scheduling it is measured.
+static void EmptyJob(void*, int, int)
+{
+}
+
+// A job that does a small amount of work for each index in its range.
+static void ScaleJob(void* data, int begin, int end)
+{
+	float* values = (float*)data;
+	for (int i = begin; i < end; i++)
+		values[i] = values[i] * 0.5f + 1.0f;
+}
+
+// Benchmarks the job system with increasing numbers of workers.
+void RunJobBenchmarks()
+{
+	int workerCounts[] = { 1, 2, 4, JobSystem::GetHardwareWorkerCount() };
+	float* values = new float[JOB_BENCHMARK_RANGE];
+	for (int i = 0; i < JOB_BENCHMARK_RANGE; i++)
+		values[i] = (float)i;
+
+	for (unsigned int i = 0; i < sizeof(workerCounts) / sizeof(workerCounts[0]); i++)
+	{
+		// Don't repeat a worker count if the hardware thread count matches one already run.
+		if (i > 0 && workerCounts[i] <= workerCounts[i - 1])
+			continue;
+
+		int workerCount = workerCounts[i];
+		JobSystem jobSystem(workerCount);
+		char name[128];
+
+		// Run lots of empty jobs, the time taken is the overhead of each job.
+		BenchmarkTimer timer;
+		sprintf(name, "Job/Empty/%d", workerCount);
+		if (IsBenchmarkSelected(name) == true)
+		{
+			timer.Start();
+			JobCounter counter;
+			for (int j = 0; j < JOB_BENCHMARK_JOBS; j++)
+				jobSystem.Run(EmptyJob, NULL, 0, 1, &counter);
+			jobSystem.Wait(&counter);
+			double milliseconds = timer.GetElapsedMilliseconds();
+			ReportBenchmark(name, JOB_BENCHMARK_JOBS, milliseconds, JOB_BENCHMARK_JOBS, "jobs");
+			printf("    %.1f ns/job, %u of %u jobs stolen\n", milliseconds * 1000000.0 / JOB_BENCHMARK_JOBS, jobSystem.GetJobsStolen(), jobSystem.GetJobsExecuted());
+		}
+
+		// Split a range of simple work into jobs.
+		sprintf(name, "Job/ParallelFor/%d", workerCount);
+		if (IsBenchmarkSelected(name) == true)
+		{
+			timer.Start();
+			jobSystem.ParallelFor(JOB_BENCHMARK_RANGE, JOB_BENCHMARK_GRAIN, ScaleJob, values);
+			double milliseconds = timer.GetElapsedMilliseconds();
+			ReportBenchmark(name, 1, milliseconds, JOB_BENCHMARK_RANGE, "indexs");
+		}
+
+		// Run a chain of stages, each waiting on the one before it.
+		sprintf(name, "Job/Dependent/%d", workerCount);
+		if (IsBenchmarkSelected(name) == true)
+		{
+			JobCounter* stages = new JobCounter[JOB_BENCHMARK_STAGES];
+			timer.Start();
+			for (int j = 0; j < JOB_BENCHMARK_STAGES; j++)
+			{
+				for (int k = 0; k < JOB_BENCHMARK_STAGE_JOBS; k++)
+					jobSystem.Run(EmptyJob, NULL, 0, 1, &stages[j], j > 0 ? &stages[j - 1] : NULL);
+			}
+			jobSystem.Wait(&stages[JOB_BENCHMARK_STAGES - 1]);
+			double milliseconds = timer.GetElapsedMilliseconds();
+			delete [] stages;
+			ReportBenchmark(name, JOB_BENCHMARK_STAGES, milliseconds, JOB_BENCHMARK_STAGES * JOB_BENCHMARK_STAGE_JOBS, "jobs");
+		}
+	}
+
+	delete [] values;
+}
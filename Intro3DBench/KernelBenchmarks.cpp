@@ -0,0 +1,105 @@
+// =========================================================================================
+//	KernelBenchmarks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+
+// Number of polygons each span kernel fills per benchmark.
+#define KERNEL_BENCHMARK_ITERATIONS	2000
+
+// Number of frames cleared and drawn over per clear benchmark.
+#define CLEAR_BENCHMARK_ITERATIONS	500
+
+// Benchmarks clearing the frame with and without the fast clear, then drawing a flat
+// quad over most of it, as the scene does with the floor.
+static void RunClearBenchmarks(Rasterizer& rasterizer, Model3D& model)
+{
+	Vertex v1 = MakeBenchmarkVertex(0, 80, 50, Gdiplus::Color::Red, 0, 0);
+	Vertex v2 = MakeBenchmarkVertex(640, 80, 50, Gdiplus::Color::Red, 0, 0);
+	Vertex v3 = MakeBenchmarkVertex(640, 480, 50, Gdiplus::Color::Red, 0, 0);
+	Vertex v4 = MakeBenchmarkVertex(0, 480, 50, Gdiplus::Color::Red, 0, 0);
+
+	const char* names[] = { "Clear/Full", "Clear/Fast" };
+	for (int i = 0; i < 2; i++)
+	{
+		if (IsBenchmarkSelected(names[i]) == false)
+			continue;
+
+		rasterizer.SetFastClearOn(i == 1);
+		rasterizer.ResetClearBytesWritten();
+
+		BenchmarkTimer timer;
+		timer.Start();
+		for (int j = 0; j < CLEAR_BENCHMARK_ITERATIONS; j++)
+		{
+			rasterizer.Clear(Gdiplus::Color::SteelBlue);
+			rasterizer.FillPolygon(SpanKernelFlat, v1, v2, v3, v1.GetColor(), model);
+			rasterizer.FillPolygon(SpanKernelFlat, v1, v3, v4, v1.GetColor(), model);
+
+			// Unlocking is when any tiles still waiting are filled.
+			rasterizer.FinishLockBits();
+			rasterizer.BeginLockBits();
+		}
+		double milliseconds = timer.GetElapsedMilliseconds();
+
+		ReportBenchmark(names[i], CLEAR_BENCHMARK_ITERATIONS, milliseconds, (double)rasterizer.GetWidth() * rasterizer.GetHeight() * CLEAR_BENCHMARK_ITERATIONS, "pixels");
+		printf("    %u clear bytes/frame\n", rasterizer.GetClearBytesWritten() / CLEAR_BENCHMARK_ITERATIONS);
+	}
+	rasterizer.SetFastClearOn(false);
+}
+
+// Benchmarks each span kernel instantiation by filling the same polygon repeatedly.
+void RunKernelBenchmarks()
+{
+	Model3D model;
+	if (MD2Loader::LoadModel("baron.md2", model, "baron.pcx", "baron_nm.pcx") == false)
+	{
+		printf("Kernel benchmarks skipped, could not load baron.md2.\n");
+		return;
+	}
+	model.BuildColormap(64, true);
+	model.SetNormalMapOn(true);
+
+	// Set up the same lights as the demo.
+	BenchmarkLights lights;
+	Rasterizer rasterizer(640, 480);
+	rasterizer.SetLights(lights.directionalLights, lights.ambientLights, lights.pointLights);
+	rasterizer.BeginLockBits();
+
+	// A polygon covering roughly 45,000 pixels.
+	Vertex v1 = MakeBenchmarkVertex(100, 100, 50, Gdiplus::Color(200, 120, 40), 10, 10);
+	Vertex v2 = MakeBenchmarkVertex(420, 160, 60, Gdiplus::Color(40, 200, 120), 200, 20);
+	Vertex v3 = MakeBenchmarkVertex(200, 400, 70, Gdiplus::Color(120, 40, 200), 60, 200);
+	double pixels = 0.5 * abs(((v2.GetX() - v1.GetX()) * (v3.GetY() - v1.GetY())) - ((v3.GetX() - v1.GetX()) * (v2.GetY() - v1.GetY())));
+
+	for (int kernel = 0; kernel < SPAN_KERNEL_COUNT; kernel++)
+	{
+		std::string name = std::string("Kernel/") + Rasterizer::GetSpanKernelName((SpanKernel)kernel);
+		if (IsBenchmarkSelected(name.c_str()) == false)
+			continue;
+
+		// Point lights are only used by the kernels built with them.
+		lights.pointLight.SetEnabled(kernel == SpanKernelNormalMappedDirectionalPoint);
+
+		rasterizer.ResetSetupBytesWritten();
+
+		BenchmarkTimer timer;
+		timer.Start();
+		for (int i = 0; i < KERNEL_BENCHMARK_ITERATIONS; i++)
+			rasterizer.FillPolygon((SpanKernel)kernel, v1, v2, v3, v1.GetColor(), model);
+		double milliseconds = timer.GetElapsedMilliseconds();
+
+		ReportBenchmark(name.c_str(), KERNEL_BENCHMARK_ITERATIONS, milliseconds, pixels * KERNEL_BENCHMARK_ITERATIONS, "pixels");
+
+		VaryingsDescriptor varyings = Rasterizer::GetVaryingsDescriptor((SpanKernel)kernel);
+		printf("    %d varyings, %u setup bytes/polygon\n", varyings.count, rasterizer.GetSetupBytesWritten() / KERNEL_BENCHMARK_ITERATIONS);
+	}
+
+	RunClearBenchmarks(rasterizer, model);
+
+	rasterizer.FinishLockBits();
+}
@@ -0,0 +1,270 @@
+// =========================================================================================
+//	MicroBenchmarks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+
+// Number of times the whole model is worked on by each of the per vertex and per polygon
+// benchmarks.
+#define MICRO_BENCHMARK_MODEL_ITERATIONS	2000
+
+// Number of polygons set up by each setup benchmark.
+#define MICRO_BENCHMARK_SETUP_ITERATIONS	200000
+
+// Number of pixels each fill benchmark covers in total, the number of triangles drawn is
+// this divided by the size of the triangle.
+#define MICRO_BENCHMARK_FILL_PIXELS			20000000.0
+
+// Fewest and most triangles drawn by a fill benchmark, so the full screen triangle is still
+// timed over more than a couple of draws and the smallest do not take too long.
+#define MICRO_BENCHMARK_FILL_MIN_ITERATIONS	50
+#define MICRO_BENCHMARK_FILL_MAX_ITERATIONS	500000
+
+// Written to by the benchmarks so the compiler can not throw away the work being timed.
+static volatile float MicroBenchmarkSink;
+
+// Benchmarks transforming the models vertices, both one vertex at a time through the
+// matrix and through the instance as the renderer does it.
+static void RunTransformBenchmarks(Model3D& model, ModelInstance& instance)
+{
+	std::vector<Vertex>& vertices = model.GetVertexList();
+	int vertexCount = vertices.size();
+	double units = (double)vertexCount * MICRO_BENCHMARK_MODEL_ITERATIONS;
+	Matrix3D transform = instance.GetTransform();
+
+	if (IsBenchmarkSelected("Micro/Transform/Vertex") == true)
+	{
+		float sum = 0;
+		BenchmarkTimer timer;
+		timer.Start();
+		for (int i = 0; i < MICRO_BENCHMARK_MODEL_ITERATIONS; i++)
+		{
+			for (int j = 0; j < vertexCount; j++)
+			{
+				Vertex result = transform * vertices[j];
+				sum += result.GetX();
+			}
+		}
+		double milliseconds = timer.GetElapsedMilliseconds();
+		MicroBenchmarkSink = sum;
+		ReportBenchmark("Micro/Transform/Vertex", MICRO_BENCHMARK_MODEL_ITERATIONS, milliseconds, units, "vertices");
+	}
+
+	if (IsBenchmarkSelected("Micro/Transform/Instance") == true)
+	{
+		BenchmarkTimer timer;
+		timer.Start();
+		for (int i = 0; i < MICRO_BENCHMARK_MODEL_ITERATIONS; i++)
+			instance.ApplyTransformToLocalVertices(0, vertexCount);
+		double milliseconds = timer.GetElapsedMilliseconds();
+		ReportBenchmark("Micro/Transform/Instance", MICRO_BENCHMARK_MODEL_ITERATIONS, milliseconds, units, "vertices");
+	}
+}
+
+// Benchmarks working out the vertex normals from the polygons around each vertex.
+static void RunNormalBenchmarks(Model3D& model, ModelInstance& instance)
+{
+	if (IsBenchmarkSelected("Micro/Normals") == false)
+		return;
+
+	int vertexCount = model.GetVertexList().size();
+
+	BenchmarkTimer timer;
+	timer.Start();
+	for (int i = 0; i < MICRO_BENCHMARK_MODEL_ITERATIONS; i++)
+	{
+		instance.SumVertexNormals();
+		instance.NormalizeVertexNormals(0, vertexCount);
+	}
+	double milliseconds = timer.GetElapsedMilliseconds();
+	ReportBenchmark("Micro/Normals", MICRO_BENCHMARK_MODEL_ITERATIONS, milliseconds, (double)vertexCount * MICRO_BENCHMARK_MODEL_ITERATIONS, "vertices");
+}
+
+// Benchmarks lighting the models vertices with one light of each type, lit as the demo
+// lights them.
+static void RunLightingBenchmarks(Model3D& model, ModelInstance& instance)
+{
+	int vertexCount = model.GetVertexList().size();
+	double units = (double)vertexCount * MICRO_BENCHMARK_MODEL_ITERATIONS;
+
+	// The demo lights with the point light on, and a spot light as the demo has none.
+	BenchmarkLights lights;
+	lights.pointLight.SetEnabled(true);
+
+	SpotLight spotLight(Color(0, 255, 0), 0, 0.1f, 0, 10, 30);
+	spotLight.SetPosition(Vertex(0, 150, -100, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0));
+	spotLight.SetEnabled(true);
+
+	std::vector<SpotLight*> spotLights(1, &spotLight);
+
+	const char* names[] = { "Micro/Lighting/Directional", "Micro/Lighting/Ambient", "Micro/Lighting/Point", "Micro/Lighting/Spot" };
+	for (int i = 0; i < 4; i++)
+	{
+		if (IsBenchmarkSelected(names[i]) == false)
+			continue;
+
+		BenchmarkTimer timer;
+		timer.Start();
+		for (int j = 0; j < MICRO_BENCHMARK_MODEL_ITERATIONS; j++)
+		{
+			switch (i)
+			{
+				case 0: instance.CalculateLightingDirectional(lights.directionalLights, 0, vertexCount);	break;
+				case 1: instance.CalculateLightingAmbient(lights.ambientLights, 0, vertexCount);			break;
+				case 2: instance.CalculateLightingPoint(lights.pointLights, 0, vertexCount);				break;
+				case 3: instance.CalculateLightingSpot(spotLights, 0, vertexCount);							break;
+			}
+		}
+		double milliseconds = timer.GetElapsedMilliseconds();
+		ReportBenchmark(names[i], MICRO_BENCHMARK_MODEL_ITERATIONS, milliseconds, units, "vertices");
+	}
+}
+
+// Benchmarks sorting the models polygons by depth. The polygons are put back in the
+// models order before each sort, and only the sort itself is timed.
+static void RunDepthSortBenchmarks(Model3D& model, ModelInstance& instance)
+{
+	if (IsBenchmarkSelected("Micro/DepthSort") == false)
+		return;
+
+	int vertexCount = model.GetVertexList().size();
+	int polygonCount = model.GetPolygonList().size();
+
+	double milliseconds = 0;
+	BenchmarkTimer timer;
+	for (int i = 0; i < MICRO_BENCHMARK_MODEL_ITERATIONS; i++)
+	{
+		instance.ResetBuffers();
+		instance.ApplyTransformToLocalVertices(0, vertexCount);
+		instance.CalculatePolygonDepths(0, polygonCount);
+
+		timer.Start();
+		instance.DepthSort();
+		milliseconds += timer.GetElapsedMilliseconds();
+	}
+	ReportBenchmark("Micro/DepthSort", MICRO_BENCHMARK_MODEL_ITERATIONS, milliseconds, (double)polygonCount * MICRO_BENCHMARK_MODEL_ITERATIONS, "triangles");
+}
+
+// Benchmarks the per polygon setup of each span kernel, sorting the vertices and
+// interpolating the edges into scanlines, without filling any spans.
+static void RunSetupBenchmarks(Rasterizer& rasterizer)
+{
+	Vertex v1 = MakeBenchmarkVertex(100, 100, 50, Gdiplus::Color(200, 120, 40), 10, 10);
+	Vertex v2 = MakeBenchmarkVertex(420, 160, 60, Gdiplus::Color(40, 200, 120), 200, 20);
+	Vertex v3 = MakeBenchmarkVertex(200, 400, 70, Gdiplus::Color(120, 40, 200), 60, 200);
+
+	for (int kernel = 0; kernel < SPAN_KERNEL_COUNT; kernel++)
+	{
+		std::string name = std::string("Micro/Setup/") + Rasterizer::GetSpanKernelName((SpanKernel)kernel);
+		if (IsBenchmarkSelected(name.c_str()) == false)
+			continue;
+
+		BenchmarkTimer timer;
+		timer.Start();
+		for (int i = 0; i < MICRO_BENCHMARK_SETUP_ITERATIONS; i++)
+			rasterizer.SetupPolygon((SpanKernel)kernel, v1, v2, v3);
+		double milliseconds = timer.GetElapsedMilliseconds();
+		ReportBenchmark(name.c_str(), MICRO_BENCHMARK_SETUP_ITERATIONS, milliseconds, MICRO_BENCHMARK_SETUP_ITERATIONS, "triangles");
+	}
+}
+
+// Benchmarks each span kernel filling triangles of 1, 16 and 256 pixels, and one covering
+// the whole screen. Each size is drawn enough times to cover about the same number of
+// pixels, so the small sizes show the cost of setting up each polygon and the large the
+// cost of each pixel.
+static void RunFillBenchmarks(Rasterizer& rasterizer, Model3D& model, PointLight& pointLight)
+{
+	float width = (float)rasterizer.GetWidth();
+	float height = (float)rasterizer.GetHeight();
+
+	const char* sizeNames[] = { "1", "16", "256", "Full" };
+	float sizes[] = { 1, 16, 256, width * height };
+
+	for (int kernel = 0; kernel < SPAN_KERNEL_COUNT; kernel++)
+	{
+		// Point lights are only used by the kernels built with them.
+		pointLight.SetEnabled(kernel == SpanKernelNormalMappedDirectionalPoint);
+
+		for (int i = 0; i < 4; i++)
+		{
+			std::string name = std::string("Micro/Fill/") + Rasterizer::GetSpanKernelName((SpanKernel)kernel) + "/" + sizeNames[i];
+			if (IsBenchmarkSelected(name.c_str()) == false)
+				continue;
+
+			// A right angled triangle with the area of the size, the full screen triangle has
+			// its long edge off the screen so it covers all of it.
+			Vertex v1, v2, v3;
+			if (i == 3)
+			{
+				v1 = MakeBenchmarkVertex(0, 0, 50, Gdiplus::Color(200, 120, 40), 0, 0);
+				v2 = MakeBenchmarkVertex(width * 2, 0, 60, Gdiplus::Color(40, 200, 120), 250, 0);
+				v3 = MakeBenchmarkVertex(0, height * 2, 70, Gdiplus::Color(120, 40, 200), 0, 250);
+			}
+			else
+			{
+				float leg = sqrt(sizes[i] * 2);
+				v1 = MakeBenchmarkVertex(100, 100, 50, Gdiplus::Color(200, 120, 40), 10, 10);
+				v2 = MakeBenchmarkVertex(100 + leg, 100, 60, Gdiplus::Color(40, 200, 120), 10 + leg, 10);
+				v3 = MakeBenchmarkVertex(100, 100 + leg, 70, Gdiplus::Color(120, 40, 200), 10, 10 + leg);
+			}
+
+			int iterations = (int)(MICRO_BENCHMARK_FILL_PIXELS / sizes[i]);
+			iterations = min(max(iterations, MICRO_BENCHMARK_FILL_MIN_ITERATIONS), MICRO_BENCHMARK_FILL_MAX_ITERATIONS);
+			rasterizer.ResetStats();
+
+			BenchmarkTimer timer;
+			timer.Start();
+			for (int j = 0; j < iterations; j++)
+				rasterizer.FillPolygon((SpanKernel)kernel, v1, v2, v3, v1.GetColor(), model);
+			double milliseconds = timer.GetElapsedMilliseconds();
+
+			double pixels = (double)rasterizer.GetStats().pixelsShaded;
+			ReportBenchmark(name.c_str(), iterations, milliseconds, iterations, "triangles");
+			printf("    %.1f pixels/triangle, %.2f Mpixels/s\n", pixels / iterations, (milliseconds > 0) ? pixels / (milliseconds * 1000.0) : 0);
+		}
+	}
+}
+
+// Benchmarks the hot paths of the renderer one at a time, the vertex transform, normals,
+// lighting, depth sort, polygon setup and span filling, on the demo model. Each benchmark
+// is named Micro/<stage>/..., so a single one can be run with the filter.
+void RunMicroBenchmarks()
+{
+	Model3D model;
+	if (MD2Loader::LoadModel("baron.md2", model, "baron.pcx", "baron_nm.pcx") == false)
+	{
+		printf("Micro benchmarks skipped, could not load baron.md2.\n");
+		return;
+	}
+	model.BuildColormap(64, true);
+	model.SetNormalMapOn(true);
+
+	// Put the model where the demo draws it, with its buffers ready to work on.
+	InstanceBufferPool pool;
+	ModelInstance instance(&model, Matrix3D::RotateMatrix(0, 0.5f, 0) * Matrix3D::TranslateMatrix(0, 0, 30));
+	instance.AcquireBuffers(&pool);
+	instance.ResetBuffers();
+	instance.ApplyTransformToLocalVertices(0, model.GetVertexList().size());
+
+	RunTransformBenchmarks(model, instance);
+	RunNormalBenchmarks(model, instance);
+	RunLightingBenchmarks(model, instance);
+	RunDepthSortBenchmarks(model, instance);
+
+	instance.ReleaseBuffers(&pool);
+
+	// Set up the same lights as the demo for the span kernels.
+	BenchmarkLights lights;
+	Rasterizer rasterizer(640, 480);
+	rasterizer.SetLights(lights.directionalLights, lights.ambientLights, lights.pointLights);
+	rasterizer.BeginLockBits();
+
+	RunSetupBenchmarks(rasterizer);
+	RunFillBenchmarks(rasterizer, model, lights.pointLight);
+
+	rasterizer.FinishLockBits();
+}
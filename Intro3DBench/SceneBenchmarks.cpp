@@ -0,0 +1,125 @@
+// =========================================================================================
+//	SceneBenchmarks.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "Benchmark.h"
+
+// Number of frustum queries timed for each scene size.
+#define SCENE_BENCHMARK_QUERIES		200
+
+// Distance between neighbouring instances in the benchmark scenes.
+#define SCENE_BENCHMARK_SPACING		40.0f
+
+// Fraction of the instances moved each frame in the refit benchmark.
+#define SCENE_BENCHMARK_MOVED		0.01f
+
+// Returns a random number between 0 and 1.
+static float RandomUnit()
+{
+	return rand() / (float)RAND_MAX;
+}
+
+// Works out the transform of a prop scattered over a square grid.
+static Matrix3D MakePropTransform(int index, int gridSize)
+{
+	float x = ((index % gridSize) - (gridSize * 0.5f) + RandomUnit()) * SCENE_BENCHMARK_SPACING;
+	float z = ((index / gridSize) - (gridSize * 0.5f) + RandomUnit()) * SCENE_BENCHMARK_SPACING;
+	float scale = 0.5f + RandomUnit();
+
+	return Matrix3D::ScaleMatrix(scale, scale, scale) * Matrix3D::RotateMatrix(0, RandomUnit() * 6.28f, 0) * Matrix3D::TranslateMatrix(x, 0, z);
+}
+
+// Benchmarks building, refitting and querying the scene hierarchy against
+// testing every instance, for scenes of increasing size.
+void RunSceneBenchmarks()
+{
+	Model3D model;
+	if (MD2Loader::LoadModel("pilaar.md2", model) == false)
+	{
+		printf("Scene benchmarks skipped, could not load pilaar.md2.\n");
+		return;
+	}
+
+	int instanceCounts[] = { 100, 1000, 10000, 100000 };
+	for (unsigned int i = 0; i < sizeof(instanceCounts) / sizeof(instanceCounts[0]); i++)
+	{
+		int instanceCount = instanceCounts[i];
+		int gridSize = (int)ceil(sqrt((float)instanceCount));
+		char name[128];
+		srand(1);
+
+		Scene scene;
+		for (int j = 0; j < instanceCount; j++)
+			scene.AddInstance(&model, MakePropTransform(j, gridSize));
+
+		// Build the hierarchy, the other benchmarks need it so it is always built.
+		BenchmarkTimer timer;
+		timer.Start();
+		scene.Update();
+		double milliseconds = timer.GetElapsedMilliseconds();
+		sprintf(name, "Scene/Build/%d", instanceCount);
+		if (IsBenchmarkSelected(name) == true)
+			ReportBenchmark(name, 1, milliseconds, instanceCount, "instances");
+
+		// Query the hierarchy from a camera turning on the spot in the middle of the scene.
+		std::vector<ModelInstance*> visible;
+		unsigned int visibleTotal = 0;
+		Camera camera(0, 0, 0, Vertex(0, 50, 0, 1, Gdiplus::Color::Black, Vector3D(0,0,0), 0), 640, 480);
+		sprintf(name, "Scene/Query/%d", instanceCount);
+		if (IsBenchmarkSelected(name) == true)
+		{
+			timer.Start();
+			for (int j = 0; j < SCENE_BENCHMARK_QUERIES; j++)
+			{
+				camera.SetRotation(0, j * (6.28f / SCENE_BENCHMARK_QUERIES), 0);
+				scene.QueryFrustum(&camera, visible);
+				visibleTotal += visible.size();
+			}
+			milliseconds = timer.GetElapsedMilliseconds();
+			ReportBenchmark(name, SCENE_BENCHMARK_QUERIES, milliseconds, (double)instanceCount * SCENE_BENCHMARK_QUERIES, "instances");
+			printf("    %.1f visible per query\n", visibleTotal / (float)SCENE_BENCHMARK_QUERIES);
+		}
+
+		// Test each instance against the same cameras for comparison.
+		unsigned int linearVisibleTotal = 0;
+		sprintf(name, "Scene/LinearQuery/%d", instanceCount);
+		if (IsBenchmarkSelected(name) == true)
+		{
+			timer.Start();
+			for (int j = 0; j < SCENE_BENCHMARK_QUERIES; j++)
+			{
+				camera.SetRotation(0, j * (6.28f / SCENE_BENCHMARK_QUERIES), 0);
+				for (int k = 0; k < instanceCount; k++)
+				{
+					Vector3D worldMin, worldMax;
+					scene.GetInstance(k)->GetWorldAABB(worldMin, worldMax);
+					if (camera.TestAABB(worldMin, worldMax) != FrustumOutside)
+						linearVisibleTotal++;
+				}
+			}
+			milliseconds = timer.GetElapsedMilliseconds();
+			ReportBenchmark(name, SCENE_BENCHMARK_QUERIES, milliseconds, (double)instanceCount * SCENE_BENCHMARK_QUERIES, "instances");
+			printf("    %.1f visible per query\n", linearVisibleTotal / (float)SCENE_BENCHMARK_QUERIES);
+		}
+
+		// Move a few instances and refit the hierarchy.
+		sprintf(name, "Scene/Refit/%d", instanceCount);
+		if (IsBenchmarkSelected(name) == true)
+		{
+			int movedCount = max(1, (int)(instanceCount * SCENE_BENCHMARK_MOVED));
+			timer.Start();
+			for (int j = 0; j < movedCount; j++)
+			{
+				int index = rand() % instanceCount;
+				scene.SetInstanceTransform(index, MakePropTransform(index, gridSize));
+			}
+			scene.Update();
+			milliseconds = timer.GetElapsedMilliseconds();
+			ReportBenchmark(name, 1, milliseconds, movedCount, "instances");
+		}
+	}
+}
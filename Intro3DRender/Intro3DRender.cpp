@@ -0,0 +1,585 @@
+// =========================================================================================
+//	Intro3DRender.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Renders a fixed number of frames without a window, for running the renderer on machines
+// with no display. The scene is built from the models and lights given on the command
+// line, or is the demonstration scene if none are given, and the camera follows a path
+// that only depends on the frame number. The frames can instead be replayed from a
+// capture, recorded by this or by the demonstration, to render a frame exactly as it was.
+
+#include "stdafx.h"
+#include "OfflineRenderer.h"
+#include <chrono>
+
+// Defaults used when an option is not given.
+#define RENDER_DEFAULT_FRAMES		60
+#define RENDER_DEFAULT_WIDTH		640
+#define RENDER_DEFAULT_HEIGHT		480
+#define RENDER_DEFAULT_TRACE_FRAMES	10
+
+// A model given on the command line, and the options that follow it.
+struct ModelArgument
+{
+	const char* modelFilename;
+	const char* textureFilename;
+	const char* normalMapFilename;
+	Vector3D position;
+	float spin;
+	RenderLayer layer;
+};
+
+// Prints how the renderer is used.
+static void PrintUsage()
+{
+	printf("Usage: Intro3DRender [options]\n");
+	printf("\n");
+	printf("  --model <file.md2>          Adds a model to the scene. The options below up to the\n");
+	printf("                              next --model apply to it.\n");
+	printf("    --texture <file.pcx>      Texture the model is drawn with.\n");
+	printf("    --normal-map <file.pcx>   Normal map the model is drawn with.\n");
+	printf("    --position <x,y,z>        Where the model is placed, the origin by default.\n");
+	printf("    --spin <radians>          How far the model turns each frame, 0 by default.\n");
+	printf("    --background              Draws the model before everything else, eg. a floor.\n");
+	printf("  --light directional:<x,y,z>:<r,g,b>\n");
+	printf("  --light ambient:<r,g,b>\n");
+	printf("  --light point:<x,y,z>:<r,g,b>[:<a,b,c>]\n");
+	printf("                              Adds a light, points lights take their attenuation.\n");
+	printf("  --mode <name|index>         Display mode, the most detailed one by default.\n");
+	printf("  --camera <static|orbit|dolly>\n");
+	printf("                              Path the camera follows, static by default.\n");
+	printf("  --frames <count>            Number of frames rendered, %d by default.\n", RENDER_DEFAULT_FRAMES);
+	printf("  --size <width>x<height>     Size of the frames, %dx%d by default.\n", RENDER_DEFAULT_WIDTH, RENDER_DEFAULT_HEIGHT);
+	printf("  --output <format>           printf format of the file each frame is written to, eg.\n");
+	printf("                              frame%%04d.png. PNG if it ends in .png, PPM otherwise.\n");
+	printf("                              Frames are not written if it is not given.\n");
+	printf("  --workers <count>           Workers the geometry is processed on, 0 for one for\n");
+	printf("                              each hardware thread. 1 by default.\n");
+	printf("  --pipeline                  Processes each frames geometry while the last is drawn.\n");
+	printf("  --profile <file.json>       Times each stage of each frame, prints the average of\n");
+	printf("                              each and writes the last frames as a Chrome trace.\n");
+	printf("  --profile-frames <count>    Number of frames in the trace, %d by default.\n", RENDER_DEFAULT_TRACE_FRAMES);
+	printf("  --counters                  Reads the hardware performance counters around each\n");
+	printf("                              profiled stage and prints them per frame. Linux only.\n");
+	printf("  --allocations               Counts the allocations made in each frame, and in each\n");
+	printf("                              profiled stage, and prints them per frame.\n");
+	printf("  --assert-no-allocations     Aborts if a frame after the first %d allocates.\n", ALLOCATION_WARMUP_FRAMES);
+	printf("                              Both need a build with INTRO3D_ALLOCATION_TRACKING.\n");
+	printf("  --debug-view <none|overdraw|tilecost>\n");
+	printf("                              Draws the writes to each pixel, or the time spent\n");
+	printf("                              shading each tile, over the frames. none by default.\n");
+	printf("  --capture <file.i3dc>       Records what each frame is rendered from, so it can\n");
+	printf("                              be replayed.\n");
+	printf("  --replay <file.i3dc>        Renders the frames of a capture instead of the scene.\n");
+	printf("                              The models, lights, mode, camera and size options are\n");
+	printf("                              not used. Each captured frame is rendered once, or\n");
+	printf("                              --frames loops over them.\n");
+	printf("  --replay-frame <index>      Renders only the given frame of the capture, --frames\n");
+	printf("                              times.\n");
+	printf("\n");
+	printf("Display modes:\n");
+	for (int i = 0; i < DISPLAY_MODE_COUNT; i++)
+		printf("  %2d %s\n", i, OfflineRenderer::GetDisplayModeName((DisplayMode)i));
+}
+
+// Parses a list of comma separated floats, returns false if there are not exactly count.
+static bool ParseFloats(const char* text, float* values, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		char* end;
+		values[i] = (float)strtod(text, &end);
+		if (end == text)
+			return false;
+
+		text = end;
+		if (i < count - 1)
+		{
+			if (*text != ',')
+				return false;
+			text++;
+		}
+	}
+	return *text == '\0' || *text == ':';
+}
+
+// Parses a color given as three comma separated channels from 0 to 255.
+static bool ParseColor(const char* text, Gdiplus::Color& color)
+{
+	float values[3];
+	if (ParseFloats(text, values, 3) == false)
+		return false;
+
+	color = Gdiplus::Color((BYTE)min(max(values[0], 0.0f), 255.0f),
+						   (BYTE)min(max(values[1], 0.0f), 255.0f),
+						   (BYTE)min(max(values[2], 0.0f), 255.0f));
+	return true;
+}
+
+// Adds a light given as type:arguments to the renderer.
+static bool AddLight(OfflineRenderer& renderer, const char* text)
+{
+	const char* arguments = strchr(text, ':');
+	if (arguments == NULL)
+		return false;
+	std::string type(text, arguments - text);
+	arguments++;
+
+	float position[3];
+	Gdiplus::Color color;
+	if (type == "ambient")
+	{
+		if (ParseColor(arguments, color) == false)
+			return false;
+		renderer.AddAmbientLight(color);
+		return true;
+	}
+
+	// Directional and point lights start with a position.
+	const char* colorText = strchr(arguments, ':');
+	if (colorText == NULL || ParseFloats(arguments, position, 3) == false || ParseColor(colorText + 1, color) == false)
+		return false;
+
+	if (type == "directional")
+	{
+		renderer.AddDirectionalLight(Vector3D(position[0], position[1], position[2]), color);
+		return true;
+	}
+	if (type == "point")
+	{
+		float attenuation[3] = { 0.0f, 0.1f, 0.0f };
+		const char* attenuationText = strchr(colorText + 1, ':');
+		if (attenuationText != NULL && ParseFloats(attenuationText + 1, attenuation, 3) == false)
+			return false;
+		renderer.AddPointLight(Vector3D(position[0], position[1], position[2]), color, attenuation[0], attenuation[1], attenuation[2]);
+		return true;
+	}
+	return false;
+}
+
+// Finds a display mode by name or index, returns -1 if there is none.
+static int ParseDisplayMode(const char* text)
+{
+	for (int i = 0; i < DISPLAY_MODE_COUNT; i++)
+	{
+		if (strcmp(text, OfflineRenderer::GetDisplayModeName((DisplayMode)i)) == 0)
+			return i;
+	}
+
+	char* end;
+	long index = strtol(text, &end, 10);
+	if (end == text || *end != '\0' || index < 0 || index >= DISPLAY_MODE_COUNT)
+		return -1;
+	return (int)index;
+}
+
+// Finds a camera path by name, returns -1 if there is none.
+static int ParseCameraPath(const char* text)
+{
+	for (int i = 0; i < CAMERA_PATH_COUNT; i++)
+	{
+		if (strcmp(text, OfflineRenderer::GetCameraPathName((CameraPath)i)) == 0)
+			return i;
+	}
+	return -1;
+}
+
+// Finds a debug view by name, returns -1 if there is none.
+static int ParseDebugView(const char* text)
+{
+	for (int i = 0; i < DEBUG_VIEW_COUNT; i++)
+	{
+		if (strcmp(text, OfflineRenderer::GetDebugViewName((DebugView)i)) == 0)
+			return i;
+	}
+	return -1;
+}
+
+// Entry point.
+int main(int argc, char* argv[])
+{
+	std::vector<ModelArgument> models;
+	std::vector<const char*> lights;
+	int displayMode = TexturedNormalMappedDirectionalPointAmbient;
+	int cameraPath = CameraPathStatic;
+	int debugView = DebugViewNone;
+	int frameCount = RENDER_DEFAULT_FRAMES;
+	int width = RENDER_DEFAULT_WIDTH;
+	int height = RENDER_DEFAULT_HEIGHT;
+	int workerCount = 1;
+	bool pipelineOn = false;
+	bool countersOn = false;
+	bool allocationsOn = false;
+	bool assertNoAllocations = false;
+	const char* output = NULL;
+	const char* profile = NULL;
+	int traceFrames = RENDER_DEFAULT_TRACE_FRAMES;
+	const char* captureFilename = NULL;
+	const char* replayFilename = NULL;
+	int replayFrame = -1;
+	bool frameCountSet = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		bool valid = true;
+
+		if (strcmp(option, "--help") == 0)
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if (strcmp(option, "--background") == 0)
+		{
+			valid = models.size() > 0;
+			if (valid == true)
+				models.back().layer = RenderLayerBackground;
+			value = NULL;
+		}
+		else if (strcmp(option, "--pipeline") == 0)
+		{
+			pipelineOn = true;
+			value = NULL;
+		}
+		else if (strcmp(option, "--counters") == 0)
+		{
+			countersOn = true;
+			value = NULL;
+		}
+		else if (strcmp(option, "--allocations") == 0)
+		{
+			allocationsOn = true;
+			value = NULL;
+		}
+		else if (strcmp(option, "--assert-no-allocations") == 0)
+		{
+			assertNoAllocations = true;
+			value = NULL;
+		}
+		else if (value == NULL)
+		{
+			valid = false;
+		}
+		else if (strcmp(option, "--model") == 0)
+		{
+			ModelArgument model;
+			model.modelFilename = value;
+			model.textureFilename = NULL;
+			model.normalMapFilename = NULL;
+			model.position = Vector3D(0, 0, 0);
+			model.spin = 0.0f;
+			model.layer = RenderLayerScene;
+			models.push_back(model);
+		}
+		else if (strcmp(option, "--texture") == 0 || strcmp(option, "--normal-map") == 0 ||
+				 strcmp(option, "--position") == 0 || strcmp(option, "--spin") == 0)
+		{
+			valid = models.size() > 0;
+			if (valid == true)
+			{
+				ModelArgument& model = models.back();
+				float position[3];
+				if (strcmp(option, "--texture") == 0)
+					model.textureFilename = value;
+				else if (strcmp(option, "--normal-map") == 0)
+					model.normalMapFilename = value;
+				else if (strcmp(option, "--spin") == 0)
+					model.spin = (float)atof(value);
+				else if ((valid = ParseFloats(value, position, 3)) == true)
+					model.position = Vector3D(position[0], position[1], position[2]);
+			}
+		}
+		else if (strcmp(option, "--light") == 0)
+		{
+			lights.push_back(value);
+		}
+		else if (strcmp(option, "--mode") == 0)
+		{
+			displayMode = ParseDisplayMode(value);
+			valid = displayMode >= 0;
+		}
+		else if (strcmp(option, "--camera") == 0)
+		{
+			cameraPath = ParseCameraPath(value);
+			valid = cameraPath >= 0;
+		}
+		else if (strcmp(option, "--debug-view") == 0)
+		{
+			debugView = ParseDebugView(value);
+			valid = debugView >= 0;
+		}
+		else if (strcmp(option, "--frames") == 0)
+		{
+			frameCount = atoi(value);
+			valid = frameCount > 0;
+			frameCountSet = true;
+		}
+		else if (strcmp(option, "--size") == 0)
+		{
+			valid = sscanf(value, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+		}
+		else if (strcmp(option, "--output") == 0)
+		{
+			output = value;
+		}
+		else if (strcmp(option, "--workers") == 0)
+		{
+			workerCount = atoi(value);
+		}
+		else if (strcmp(option, "--profile") == 0)
+		{
+			profile = value;
+		}
+		else if (strcmp(option, "--profile-frames") == 0)
+		{
+			traceFrames = atoi(value);
+			valid = traceFrames > 0;
+		}
+		else if (strcmp(option, "--capture") == 0)
+		{
+			captureFilename = value;
+		}
+		else if (strcmp(option, "--replay") == 0)
+		{
+			replayFilename = value;
+		}
+		else if (strcmp(option, "--replay-frame") == 0)
+		{
+			replayFrame = atoi(value);
+			valid = replayFrame >= 0;
+		}
+		else
+		{
+			valid = false;
+		}
+
+		if (valid == false)
+		{
+			fprintf(stderr, "Invalid option: %s%s%s\n", option, value ? " " : "", value ? value : "");
+			PrintUsage();
+			return 1;
+		}
+		if (value != NULL)
+			i++;
+	}
+
+	// Nothing is counted unless the operator new and delete replacements are built in.
+	if ((allocationsOn == true || assertNoAllocations == true) && ALLOCATION_TRACKING_ON == false)
+	{
+		fprintf(stderr, "Allocations are not counted by this build, build it with INTRO3D_ALLOCATION_TRACKING on.\n");
+		return 1;
+	}
+
+	// A replay is of the size it was captured at, and of each of its frames by default.
+	FrameCapture replay;
+	if (replayFilename != NULL)
+	{
+		if (replay.Load(replayFilename) == false || replay.GetFrameCount() == 0)
+		{
+			fprintf(stderr, "Could not read %s, or it has no frames.\n", replayFilename);
+			return 1;
+		}
+		if (replayFrame >= (int)replay.GetFrameCount())
+		{
+			fprintf(stderr, "%s has %u frames, there is no frame %d.\n", replayFilename, replay.GetFrameCount(), replayFrame);
+			return 1;
+		}
+		width = (int)replay.GetWidth();
+		height = (int)replay.GetHeight();
+		if (frameCountSet == false)
+			frameCount = (replayFrame >= 0) ? 1 : (int)replay.GetFrameCount();
+	}
+
+	Gdiplus::GdiplusStartupInput gdiStartupInput;
+	ULONG_PTR gdiToken;
+	Gdiplus::GdiplusStartup(&gdiToken, &gdiStartupInput, NULL);
+
+	int result = 0;
+	{
+		JobSystem jobSystem(workerCount);
+		OfflineRenderer renderer((unsigned int)width, (unsigned int)height);
+
+		if (replayFilename != NULL)
+		{
+			if (renderer.LoadCapture(replay) == false)
+			{
+				fprintf(stderr, "Could not load the models of %s.\n", replayFilename);
+				result = 1;
+			}
+		}
+
+		// Without any models, render the demonstration scene.
+		else if (models.size() == 0 && renderer.LoadDemoModels() == false)
+		{
+			fprintf(stderr, "Could not load the demonstration models.\n");
+			result = 1;
+		}
+		for (unsigned int i = 0; i < models.size() && result == 0 && replayFilename == NULL; i++)
+		{
+			ModelArgument& model = models[i];
+			int index = renderer.LoadModel(model.modelFilename, model.textureFilename, model.normalMapFilename);
+			if (index < 0)
+			{
+				fprintf(stderr, "Could not load %s.\n", model.modelFilename);
+				result = 1;
+				break;
+			}
+			renderer.AddInstance(index, model.position, model.spin, model.layer);
+		}
+
+		// Without any lights, use the demonstration lights.
+		if (lights.size() == 0 && replayFilename == NULL)
+			renderer.AddDemoLights();
+		for (unsigned int i = 0; i < lights.size() && result == 0 && replayFilename == NULL; i++)
+		{
+			if (AddLight(renderer, lights[i]) == false)
+			{
+				fprintf(stderr, "Invalid light: %s\n", lights[i]);
+				result = 1;
+			}
+		}
+
+		if (result == 0)
+		{
+			renderer.SetJobSystem(&jobSystem);
+			renderer.SetPipelineOn(pipelineOn);
+			renderer.SetDisplayMode((DisplayMode)displayMode);
+			renderer.SetCameraPath((CameraPath)cameraPath);
+			renderer.SetDebugView((DebugView)debugView);
+			Profiler::SetEnabled(profile != NULL || countersOn == true || allocationsOn == true);
+			Profiler::SetCountersEnabled(countersOn);
+			if (countersOn == true && Profiler::GetCountersEnabled() == false)
+				printf("Hardware counters unavailable, %s.\n", PerfCounters::GetUnsupportedReason());
+			AllocationTracker::SetSteadyStateCheckOn(assertNoAllocations);
+			if (captureFilename != NULL && renderer.StartCapture(captureFilename) == false)
+				fprintf(stderr, "Could not write %s.\n", captureFilename);
+
+			Presenter* presenter;
+			if (output != NULL)
+				presenter = new FilePresenter(output);
+			else
+				presenter = new NullPresenter();
+
+			// When pipelined each frame is drawn during the next one, and the last is
+			// drawn by the flush. Allocations are only those made inside the frames, not
+			// those made writing them out.
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			RenderStats totals;
+			AllocationCounts allocations;
+			allocations.Reset();
+			for (int frame = 0; frame < frameCount; frame++)
+			{
+				if (replayFilename == NULL)
+					renderer.RenderFrame(frame);
+				else if (replayFrame >= 0)
+					renderer.RenderCapturedFrame(replay.GetFrame(replayFrame));
+				else
+					renderer.RenderCapturedFrame(replay.GetFrame(frame % replay.GetFrameCount()));
+				allocations.Add(AllocationTracker::GetFrameCounts());
+				if (pipelineOn == true && frame == 0)
+					continue;
+				totals.Add(renderer.GetStats());
+				presenter->Present(renderer.GetFrame());
+			}
+			if (pipelineOn == true)
+			{
+				renderer.Flush();
+				allocations.Add(AllocationTracker::GetFrameCounts());
+				totals.Add(renderer.GetStats());
+				presenter->Present(renderer.GetFrame());
+			}
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			delete presenter;
+			renderer.StopCapture();
+
+			if (replayFilename != NULL)
+			{
+				printf("%d frames of %dx%d, replayed from %s", frameCount, width, height, replayFilename);
+				if (replayFrame >= 0)
+					printf(" frame %d", replayFrame);
+			}
+			else
+			{
+				printf("%d frames of %dx%d, %s, %s camera", frameCount, width, height,
+					   OfflineRenderer::GetDisplayModeName((DisplayMode)displayMode),
+					   OfflineRenderer::GetCameraPathName((CameraPath)cameraPath));
+			}
+			printf(", %d workers%s%s%s\n",
+				   jobSystem.GetWorkerCount(), pipelineOn ? ", pipelined" : "",
+				   debugView != DebugViewNone ? ", debug view " : "",
+				   debugView != DebugViewNone ? OfflineRenderer::GetDebugViewName((DebugView)debugView) : "");
+			printf("%.2f ms/frame, %.1f frames/s\n", elapsed.count() / frameCount, frameCount / (elapsed.count() / 1000.0));
+			printf("Triangles/frame: %u submitted, %u backface culled, %u frustum culled, %u clipped, %u zero area, %u rasterized\n",
+				   totals.trianglesSubmitted / frameCount, totals.trianglesBackfaceCulled / frameCount, totals.trianglesFrustumCulled / frameCount,
+				   totals.trianglesClipped / frameCount, totals.trianglesZeroArea / frameCount, totals.trianglesRasterized / frameCount);
+			printf("Pixels/frame: %llu tested, %llu shaded, %llu written, %llu texels fetched, %llu lights evaluated\n",
+				   totals.pixelsTested / frameCount, totals.pixelsShaded / frameCount, totals.pixelsWritten / frameCount,
+				   totals.texelsFetched / frameCount, totals.lightsEvaluated / frameCount);
+
+			// Stage times are summed across the workers, so they can add up to more than the frame.
+			if (Profiler::GetEnabled() == true)
+			{
+				printf("Average of the last %u frames, ms/frame across all threads:\n", Profiler::GetAverageFrameCount());
+				for (int i = 0; i < PROFILE_STAGE_COUNT; i++)
+					printf("  %-20s %8.3f\n", Profiler::GetStageName((ProfileStage)i), Profiler::GetStageAverage((ProfileStage)i));
+			}
+
+			// Counts are of every frame rendered, summed across the workers like the times.
+			if (Profiler::GetCountersEnabled() == true && Profiler::GetFrame() > 0)
+			{
+				unsigned int frames = Profiler::GetFrame();
+				printf("Hardware counters of all %u frames, thousands/frame across all threads:\n", frames);
+				printf("  %-20s %8s", "", "IPC");
+				for (int i = 0; i < PERF_COUNTER_COUNT; i++)
+				{
+					if (PerfCounters::GetCounterAvailable((PerfCounter)i) == true)
+						printf(" %12s", PerfCounters::GetCounterName((PerfCounter)i));
+				}
+				printf("\n");
+
+				for (int i = 0; i < PROFILE_STAGE_COUNT; i++)
+				{
+					PerfCounterValues counters;
+					counters.Reset();
+					Profiler::GetStageCounters((ProfileStage)i, counters);
+					printf("  %-20s %8.2f", Profiler::GetStageName((ProfileStage)i), counters.GetInstructionsPerCycle());
+					for (int j = 0; j < PERF_COUNTER_COUNT; j++)
+					{
+						if (PerfCounters::GetCounterAvailable((PerfCounter)j) == true)
+							printf(" %12.1f", counters.counts[j] / 1000.0 / frames);
+					}
+					printf("\n");
+				}
+			}
+
+			// Counts are of every frame rendered, including the flush of a pipelined render.
+			if (allocationsOn == true && AllocationTracker::GetFrame() > 0)
+			{
+				unsigned int frames = AllocationTracker::GetFrame();
+				unsigned int steadyFrames = (frames > ALLOCATION_WARMUP_FRAMES) ? frames - ALLOCATION_WARMUP_FRAMES : 0;
+				printf("Allocations/frame: %.1f allocations, %.1f frees, %.1f bytes, %u of the %u frames after the first %d allocated\n",
+					   (double)allocations.allocations / frames, (double)allocations.frees / frames, (double)allocations.bytes / frames,
+					   AllocationTracker::GetAllocatingFrameCount(), steadyFrames, ALLOCATION_WARMUP_FRAMES);
+				printf("Allocations of all %u frames, per frame across all threads:\n", frames);
+				for (int i = 0; i < PROFILE_STAGE_COUNT; i++)
+					printf("  %-20s %8.1f\n", Profiler::GetStageName((ProfileStage)i), (double)Profiler::GetStageAllocations((ProfileStage)i) / frames);
+			}
+
+			if (profile != NULL)
+			{
+				if (Profiler::WriteTrace(profile, traceFrames) == false)
+				{
+					fprintf(stderr, "Could not write %s.\n", profile);
+					result = 1;
+				}
+			}
+		}
+	}
+
+	Gdiplus::GdiplusShutdown(gdiToken);
+	return result;
+}
@@ -0,0 +1,177 @@
+// =========================================================================================
+//	GoldenImage.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#include "stdafx.h"
+#include "GoldenImage.h"
+
+// Constructor. Makes an empty image.
+GoldenImage::GoldenImage(void)
+{
+	_width = 0;
+	_height = 0;
+}
+
+// Destructor.
+GoldenImage::~GoldenImage(void)
+{
+}
+
+// Accessor methods.
+int GoldenImage::GetWidth() const
+{
+	return _width;
+}
+int GoldenImage::GetHeight() const
+{
+	return _height;
+}
+const BYTE* GoldenImage::GetPixel(int x, int y) const
+{
+	return &_pixels[((y * _width) + x) * 3];
+}
+
+// Resizes the image, its pixels are left black.
+void GoldenImage::Resize(int width, int height)
+{
+	_width = width;
+	_height = height;
+	_pixels.assign(width * height * 3, 0);
+}
+
+// Copies a rendered frame. Returns false if its bits could not be read.
+bool GoldenImage::CopyFrame(Gdiplus::Bitmap* frame)
+{
+	int width = (int)frame->GetWidth();
+	int height = (int)frame->GetHeight();
+	Gdiplus::Rect rect(0, 0, width, height);
+	Gdiplus::BitmapData bitmapData;
+	if (frame->LockBits(&rect, Gdiplus::ImageLockModeRead, PixelFormat32bppARGB, &bitmapData) != Gdiplus::Ok)
+		return false;
+
+	// Each pixel of the frame is stored as blue, green, red, alpha.
+	Resize(width, height);
+	for (int y = 0; y < height; y++)
+	{
+		BYTE* pixels = (BYTE*)bitmapData.Scan0 + (y * bitmapData.Stride);
+		BYTE* row = &_pixels[y * width * 3];
+		for (int x = 0; x < width; x++)
+		{
+			row[(x * 3) + 0] = pixels[(x * 4) + 2];
+			row[(x * 3) + 1] = pixels[(x * 4) + 1];
+			row[(x * 3) + 2] = pixels[(x * 4) + 0];
+		}
+	}
+
+	frame->UnlockBits(&bitmapData);
+	return true;
+}
+
+// Reads a binary PPM with 255 levels per channel. Returns false if the file could not be
+// read or is not one.
+bool GoldenImage::Load(const char* filename)
+{
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL)
+		return false;
+
+	int width, height, levels;
+	bool loaded = fscanf(file, "P6 %d %d %d", &width, &height, &levels) == 3 && width > 0 && height > 0 && levels == 255;
+	if (loaded == true)
+	{
+		// A single whitespace character separates the header from the pixels.
+		fgetc(file);
+		Resize(width, height);
+		loaded = fread(&_pixels[0], 1, _pixels.size(), file) == _pixels.size();
+	}
+
+	fclose(file);
+	return loaded;
+}
+
+// Writes the image as a binary PPM. Returns false if the file could not be written.
+bool GoldenImage::Save(const char* filename) const
+{
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+	if (_pixels.size() > 0)
+		fwrite(&_pixels[0], 1, _pixels.size(), file);
+
+	bool saved = (ferror(file) == 0);
+	fclose(file);
+	return saved;
+}
+
+// Compares the image to a reference. A pixel differs if any of its channels is further
+// from the reference than the tolerance.
+ImageComparison GoldenImage::Compare(const GoldenImage& reference, int tolerance) const
+{
+	ImageComparison comparison;
+	comparison.sizeMatches = (_width == reference._width && _height == reference._height);
+	comparison.differingPixels = 0;
+	comparison.changedPixels = 0;
+	comparison.maxDifference = 0;
+	if (comparison.sizeMatches == false)
+		return comparison;
+
+	for (int i = 0; i < _width * _height; i++)
+	{
+		int difference = 0;
+		for (int channel = 0; channel < 3; channel++)
+			difference = max(difference, abs((int)_pixels[(i * 3) + channel] - (int)reference._pixels[(i * 3) + channel]));
+
+		if (difference > 0)
+			comparison.changedPixels++;
+		if (difference > tolerance)
+			comparison.differingPixels++;
+		comparison.maxDifference = max(comparison.maxDifference, difference);
+	}
+	return comparison;
+}
+
+// Makes an image showing where the image differs from a reference. The reference is shown
+// dimmed in grey, pixels that changed within the tolerance are yellow and pixels that
+// differ are red, brighter the further they are off.
+void GoldenImage::MakeDiff(const GoldenImage& reference, int tolerance, GoldenImage& diff) const
+{
+	diff.Resize(reference._width, reference._height);
+	if (_width != reference._width || _height != reference._height)
+		return;
+
+	for (int i = 0; i < _width * _height; i++)
+	{
+		const BYTE* pixel = &_pixels[i * 3];
+		const BYTE* referencePixel = &reference._pixels[i * 3];
+		BYTE* diffPixel = &diff._pixels[i * 3];
+
+		int difference = 0;
+		for (int channel = 0; channel < 3; channel++)
+			difference = max(difference, abs((int)pixel[channel] - (int)referencePixel[channel]));
+
+		if (difference > tolerance)
+		{
+			diffPixel[0] = (BYTE)min(255, 128 + difference);
+			diffPixel[1] = 0;
+			diffPixel[2] = 0;
+		}
+		else if (difference > 0)
+		{
+			diffPixel[0] = 255;
+			diffPixel[1] = 255;
+			diffPixel[2] = 0;
+		}
+		else
+		{
+			BYTE grey = (BYTE)((((referencePixel[0] * 77) + (referencePixel[1] * 150) + (referencePixel[2] * 29)) >> 8) / 3);
+			diffPixel[0] = grey;
+			diffPixel[1] = grey;
+			diffPixel[2] = grey;
+		}
+	}
+}
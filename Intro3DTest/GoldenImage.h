@@ -0,0 +1,46 @@
+// =========================================================================================
+//	GoldenImage.h
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+#pragma once
+#include <vector>
+
+// Result of comparing a render against its reference image.
+struct ImageComparison
+{
+	bool sizeMatches;
+	unsigned int differingPixels;		// Pixels with a channel further off than the tolerance.
+	unsigned int changedPixels;			// Pixels that are not exactly the same, within tolerance or not.
+	int maxDifference;					// Largest difference of any channel of any pixel.
+};
+
+// This class holds an image as rows of red, green and blue bytes, read from a rendered
+// frame or from a binary PPM file. References are stored as PPMs so they can be read
+// back without an image library.
+class GoldenImage
+{
+	public:
+		GoldenImage(void);
+		~GoldenImage(void);
+
+		int GetWidth() const;
+		int GetHeight() const;
+		const BYTE* GetPixel(int x, int y) const;
+
+		bool CopyFrame(Gdiplus::Bitmap* frame);
+		bool Load(const char* filename);
+		bool Save(const char* filename) const;
+
+		ImageComparison Compare(const GoldenImage& reference, int tolerance) const;
+		void MakeDiff(const GoldenImage& reference, int tolerance, GoldenImage& diff) const;
+
+	private:
+		int _width;
+		int _height;
+		std::vector<BYTE> _pixels;
+
+		void Resize(int width, int height);
+};
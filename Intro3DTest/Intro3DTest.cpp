@@ -0,0 +1,488 @@
+// =========================================================================================
+//	Intro3DTest.cpp
+// =========================================================================================
+//	Written by Timothy Leonard
+//	For Introduction to 3D Graphics Programming (5CC068)
+// =========================================================================================
+
+// Renders a fixed set of scenes without a window and compares them against the reference
+// images stored with the source, so changes to the rasterizer or the models that change
+// what is drawn are caught. The references are rendered with the scalar reference path:
+// serially, with the full clear and without colormap shading. Every scene is also rendered
+// with each of the faster paths and compared against the same reference, so they are
+// checked against the plain one. Paths that only change how the work is done must match
+// it, the colormap kernel quantises the light so must match it within a tolerance of its
+// own. Images that do not match are written out with a diff image showing where they differ.
+//
+// The tests are built with the allocations counted, see AllocationTracker, and can instead
+// check that the renderer allocates nothing once it has rendered a few frames.
+
+#include "stdafx.h"
+#include "OfflineRenderer.h"
+#include "GoldenImage.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Size of the images rendered and compared.
+#define GOLDEN_WIDTH				160
+#define GOLDEN_HEIGHT				120
+
+// Defaults used when an option is not given. A pixel differs from its reference if any
+// channel is further off than the tolerance, and an image fails if more than the given
+// percentage of its pixels differ.
+#define GOLDEN_DEFAULT_DIRECTORY	"../Intro3DTest/Golden"
+#define GOLDEN_DEFAULT_TOLERANCE	2
+#define GOLDEN_DEFAULT_MAX_DIFFERING	0.0
+
+// Tolerance of the colormap kernel against the reference, as a channel tolerance and
+// the percentage of pixels that can be further off. The colormap quantises the light to
+// COLORMAP_LIGHT_LEVELS levels, so every pixel is within half a level, 3 channel levels.
+#define GOLDEN_COLORMAP_TOLERANCE		3
+#define GOLDEN_COLORMAP_MAX_DIFFERING	0.0
+
+// Number of workers the threaded configurations process the geometry on.
+#define GOLDEN_WORKERS				4
+
+// Frames of each display mode checked for allocations, after the first
+// ALLOCATION_WARMUP_FRAMES of the mode.
+#define GOLDEN_STEADY_STATE_FRAMES	20
+
+// Scenes that are rendered.
+enum GoldenScene
+{
+	GoldenSceneDemo,		// The demonstration character standing on the grass.
+	GoldenSceneCube,		// The cube on its own.
+	GoldenSceneTruck		// The truck on its own.
+};
+
+// Number of scenes in the enumeration above.
+#define GOLDEN_SCENE_COUNT			3
+
+static const char* GoldenSceneNames[] =
+{
+	"demo",
+	"cube",
+	"truck"
+};
+
+// Configurations every image is rendered with.
+enum GoldenConfiguration
+{
+	GoldenConfigurationReference,	// Scalar reference path, the references are rendered with it.
+	GoldenConfigurationFastClear,	// Only the parts of the frame nothing is drawn over are cleared.
+	GoldenConfigurationWorkers,		// Geometry processed on the job system.
+	GoldenConfigurationPipelined,	// Geometry processed on the job system while the last frame is drawn.
+	GoldenConfigurationColormap		// Textures shaded by colormap lookups.
+};
+
+// Number of configurations in the enumeration above.
+#define GOLDEN_CONFIGURATION_COUNT	5
+
+static const char* GoldenConfigurationNames[] =
+{
+	"reference",
+	"fastclear",
+	"workers",
+	"pipelined",
+	"colormap"
+};
+
+// How far the renders of a configuration can be from the reference. Configurations that
+// only change how the work is done use the tolerance given on the command line, the
+// colormap configuration quantises the shading so has its own.
+struct GoldenTolerance
+{
+	bool exact;
+	int tolerance;
+	double maxDiffering;
+};
+
+static const GoldenTolerance GoldenTolerances[] =
+{
+	{ true, 0, 0.0 },
+	{ true, 0, 0.0 },
+	{ true, 0, 0.0 },
+	{ true, 0, 0.0 },
+	{ false, GOLDEN_COLORMAP_TOLERANCE, GOLDEN_COLORMAP_MAX_DIFFERING }
+};
+
+// Camera path and the frame along it that an image is rendered from.
+struct GoldenView
+{
+	CameraPath path;
+	int frame;
+};
+
+static const GoldenView GoldenViews[] =
+{
+	{ CameraPathStatic, 0 },
+	{ CameraPathOrbit, 20 },
+	{ CameraPathDolly, 30 }
+};
+
+// A single image that is rendered and compared.
+struct GoldenCase
+{
+	GoldenScene scene;
+	DisplayMode mode;
+	GoldenView view;
+	std::string name;
+};
+
+// Options given on the command line.
+struct GoldenOptions
+{
+	std::string directory;
+	std::string diffDirectory;
+	std::string filter;
+	int tolerance;
+	double maxDiffering;
+	bool update;
+	bool allocations;
+};
+
+// Prints how the tests are run.
+static void PrintUsage()
+{
+	printf("Usage: Intro3DTest [options]\n");
+	printf("\n");
+	printf("  --golden <directory>        Where the reference images are, %s by default.\n", GOLDEN_DEFAULT_DIRECTORY);
+	printf("  --diff <directory>          Where renders that do not match are written with\n");
+	printf("                              their diff images, the current directory by default.\n");
+	printf("  --tolerance <levels>        How far a channel can be off before the pixel\n");
+	printf("                              differs, %d by default. Not used by the colormap\n", GOLDEN_DEFAULT_TOLERANCE);
+	printf("                              configuration.\n");
+	printf("  --max-differing <percent>   Percentage of pixels that can differ before an image\n");
+	printf("                              fails, %.1f by default. Not used by the colormap\n", GOLDEN_DEFAULT_MAX_DIFFERING);
+	printf("                              configuration.\n");
+	printf("  --filter <text>             Only renders the images whose names contain the text.\n");
+	printf("  --update                    Writes the reference renders as the new references.\n");
+	printf("  --allocations               Checks the allocations instead of comparing images.\n");
+	printf("                              Renders the demonstration scene along the dolly path\n");
+	printf("                              in every display mode and configuration, and\n");
+	printf("                              fails if any frame after the first %d of a mode allocates.\n", ALLOCATION_WARMUP_FRAMES);
+}
+
+// Builds the list of images rendered. The demonstration scene is rendered in every display
+// mode from every view, the other models in a few modes from the orbiting view.
+static void BuildCases(std::vector<GoldenCase>& cases)
+{
+	DisplayMode modelModes[] = { GouraudShadedDirectionalPointAmient, TexturedDirectionalAmbient, TexturedNormalMappedDirectionalPointAmbient };
+
+	for (int scene = 0; scene < GOLDEN_SCENE_COUNT; scene++)
+	{
+		for (int mode = 0; mode < DISPLAY_MODE_COUNT; mode++)
+		{
+			if (scene != GoldenSceneDemo && std::find(modelModes, modelModes + 3, (DisplayMode)mode) == modelModes + 3)
+				continue;
+
+			for (unsigned int view = 0; view < sizeof(GoldenViews) / sizeof(GoldenViews[0]); view++)
+			{
+				if (scene != GoldenSceneDemo && GoldenViews[view].path != CameraPathOrbit)
+					continue;
+
+				GoldenCase goldenCase;
+				goldenCase.scene = (GoldenScene)scene;
+				goldenCase.mode = (DisplayMode)mode;
+				goldenCase.view = GoldenViews[view];
+
+				char name[256];
+				sprintf(name, "%s_%s_%s%d", GoldenSceneNames[scene], OfflineRenderer::GetDisplayModeName((DisplayMode)mode),
+						OfflineRenderer::GetCameraPathName(GoldenViews[view].path), GoldenViews[view].frame);
+				goldenCase.name = name;
+				cases.push_back(goldenCase);
+			}
+		}
+	}
+}
+
+// Places the models and lights of a scene in the renderer. The cube and the truck are
+// placed in front of the camera where it is along the orbit when they are rendered.
+// Returns false if the models could not be loaded.
+static bool LoadScene(OfflineRenderer& renderer, GoldenScene scene)
+{
+	int model;
+	switch (scene)
+	{
+	case GoldenSceneDemo:
+		if (renderer.LoadDemoModels() == false)
+			return false;
+		break;
+	case GoldenSceneCube:
+		model = renderer.LoadModel("cube.md2", "cube.pcx", "cube_nm.pcx");
+		if (model < 0)
+			return false;
+		renderer.AddInstance(model, Vector3D(-42, 45, -27), 0.08f);
+		break;
+	case GoldenSceneTruck:
+		model = renderer.LoadModel("loadtruckb.md2", "loadtruckb.pcx", "loadtruckb_nm.pcx");
+		if (model < 0)
+			return false;
+		renderer.AddInstance(model, Vector3D(42, -40, 27), 0.08f);
+		break;
+	default:
+		return false;
+	}
+
+	renderer.AddDemoLights();
+	return true;
+}
+
+// Sets a renderer up to render with the given configuration. Every configuration starts
+// from the reference path and turns on one thing, the ones after the fast clear keep it
+// on as the default does.
+static void SetConfiguration(OfflineRenderer& renderer, GoldenConfiguration configuration, JobSystem& jobSystem)
+{
+	renderer.GetRasterizer()->SetFastClearOn(configuration != GoldenConfigurationReference);
+	renderer.SetColormapOn(configuration == GoldenConfigurationColormap);
+	if (configuration == GoldenConfigurationWorkers || configuration == GoldenConfigurationPipelined)
+		renderer.SetJobSystem(&jobSystem);
+	renderer.SetPipelineOn(configuration == GoldenConfigurationPipelined);
+}
+
+// Renders the demonstration scene animated in every display mode and configuration, and
+// counts the frames after the first ALLOCATION_WARMUP_FRAMES of each mode that allocate.
+// Returns the number of those frames, or -1 if the scene could not be loaded.
+static int CheckSteadyStateAllocations(JobSystem& jobSystem)
+{
+	int allocatingFrames = 0;
+	for (int i = 0; i < GOLDEN_CONFIGURATION_COUNT; i++)
+	{
+		OfflineRenderer renderer(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+		if (LoadScene(renderer, GoldenSceneDemo) == false)
+		{
+			fprintf(stderr, "Could not load the %s scene.\n", GoldenSceneNames[GoldenSceneDemo]);
+			return -1;
+		}
+		SetConfiguration(renderer, (GoldenConfiguration)i, jobSystem);
+		renderer.SetCameraPath(CameraPathDolly);
+
+		for (int mode = 0; mode < DISPLAY_MODE_COUNT; mode++)
+		{
+			renderer.SetDisplayMode((DisplayMode)mode);
+			for (int frame = 0; frame < ALLOCATION_WARMUP_FRAMES + GOLDEN_STEADY_STATE_FRAMES; frame++)
+			{
+				renderer.RenderFrame(frame);
+				const AllocationCounts& counts = AllocationTracker::GetFrameCounts();
+				if (frame < ALLOCATION_WARMUP_FRAMES || counts.allocations == 0)
+					continue;
+
+				printf("FAIL allocations_%s_%s frame %d: %llu allocations, %llu bytes\n", OfflineRenderer::GetDisplayModeName((DisplayMode)mode),
+					   GoldenConfigurationNames[i], frame, counts.allocations, counts.bytes);
+				allocatingFrames++;
+			}
+		}
+	}
+	return allocatingFrames;
+}
+
+// Renders the frame of a case into the renderers framebuffer.
+static void RenderCase(OfflineRenderer& renderer, const GoldenCase& goldenCase)
+{
+	renderer.SetDisplayMode(goldenCase.mode);
+	renderer.SetCameraPath(goldenCase.view.path);
+	renderer.RenderFrame(goldenCase.view.frame);
+
+	// Pipelined, the frame is only drawn when it is flushed.
+	if (renderer.GetPipelineOn() == true)
+		renderer.Flush();
+}
+
+// Writes a render that did not match and the diff image showing where, returns the path
+// of the diff image.
+static std::string WriteFailure(const GoldenOptions& options, const std::string& name, const GoldenImage& image, const GoldenImage& reference, int tolerance)
+{
+	std::string path = options.diffDirectory + "/" + name;
+	image.Save((path + ".ppm").c_str());
+
+	if (reference.GetWidth() == 0)
+		return path + ".ppm";
+
+	GoldenImage diff;
+	image.MakeDiff(reference, tolerance, diff);
+	diff.Save((path + "_diff.ppm").c_str());
+	return path + "_diff.ppm";
+}
+
+// Entry point.
+int main(int argc, char* argv[])
+{
+	GoldenOptions options;
+	options.directory = GOLDEN_DEFAULT_DIRECTORY;
+	options.diffDirectory = ".";
+	options.tolerance = GOLDEN_DEFAULT_TOLERANCE;
+	options.maxDiffering = GOLDEN_DEFAULT_MAX_DIFFERING;
+	options.update = false;
+	options.allocations = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* option = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (strcmp(option, "--update") == 0)
+			options.update = true;
+		else if (strcmp(option, "--allocations") == 0)
+			options.allocations = true;
+		else if (strcmp(option, "--golden") == 0 && value != NULL)
+			options.directory = argv[++i];
+		else if (strcmp(option, "--diff") == 0 && value != NULL)
+			options.diffDirectory = argv[++i];
+		else if (strcmp(option, "--filter") == 0 && value != NULL)
+			options.filter = argv[++i];
+		else if (strcmp(option, "--tolerance") == 0 && value != NULL)
+			options.tolerance = atoi(argv[++i]);
+		else if (strcmp(option, "--max-differing") == 0 && value != NULL)
+			options.maxDiffering = atof(argv[++i]);
+		else
+		{
+			PrintUsage();
+			return strcmp(option, "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	std::vector<GoldenCase> cases;
+	BuildCases(cases);
+
+	Gdiplus::GdiplusStartupInput gdiStartupInput;
+	ULONG_PTR gdiToken;
+	Gdiplus::GdiplusStartup(&gdiToken, &gdiStartupInput, NULL);
+
+	// Checking the allocations is run on its own, the images are not rendered.
+	if (options.allocations == true)
+	{
+		int allocatingFrames;
+		{
+			JobSystem jobSystem(GOLDEN_WORKERS);
+			allocatingFrames = CheckSteadyStateAllocations(jobSystem);
+		}
+		Gdiplus::GdiplusShutdown(gdiToken);
+
+		if (allocatingFrames < 0)
+			return 1;
+		printf("%d display modes in %d configurations, %d frames after the first %d of each mode, %d allocated\n",
+			   DISPLAY_MODE_COUNT, GOLDEN_CONFIGURATION_COUNT, GOLDEN_STEADY_STATE_FRAMES, ALLOCATION_WARMUP_FRAMES, allocatingFrames);
+		return allocatingFrames > 0 ? 1 : 0;
+	}
+
+	int rendered = 0;
+	int failed = 0;
+	int changed = 0;
+	int updated = 0;
+	{
+		JobSystem jobSystem(GOLDEN_WORKERS);
+
+		for (int scene = 0; scene < GOLDEN_SCENE_COUNT && failed >= 0; scene++)
+		{
+			// Each configuration renders the scene with its own renderer.
+			OfflineRenderer* renderers[GOLDEN_CONFIGURATION_COUNT];
+			for (int i = 0; i < GOLDEN_CONFIGURATION_COUNT; i++)
+				renderers[i] = NULL;
+
+			for (unsigned int i = 0; i < cases.size(); i++)
+			{
+				const GoldenCase& goldenCase = cases[i];
+				if (goldenCase.scene != scene)
+					continue;
+				if (options.filter.empty() == false && goldenCase.name.find(options.filter) == std::string::npos)
+					continue;
+
+				if (renderers[0] == NULL)
+				{
+					for (int j = 0; j < GOLDEN_CONFIGURATION_COUNT; j++)
+					{
+						renderers[j] = new OfflineRenderer(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+						if (LoadScene(*renderers[j], (GoldenScene)scene) == false)
+						{
+							fprintf(stderr, "Could not load the %s scene.\n", GoldenSceneNames[scene]);
+							failed = -1;
+							break;
+						}
+					}
+					if (failed < 0)
+						break;
+
+					for (int j = 0; j < GOLDEN_CONFIGURATION_COUNT; j++)
+						SetConfiguration(*renderers[j], (GoldenConfiguration)j, jobSystem);
+				}
+
+				std::string referencePath = options.directory + "/" + goldenCase.name + ".ppm";
+				GoldenImage reference;
+				bool referenceLoaded = reference.Load(referencePath.c_str());
+
+				for (int j = 0; j < GOLDEN_CONFIGURATION_COUNT; j++)
+				{
+					RenderCase(*renderers[j], goldenCase);
+					GoldenImage image;
+					image.CopyFrame(renderers[j]->GetFrame());
+					rendered++;
+
+					// The reference render becomes the reference the others are compared to.
+					if (options.update == true && j == GoldenConfigurationReference)
+					{
+						if (image.Save(referencePath.c_str()) == false)
+						{
+							fprintf(stderr, "Could not write %s.\n", referencePath.c_str());
+							failed++;
+							continue;
+						}
+						reference = image;
+						referenceLoaded = true;
+						updated++;
+					}
+
+					std::string name = goldenCase.name + "_" + GoldenConfigurationNames[j];
+					if (referenceLoaded == false)
+					{
+						printf("FAIL %s: no reference image %s, run with --update to make it\n", name.c_str(), referencePath.c_str());
+						WriteFailure(options, name, image, GoldenImage(), options.tolerance);
+						failed++;
+						continue;
+					}
+
+					const GoldenTolerance& configurationTolerance = GoldenTolerances[j];
+					int tolerance = configurationTolerance.exact ? options.tolerance : configurationTolerance.tolerance;
+					double maxDiffering = configurationTolerance.exact ? options.maxDiffering : configurationTolerance.maxDiffering;
+
+					ImageComparison comparison = image.Compare(reference, tolerance);
+					double differingPercent = 100.0 * comparison.differingPixels / (GOLDEN_WIDTH * GOLDEN_HEIGHT);
+					if (comparison.sizeMatches == false)
+					{
+						printf("FAIL %s: image is %dx%d, the reference is %dx%d\n", name.c_str(),
+							   image.GetWidth(), image.GetHeight(), reference.GetWidth(), reference.GetHeight());
+						failed++;
+					}
+					else if (comparison.differingPixels > 0 && differingPercent > maxDiffering)
+					{
+						std::string diffPath = WriteFailure(options, name, image, reference, tolerance);
+						printf("FAIL %s: %u pixels differ (%.2f%%), %u changed, max difference %d, diff written to %s\n", name.c_str(),
+							   comparison.differingPixels, differingPercent, comparison.changedPixels, comparison.maxDifference, diffPath.c_str());
+						failed++;
+					}
+					else if (comparison.changedPixels > 0)
+					{
+						printf("ok   %s: %u pixels changed within tolerance, max difference %d\n", name.c_str(),
+							   comparison.changedPixels, comparison.maxDifference);
+						changed++;
+					}
+				}
+			}
+
+			for (int i = 0; i < GOLDEN_CONFIGURATION_COUNT; i++)
+				delete renderers[i];
+		}
+	}
+
+	Gdiplus::GdiplusShutdown(gdiToken);
+
+	if (failed < 0)
+		return 1;
+
+	printf("%d renders of %d images in %d configurations, %d failed, %d changed within tolerance",
+		   rendered, rendered / GOLDEN_CONFIGURATION_COUNT, GOLDEN_CONFIGURATION_COUNT, failed, changed);
+	if (options.update == true)
+		printf(", %d references written", updated);
+	printf("\n");
+	return failed > 0 ? 1 : 0;
+}